@@ -1,5 +1,7 @@
 #include "App.h"
+#include <GangerEngine/ResourceManager.h>
 #include <GangerEngine/ScreenList.h>
+#include <cstdio>
 
 
 App::App() {
@@ -11,7 +13,8 @@ App::~App() {
 }
 
 void App::OnInit() {
-
+    // Unreferenced textures beyond this are dropped between screens
+    GangerEngine::ResourceManager::SetTextureMemoryBudget(64 * 1024 * 1024);
 }
 
 void App::AddScreens() {
@@ -29,3 +32,14 @@ void App::AddScreens() {
 void App::OnExit() {
 
 }
+
+void App::Update() {
+    GangerEngine::IMainGame::Update();
+
+    if (m_currentScreen != m_lastScreen) {
+        // The textures only the old screen used are gone by now
+        GangerEngine::TextureCacheStats stats = GangerEngine::ResourceManager::GetTextureStats();
+        printf("Resident textures: %d, %zu KB\n", stats.numResident, stats.residentBytes / 1024);
+        m_lastScreen = m_currentScreen;
+    }
+}
@@ -17,7 +17,11 @@ public:
     virtual void AddScreens() override;
     // Called when exiting
     virtual void OnExit() override;
+protected:
+    // Logs the resident textures after every screen change
+    virtual void Update() override;
 private:
+    GangerEngine::IGameScreen* m_lastScreen = nullptr;
     std::unique_ptr<GameplayScreen> m_gameplayScreen = nullptr;
     std::unique_ptr<MainMenuScreen> m_mainMenuScreen = nullptr;
     std::unique_ptr<EditorScreen> m_editorScreen = nullptr;
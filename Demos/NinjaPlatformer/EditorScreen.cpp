@@ -82,6 +82,8 @@ void EditorScreen::OnEntry() {
 }
 
 void EditorScreen::OnExit() {
+    // Its callback uses the widgets
+    waitForSave();
 
     for (auto& item : m_saveListBoxItems) {
         // We don't have to call delete since removeItem does it for us
@@ -642,13 +644,18 @@ void EditorScreen::checkInput() {
     }
 }
 
+bool isTempFile(const std::string& path) {
+    // Saves in progress are written to a .tmp file first
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".tmp") == 0;
+}
+
 bool inLightSelect(const Light& l, const glm::vec2& pos) {
     return (glm::length(pos - l.position) <= LIGHT_SELECT_RADIUS);
 }
 
 void EditorScreen::updateMouseDown(const SDL_Event& evnt) {
     // Texture for boxes. Its here because lazy.
-    static GangerEngine::GLTexture texture = GangerEngine::ResourceManager::GetTexture("Assets/bricks_top.png");
+    GangerEngine::GLTexture texture = GangerEngine::ResourceManager::GetTexture("Assets/bricks_top.png");
     glm::vec2 pos;
     glm::vec4 uvRect;
 
@@ -831,7 +838,7 @@ void EditorScreen::refreshSelectedBox() {
 void EditorScreen::refreshSelectedBox(const glm::vec2& newPosition) {
     if (m_selectedBox == NO_BOX) return;
     // Texture for boxes. Its here because lazy.
-    static GangerEngine::GLTexture texture = GangerEngine::ResourceManager::GetTexture("Assets/bricks_top.png");
+    GangerEngine::GLTexture texture = GangerEngine::ResourceManager::GetTexture("Assets/bricks_top.png");
     glm::vec4 uvRect;
     uvRect.x = newPosition.x;
     uvRect.y = newPosition.y;
@@ -982,6 +989,8 @@ bool EditorScreen::onPlaceMouseClick(const CEGUI::EventArgs& e) {
 bool EditorScreen::onSaveMouseClick(const CEGUI::EventArgs& e) {
     // Make sure levels dir exists
     GangerEngine::IOManager::MakeDirectory("Levels");
+    waitForSave();
+    m_saveWindow->setText("Save Level");
     
     m_saveWindowCombobox->clearAllSelections();
 
@@ -1000,7 +1009,7 @@ bool EditorScreen::onSaveMouseClick(const CEGUI::EventArgs& e) {
     // Add all files to list box
     for (auto& e : entries) {
         // Don't add directories
-        if (!e.isDirectory) {
+        if (!e.isDirectory && !isTempFile(e.path)) {
             // Remove "Levels/" substring
             e.path.erase(0, std::string("Levels/").size());
             m_saveListBoxItems.push_back(new CEGUI::ListboxTextItem(e.path));
@@ -1016,6 +1025,7 @@ bool EditorScreen::onSaveMouseClick(const CEGUI::EventArgs& e) {
 }
 
 bool EditorScreen::onLoadMouseClick(const CEGUI::EventArgs& e) {
+    waitForSave();
 
     m_loadWindowCombobox->clearAllSelections();
 
@@ -1034,7 +1044,7 @@ bool EditorScreen::onLoadMouseClick(const CEGUI::EventArgs& e) {
     // Add all files to list box
     for (auto& e : entries) {
         // Don't add directories
-        if (!e.isDirectory) {
+        if (!e.isDirectory && !isTempFile(e.path)) {
             // Remove "Levels/" substring
             e.path.erase(0, std::string("Levels/").size());
             m_loadListBoxItems.push_back(new CEGUI::ListboxTextItem(e.path));
@@ -1094,6 +1104,10 @@ bool EditorScreen::onSave(const CEGUI::EventArgs& e) {
         puts("Must create player before saving.");
         return true;
     }
+    if (m_saveRequest != 0) {
+        puts("Still saving.");
+        return true;
+    }
 
     puts("Saving game...");
     // Make sure levels dir exists again, for good measure.
@@ -1101,10 +1115,12 @@ bool EditorScreen::onSave(const CEGUI::EventArgs& e) {
 
     // Save in text mode
     std::string text = "Levels/" + std::string(m_saveWindowCombobox->getText().c_str());
-    if (LevelReaderWriter::saveAsText(text, m_player, m_boxes, m_lights)) {
-        m_saveWindow->disable();
-        m_saveWindow->setAlpha(0.0f);
-        puts("File successfully saved.");
+    m_saveRequest = LevelReaderWriter::saveAsText(text, m_player, m_boxes, m_lights,
+                                                  [this](bool isSaved) { onSaveDone(isSaved); });
+    if (m_saveRequest != 0) {
+        // The window stays open until the file is on disk
+        m_saveWindowSaveButton->disable();
+        m_saveWindow->setText("Saving...");
     } else {
         puts("Failed to save file.");
     }
@@ -1112,6 +1128,27 @@ bool EditorScreen::onSave(const CEGUI::EventArgs& e) {
     return true;
 }
 
+void EditorScreen::waitForSave() {
+    if (m_saveRequest == 0) return;
+    GangerEngine::IOManager::WaitForAsync(m_saveRequest);
+    // Runs onSaveDone
+    GangerEngine::IOManager::ProcessAsyncCompletions();
+}
+
+void EditorScreen::onSaveDone(bool isSaved) {
+    m_saveRequest = 0;
+    m_saveWindowSaveButton->enable();
+    if (isSaved) {
+        m_saveWindow->setText("Save Level");
+        m_saveWindow->disable();
+        m_saveWindow->setAlpha(0.0f);
+    } else {
+        // Left open to try again
+        puts("Failed to save file.");
+        m_saveWindow->setText("Save Level - Failed, try again");
+    }
+}
+
 bool EditorScreen::onLoadCancelClick(const CEGUI::EventArgs& e) {
     m_loadWindow->disable();
     m_loadWindow->setAlpha(0.0f);
@@ -3,6 +3,7 @@
 #include "Box.h"
 #include "Light.h"
 #include "Player.h"
+#include <GangerEngine/AsyncIO.h>
 #include <GangerEngine/Camera2D.h>
 #include <GangerEngine/DebugRenderer.h>
 #include <GangerEngine/GLSLProgram.h>
@@ -97,6 +98,10 @@ private:
     void setPlatformWidgetVisibility(bool visible);
     void setLightWidgetVisibility(bool visible);
 
+    // Lets a background save land before the level files are listed
+    void waitForSave();
+    void onSaveDone(bool isSaved);
+
     /************************************************************************/
     /* Event Handlers                                                       */
     /************************************************************************/
@@ -185,6 +190,7 @@ private:
     GangerEngine::InputManager m_inputManager;
 
     bool m_hasPlayer = false;
+    GangerEngine::IORequestId m_saveRequest = 0; ///< The save being written, 0 if none
     Player m_player;
     std::vector<Box> m_boxes;
     std::vector<Light> m_lights;
@@ -37,13 +37,14 @@ void GameplayScreen::OnEntry() {
     m_world = std::make_unique<b2World>(gravity);
 
     m_debugRenderer.Init();
+    m_box2dDebugDraw.Init(&m_debugRenderer);
 
     // Load the texture
-    m_texture = GangerEngine::ResourceManager::GetTexture("Assets/bricks_top.png");
+    m_texture = GangerEngine::ResourceManager::AcquireTexture("Assets/bricks_top.png");
 
     // Make the ground
     Box groundBox;
-    groundBox.init(m_world.get(), glm::vec2(0.0f, -20.0f), glm::vec2(50.0f, 10.0f), m_texture, GangerEngine::ColorRGBA8(255, 255, 255, 255), false, false);
+    groundBox.init(m_world.get(), glm::vec2(0.0f, -20.0f), glm::vec2(50.0f, 10.0f), m_texture.GetTexture(), GangerEngine::ColorRGBA8(255, 255, 255, 255), false, false);
     m_boxes.push_back(groundBox);
 
     // Make a bunch of boxes
@@ -61,7 +62,7 @@ void GameplayScreen::OnEntry() {
         randColor.b = color(randGenerator);
         randColor.a = 255;
         Box newBox;
-        newBox.init(m_world.get(), glm::vec2(xPos(randGenerator), yPos(randGenerator)), glm::vec2(size(randGenerator), size(randGenerator)), m_texture, randColor, false, true);
+        newBox.init(m_world.get(), glm::vec2(xPos(randGenerator), yPos(randGenerator)), glm::vec2(size(randGenerator), size(randGenerator)), m_texture.GetTexture(), randColor, false, true);
         m_boxes.push_back(newBox);
     }
 
@@ -100,6 +101,8 @@ void GameplayScreen::OnExit() {
     m_debugRenderer.Dispose();
     m_boxes.clear();
     m_world.reset();
+    // Let the cache evict it if another screen needs the memory
+    m_texture.Reset();
 }
 
 void GameplayScreen::Update() {
@@ -141,16 +144,9 @@ void GameplayScreen::Draw() {
 
     // Debug rendering
     if(m_renderDebug) {
-        glm::vec4 destRect;
-        for (auto& b : m_boxes) {       
-            destRect.x = b.getBody()->GetPosition().x - b.getDimensions().x / 2.0f;
-            destRect.y = b.getBody()->GetPosition().y - b.getDimensions().y / 2.0f;
-            destRect.z = b.getDimensions().x;
-            destRect.w = b.getDimensions().y;
-            m_debugRenderer.DrawBox(destRect, GangerEngine::ColorRGBA8(255, 255, 255, 255), b.getBody()->GetAngle());
-        }
-        m_player.drawDebug(m_debugRenderer);
-        // Render player
+        m_debugRenderer.SetViewScale(m_camera.GetScale());
+        // Draws the boxes and the player in one pass
+        m_box2dDebugDraw.DrawWorld(m_world.get());
         m_debugRenderer.End();
         m_debugRenderer.Render(projectionMatrix, 2.0f);
     }
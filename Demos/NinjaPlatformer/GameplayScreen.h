@@ -8,9 +8,10 @@
 #include <GangerEngine/SpriteBatch.h>
 #include <GangerEngine/GLSLProgram.h>
 #include <GangerEngine/Camera2D.h>
-#include <GangerEngine/GLTexture.h>
+#include <GangerEngine/TextureHandle.h>
 #include <GangerEngine/Window.h>
 #include <GangerEngine/DebugRenderer.h>
+#include <GangerEngine/Box2DDebugDraw.h>
 
 #include <GangerEngine/GUI.h>
 
@@ -46,9 +47,10 @@ private:
     GangerEngine::GLSLProgram m_textureProgram;
     GangerEngine::GLSLProgram m_lightProgram;
     GangerEngine::Camera2D m_camera;
-    GangerEngine::GLTexture m_texture;
+    GangerEngine::TextureHandle m_texture;
     GangerEngine::Window* m_window;
     GangerEngine::DebugRenderer m_debugRenderer;
+    GangerEngine::Box2DDebugDraw m_box2dDebugDraw;
     GangerEngine::GUI m_gui;
 
     bool m_renderDebug = false;
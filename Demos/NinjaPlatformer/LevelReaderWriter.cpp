@@ -1,7 +1,12 @@
 #include "LevelReaderWriter.h"
 
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
+#include <GangerEngine/MemoryStream.h>
 #include <GangerEngine/ResourceManager.h>
-#include <fstream>
+#include <cstdio>
+#include <sstream>
+#include <utility>
 
 // When you want to make a new version, add it here
 const unsigned int TEXT_VERSION_0 = 100;
@@ -9,18 +14,14 @@ const unsigned int TEXT_VERSION_0 = 100;
 // Make sure this is set to the current version
 const unsigned int TEXT_VERSION = TEXT_VERSION_0;
 
-bool LevelReaderWriter::saveAsText(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights) {
+GangerEngine::IORequestId LevelReaderWriter::saveAsText(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights, SaveCallback onSaved /* = nullptr */) {
     // Keep this updated with newest version
-    return saveAsTextV0(filePath, player, boxes, lights);
+    return saveAsTextV0(filePath, player, boxes, lights, std::move(onSaved));
 }
 
-bool LevelReaderWriter::saveAsTextV0(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights) {
-    // Open file and error check
-    std::ofstream file(filePath);
-    if (file.fail()) {
-        perror(filePath.c_str());
-        return false;
-    }
+GangerEngine::IORequestId LevelReaderWriter::saveAsTextV0(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights, SaveCallback onSaved) {
+    // Built in memory and written in the background, the editor keeps going
+    std::ostringstream file;
 
     // Write version
     file << TEXT_VERSION << '\n';
@@ -54,7 +55,18 @@ bool LevelReaderWriter::saveAsTextV0(const std::string& filePath, const Player&
              << l.color.b << ' ' << l.color.a << '\n';
     }
 
-    return true;
+    std::string text = file.str();
+    return GangerEngine::IOManager::WriteFileAsync(filePath,
+        std::vector<unsigned char>(text.begin(), text.end()),
+        [onSaved](GangerEngine::IOResult& result) {
+            bool isSaved = result.status == GangerEngine::IOStatus::OK;
+            if (isSaved) {
+                printf("Saved %s.\n", result.filePath.c_str());
+            } else {
+                printf("Failed to save %s.\n", result.filePath.c_str());
+            }
+            if (onSaved) onSaved(isSaved);
+        }, GangerEngine::IOPriority::HIGH);
 }
 
 bool LevelReaderWriter::saveAsBinary(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights) {
@@ -63,12 +75,12 @@ bool LevelReaderWriter::saveAsBinary(const std::string& filePath, const Player&
 }
 
 bool LevelReaderWriter::loadAsText(const std::string& filePath, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights) {
-    // Open file and error check
-    std::ifstream file(filePath);
-    if (file.fail()) {
-        perror(filePath.c_str());
+    // Open file and error check, it is parsed straight from the mapping
+    GangerEngine::MappedFile mappedFile;
+    if (!GangerEngine::IOManager::MapFile(filePath, &mappedFile)) {
         return false;
     }
+    GangerEngine::MemoryStream file(mappedFile);
 
     // Get version
     unsigned int version;
@@ -92,7 +104,7 @@ bool LevelReaderWriter::loadAsBinary(const std::string& filePath, b2World* world
     return false;
 }
 
-bool LevelReaderWriter::loadAsTextV0(std::ifstream& file, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights) {
+bool LevelReaderWriter::loadAsTextV0(std::istream& file, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights) {
     { // Read player
         glm::vec2 pos;
         glm::vec2 ddims;
@@ -119,7 +131,7 @@ bool LevelReaderWriter::loadAsTextV0(std::ifstream& file, b2World* world, Player
                  >> uvRect.x >> uvRect.y >> uvRect.z >> uvRect.w
                  >> angle >> texturePath >> isDynamic >> fixedRotation;
 
-            texture = GangerEngine::ResourceManager::GetTexture(texturePath);
+            texture = GangerEngine::ResourceManager::GetTexture(GangerEngine::ResourceId(texturePath));
 
             boxes.emplace_back();
             boxes.back().init(world, pos, dims, texture, color, fixedRotation, isDynamic, angle, uvRect);
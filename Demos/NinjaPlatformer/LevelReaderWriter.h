@@ -1,5 +1,8 @@
 #pragma once
 
+#include <GangerEngine/AsyncIO.h>
+#include <functional>
+#include <istream>
 #include <string>
 
 #include "Player.h"
@@ -8,12 +11,16 @@
 
 class LevelReaderWriter {
 public:
-    static bool saveAsText(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
+    // Called once a save is on disk, or failed to get there
+    typedef std::function<void(bool isSaved)> SaveCallback;
+
+    // Writes in the background. Returns the write to wait for, 0 if it could not be queued
+    static GangerEngine::IORequestId saveAsText(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights, SaveCallback onSaved = nullptr);
     static bool saveAsBinary(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
     static bool loadAsText(const std::string& filePath, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
     static bool loadAsBinary(const std::string& filePath, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
 private:
-    static bool saveAsTextV0(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
-    static bool loadAsTextV0(std::ifstream& file, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
+    static GangerEngine::IORequestId saveAsTextV0(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights, SaveCallback onSaved);
+    static bool loadAsTextV0(std::istream& file, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
 };
 
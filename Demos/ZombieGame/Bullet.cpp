@@ -6,6 +6,8 @@
 #include "Zombie.h"
 #include "Level.h"
 
+static constexpr GangerEngine::ResourceId CIRCLE_TEXTURE("Textures/circle.png");
+
 Bullet::Bullet(glm::vec2 position, glm::vec2 direction, float damage, float speed) :
     _position(position),
     _direction(direction),
@@ -38,7 +40,7 @@ void Bullet::draw(GangerEngine::SpriteBatch& spriteBatch) {
     color.b = 75;
     color.a = 255;
 
-    spriteBatch.Draw(destRect, uvRect, GangerEngine::ResourceManager::GetTexture("Textures/circle.png").id, 0.0f, color);
+    spriteBatch.Draw(destRect, uvRect, GangerEngine::ResourceManager::GetTextureRef(CIRCLE_TEXTURE).id, 0.0f, color);
 }
 
 bool Bullet::collideWithAgent(Agent* agent) {
@@ -44,7 +44,7 @@ void Gun::fire(const glm::vec2& direction, const glm::vec2& position, std::vecto
                              glm::rotate(direction, randRotate(randomEngine)),
                              _bulletDamage, 
                              _bulletSpeed);
-        m_effect.Play();
+        m_effect.PlayAt(position);
     }   
 
 }
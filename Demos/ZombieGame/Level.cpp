@@ -1,19 +1,27 @@
 #include "Level.h"
 
 #include <GangerEngine/GangerErrors.h>
-#include <fstream>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
+#include <GangerEngine/MemoryStream.h>
 #include <iostream>
 #include <GangerEngine/ResourceManager.h>
 
+// Hashed at compile time, so the per tile lookups do not touch strings
+static constexpr GangerEngine::ResourceId RED_BRICKS_TEXTURE("Textures/red_bricks.png");
+static constexpr GangerEngine::ResourceId GLASS_TEXTURE("Textures/glass.png");
+static constexpr GangerEngine::ResourceId LIGHT_BRICKS_TEXTURE("Textures/light_bricks.png");
+
 Level::Level(const std::string& fileName) {
 
-    std::ifstream file;
-    file.open(fileName);
+    // Parsed straight from the mapping, without a copy of the file
+    GangerEngine::MappedFile mappedFile;
 
     // Error checking
-    if (file.fail()) {
+    if (!GangerEngine::IOManager::MapFile(fileName, &mappedFile)) {
         GangerEngine::FatalError("Failed to open " + fileName);
     }
+    GangerEngine::MemoryStream file(mappedFile);
 
     // Throw away the first string in tmp
     std::string tmp;
@@ -53,21 +61,21 @@ Level::Level(const std::string& fileName) {
                 case 'R':
                     _spriteBatch.Draw(destRect,
                                       uvRect,
-                                      GangerEngine::ResourceManager::GetTexture("Textures/red_bricks.png").id,
+                                      GangerEngine::ResourceManager::GetTextureRef(RED_BRICKS_TEXTURE).id,
                                       0.0f,
                                       whiteColor);      
                     break;
                 case 'G':
                     _spriteBatch.Draw(destRect,
                                       uvRect,
-                                      GangerEngine::ResourceManager::GetTexture("Textures/glass.png").id,
+                                      GangerEngine::ResourceManager::GetTextureRef(GLASS_TEXTURE).id,
                                       0.0f,
                                       whiteColor);
                     break;
                 case 'L':
                     _spriteBatch.Draw(destRect,
                                       uvRect,
-                                      GangerEngine::ResourceManager::GetTexture("Textures/light_bricks.png").id,
+                                      GangerEngine::ResourceManager::GetTextureRef(LIGHT_BRICKS_TEXTURE).id,
                                       0.0f,
                                       whiteColor);
                     break;
@@ -67,6 +67,10 @@ void MainGame::initSystems() {
     // Set up the shaders
     initShaders();
 
+    // Pack the tile and agent textures together so the level draws in
+    // a single batch
+    GangerEngine::ResourceManager::SetAtlasMode(true);
+
     // Initialize our spritebatch
     _agentSpriteBatch.Init();
     _hubSpriteBatch.Init();
@@ -82,9 +86,21 @@ void MainGame::initSystems() {
     m_bloodParticle->Init(1000, 0.05f,
                           GangerEngine::ResourceManager::GetTexture("Textures/particle.png"));
     m_particleEngine.AddParticleBatch(m_bloodParticle);
+    GangerEngine::ParticleEmitterDesc bloodDesc;
+    if (!GangerEngine::ParticleEmitter2D::LoadFromFile(
+        "Particles/blood.emitter", bloodDesc)) {
+        GangerEngine::FatalError("Failed to load blood emitter!");
+    }
+    m_bloodEmitter.Init(m_bloodParticle, bloodDesc, time(nullptr));
+    // Splats stay on the floor once the particles are done
+    m_bloodDecals.Init(TILE_WIDTH * 8.0f, 512);
+    m_bloodParticle->SetDecalLayer(&m_bloodDecals);
+    // Keep big firefights from eating the frame
+    m_particleEngine.SetBudget(1000, 2.0f);
 
     // Set up the camera
     _camera.Init(_screenWidth, _screenHeight);
+    m_particleEngine.SetCamera(&_camera);
     
     // Set up the hub camera
     _hubCamera.Init(_screenWidth, _screenHeight);
@@ -100,6 +116,20 @@ void MainGame::initLevel() {
     _levels.push_back(new Level("Levels/level1.txt"));
     _currentLevel = 0;
 
+    // Let the blood splat against the walls
+    const std::vector<std::string>& levelData = _levels[_currentLevel]->getLevelData();
+    m_levelTiles.Init(glm::vec2(0.0f), TILE_WIDTH, _levels[_currentLevel]->getWidth(),
+                      _levels[_currentLevel]->getHeight());
+    for (int y = 0; y < levelData.size(); y++) {
+        for (int x = 0; x < levelData[y].size(); x++) {
+            m_levelTiles.SetSolid(x, y, levelData[y][x] != '.');
+        }
+    }
+    GangerEngine::ParticleCollision2D bloodCollision;
+    bloodCollision.tiles = &m_levelTiles;
+    bloodCollision.response = GangerEngine::ParticleCollisionResponse::KILL;
+    m_bloodParticle->SetCollision(bloodCollision);
+
     _player = new Player();
     _player->init(PLAYER_SPEED, _levels[_currentLevel]->getStartPlayerPos(), &_inputManager,
                   &_camera, &_bullets);
@@ -205,6 +235,9 @@ void MainGame::gameLoop() {
         
         _hubCamera.Update();
 
+        m_audioEngine.SetListener(position);
+        m_audioEngine.Update();
+
         drawGame();
 
         _fps = fpsLimiter.End();
@@ -408,6 +441,11 @@ void MainGame::drawGame() {
     // Draw the level
     _levels[_currentLevel]->draw();
 
+    // Draw the baked blood on top of the floor
+    _textureProgram.Unuse();
+    m_bloodDecals.Render(projectionMatrix, &_camera);
+    _textureProgram.Use();
+
     // Begin drawing agents
     _agentSpriteBatch.Begin();
 
@@ -476,13 +514,6 @@ void MainGame::DrawHub()
 
 void MainGame::AddBlood(const glm::vec2& position, int numParticles)
 {
-    static std::mt19937 randEngine(time(nullptr));
-    static std::uniform_real_distribution<float> randAngle(0.0f, 360.0f);
-
-    glm::vec2 velocity(2.0f, 0.0f);
-    GangerEngine::ColorRGBA8 color(255, 0, 0, 255);
-
-    for(int i = 0; i < numParticles; i++)
-        m_bloodParticle->AddParticle(position, glm::rotate(velocity, randAngle(randEngine)), color,
-                                     30.0f);
-}
\ No newline at end of file
+    m_bloodEmitter.SetPosition(position);
+    m_bloodEmitter.Emit(numParticles);
+}
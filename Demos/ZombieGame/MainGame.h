@@ -9,6 +9,8 @@
 #include <GangerEngine/AudioEngine.h>
 #include <GangerEngine/ParticleEngine2D.h>
 #include <GangerEngine/particleBatch2d.h>
+#include <GangerEngine/ParticleEmitter2D.h>
+#include <GangerEngine/DecalLayer2D.h>
 
 #include "Player.h"
 #include "Level.h"
@@ -102,6 +104,9 @@ private:
 
     GangerEngine::ParticleEngine2D m_particleEngine;
     GangerEngine::ParticleBatch2D* m_bloodParticle;
+    GangerEngine::ParticleEmitter2D m_bloodEmitter;
+    GangerEngine::DecalLayer2D m_bloodDecals;
+    GangerEngine::TileOccupancyGrid m_levelTiles;
 
     GameState _gameState;
 };
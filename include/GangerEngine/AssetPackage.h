@@ -0,0 +1,150 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _ASSETPACKAGE_H_
+#define _ASSETPACKAGE_H_
+
+#include <GangerEngine/MappedFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GangerEngine {
+/// What an entry holds.
+enum class AssetType : uint32_t {
+    RAW = 0,  ///< The source bytes: shaders, levels, fonts...
+    TEXTURE = 1  ///< Texels, top row first, with its mip chain after
+};
+
+const uint32_t ASSET_FLAG_COMPRESSED = 1 << 0;  ///< CompressLZ payload
+const uint32_t ASSET_FLAG_MIPS = 1 << 1;  ///< numMips levels are stored
+/// Texture levels stored as BC1 or BC3 blocks instead of RGBA8 texels
+const uint32_t ASSET_FLAG_BC1 = 1 << 2;
+const uint32_t ASSET_FLAG_BC3 = 1 << 3;
+
+const char PACKAGE_MAGIC[4] = { 'G', 'P', 'A', 'K' };
+const uint32_t PACKAGE_VERSION = 1;
+/// Every payload starts on this boundary of the file.
+const uint64_t PACKAGE_ALIGNMENT = 64;
+
+/// The file starts with the header, then the entries sorted by path hash,
+/// the string table with the null terminated paths and last the payloads.
+/// All the fields are little endian.
+struct PackageHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t stringTableSize;
+};
+
+struct PackageEntry {
+    uint64_t pathHash;  ///< HashFNV1a of the normalized path
+    uint64_t offset;  ///< From the start of the file
+    uint64_t size;  ///< Stored bytes
+    uint64_t rawSize;  ///< Bytes once decompressed
+    uint32_t type;  ///< An AssetType
+    uint32_t flags;
+    uint32_t width;  ///< Textures only
+    uint32_t height;  ///< Textures only
+    uint32_t numMips;  ///< Textures only, 1 without a chain
+    uint32_t pathOffset;  ///< Into the string table
+};
+
+static_assert(sizeof(PackageHeader) == 16, "PackageHeader must be packed");
+static_assert(sizeof(PackageEntry) == 56, "PackageEntry must be packed");
+
+/// A read only package made by the AssetCooker tool. The file is memory
+/// mapped, so payloads are used straight from the page cache.
+class AssetPackage {
+ public:
+    AssetPackage();
+    ~AssetPackage();
+
+    /**
+     * \brief      Maps a package and validates its table of contents.
+     *
+     * \param[in]  filePath  The file path
+     *
+     * \return     False if it could not be mapped or is not a package.
+     */
+    bool Open(const std::string& filePath);
+
+    /// Unmaps the package.
+    void Close();
+
+    /**
+     * \brief      Looks up an entry.
+     *
+     * \param[in]  path  The asset path, as the game asks for it
+     *
+     * \return     The entry or nullptr.
+     */
+    const PackageEntry* Find(const std::string& path) const;
+
+    /// Gets the stored bytes of an entry, they live as long as the package.
+    const unsigned char* GetPayload(const PackageEntry& entry) const {
+        return m_data + entry.offset;
+    }
+
+    /// Gets the path of an entry.
+    const char* GetPath(const PackageEntry& entry) const {
+        return m_strings + entry.pathOffset;
+    }
+
+    /**
+     * \brief      Copies an entry, decompressing it if needed.
+     *
+     * \param[in]  entry   The entry
+     * \param      buffer  The raw bytes
+     *
+     * \return     False if the payload is corrupt.
+     */
+    bool Read(const PackageEntry& entry,
+        std::vector<unsigned char>& buffer) const;
+
+    bool IsOpen() const { return m_data != nullptr; }
+    const std::string& GetFilePath() const { return m_filePath; }
+    uint32_t GetNumEntries() const {
+        return m_header ? m_header->numEntries : 0;
+    }
+    const PackageEntry* GetEntries() const { return m_entries; }
+
+    /// Gets the bytes of a chain of numMips levels, RGBA8 unless the flags
+    /// select a block format.
+    static uint64_t GetMipChainSize(uint32_t width, uint32_t height,
+        uint32_t numMips, uint32_t flags = 0);
+
+    /// Turns back slashes into slashes and drops a leading "./".
+    static std::string NormalizePath(const std::string& path);
+
+ private:
+    bool Map(const std::string& filePath);
+    bool Validate();
+
+    std::string m_filePath;
+    MappedFile m_file;
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+
+    const PackageHeader* m_header = nullptr;
+    const PackageEntry* m_entries = nullptr;
+    const char* m_strings = nullptr;
+};
+}  // namespace GangerEngine
+
+#endif  // _ASSETPACKAGE_H_
@@ -0,0 +1,237 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _ASYNCIO_H_
+#define _ASYNCIO_H_
+
+#include <GangerEngine/ThreadPool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GangerEngine {
+/// Requests of a higher priority are served first, FIFO within one.
+enum class IOPriority {
+    LOW,  ///< Prefetching and streaming ahead
+    NORMAL,
+    HIGH,  ///< Needed for the next frames, like a level being entered
+};
+
+enum class IOOperation {
+    READ,
+    WRITE,  ///< Written aside and renamed over the file once complete
+};
+
+enum class IOStatus {
+    PENDING,
+    OK,
+    FAILED,
+    CANCELLED,
+};
+
+/// Identifies a request, 0 is never used.
+typedef uint64_t IORequestId;
+
+/// What a finished request hands back.
+struct IOResult {
+    IORequestId id = 0;
+    IOStatus status = IOStatus::PENDING;
+    std::string filePath;
+    std::vector<unsigned char> data;  ///< The bytes read, empty for writes
+};
+
+typedef std::function<void(IOResult& result)> IOCallback;
+
+/// Fills the data of a read itself, instead of reading the file.
+typedef std::function<bool(std::vector<unsigned char>& data)> IOSource;
+
+/// A request for AsyncIO::Submit.
+struct IORequest {
+    IOOperation operation = IOOperation::READ;
+    IOPriority priority = IOPriority::NORMAL;
+    std::string filePath;
+    std::vector<unsigned char> data;  ///< What a write stores
+    IOCallback callback;  ///< Optional
+    /// Runs the callback on the I/O thread as soon as the request is done,
+    /// instead of in ProcessCompletions. It must be short and thread safe,
+    /// like handing the data over to a worker.
+    bool isImmediate = false;
+    IOSource source;  ///< Optional, used by reads of package entries
+};
+
+/// Counters of the async I/O.
+struct AsyncIOStats {
+    int numQueued = 0;
+    int numInFlight = 0;
+    uint64_t numCompleted = 0;  ///< Successful requests
+    uint64_t numFailed = 0;
+    uint64_t numCancelled = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+/// Runs file reads and writes in the background, the most urgent first.
+///
+/// On Linux it drives an io_uring from one thread, keeping up to the queue
+/// depth of chunk reads in flight so fast SSDs see a deep queue. Elsewhere,
+/// or when the kernel refuses the ring, a few threads do blocking reads.
+/// Callbacks run on the thread calling ProcessCompletions, futures are
+/// fulfilled from the I/O thread.
+class AsyncIO {
+ public:
+    AsyncIO();
+    ~AsyncIO();
+
+    /**
+     * \brief      Starts the I/O thread. Calling it again is a no-op.
+     *
+     * \param[in]  queueDepth    The chunks in flight at once, io_uring only
+     * \param[in]  numThreads    The threads of the fallback
+     * \param[in]  allowIOUring  False forces the thread fallback
+     */
+    void Init(unsigned int queueDepth = 32, unsigned int numThreads = 4,
+        bool allowIOUring = true);
+
+    /// Cancels the queued requests, waits for the ones in flight and stops.
+    /// Pending callbacks are still run by ProcessCompletions.
+    void Dispose();
+
+    /**
+     * \brief      Queues a request, starting the I/O thread if needed.
+     *
+     * \param[in]  request  The request
+     *
+     * \return     Its id, to cancel or wait for it.
+     */
+    IORequestId Submit(IORequest request);
+
+    /**
+     * \brief      Queues a request whose result is handed to a future. The
+     *             callback of the request is ignored.
+     *
+     * \param[in]  request  The request
+     * \param      id       Optional, gets the id of the request
+     *
+     * \return     The future, ready once the request is done.
+     */
+    std::future<IOResult> SubmitFuture(IORequest request,
+        IORequestId* id = nullptr);
+
+    /**
+     * \brief      Cancels a request. A queued one is dropped right away, one
+     *             in flight stops after the chunks already submitted. Either
+     *             way it completes as CANCELLED.
+     *
+     * \param[in]  id    The request id
+     *
+     * \return     False if it was already done.
+     */
+    bool Cancel(IORequestId id);
+
+    /**
+     * \brief      Changes the priority of a queued request, like a streamed
+     *             level chunk the player is now walking towards.
+     *
+     * \return     False if it is no longer queued.
+     */
+    bool SetPriority(IORequestId id, IOPriority priority);
+
+    /// Runs the callbacks of the finished requests, call it once per frame.
+    void ProcessCompletions();
+
+    /// Blocks until a request is done. Its callback still waits for
+    /// ProcessCompletions, unless it is immediate.
+    void Wait(IORequestId id);
+
+    /// Blocks until every request is done.
+    void WaitIdle();
+
+    AsyncIOStats GetStats() const;
+
+    bool IsRunning() const { return m_isRunning; }
+    /// "io_uring" or "threads".
+    const char* GetBackendName() const;
+
+ private:
+    struct Request;
+    struct Ring;
+    struct Chunk;
+    typedef std::shared_ptr<Request> RequestPtr;
+
+    IORequestId Enqueue(IORequest params,
+        std::unique_ptr<std::promise<IOResult> > promise);
+    /// Orders the queue heap.
+    static bool IsLessUrgent(const RequestPtr& a, const RequestPtr& b);
+    /// Takes the most urgent queued request, m_mutex must be held.
+    RequestPtr PopLocked();
+    /// Removes a request from the active ones and hands out its result.
+    void Complete(const RequestPtr& request, IOStatus status);
+
+    // Thread fallback
+    void RunNext();
+    IOStatus Read(Request& request);
+    IOStatus Write(Request& request);
+
+    // io_uring
+    bool InitRing(unsigned int entries);
+    void DisposeRing();
+    void Wake();
+    void RingLoop();
+    /// Checks if a queued request should take slots from a running one.
+    bool IsMoreUrgentThanRunning(const RequestPtr& request) const;
+    void StartRequest(const RequestPtr& request);
+    void SubmitChunks();
+    void PushChunk(Chunk* chunk);
+    void PushWakeRead();
+    void ReapCompletions();
+    void RetireRequests();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_doneCondition;
+    std::vector<RequestPtr> m_queue;  ///< A heap, the most urgent on top
+    std::unordered_map<IORequestId, RequestPtr> m_requests;  ///< Not done
+    std::vector<std::pair<IOCallback, IOResult> > m_completions;
+    IORequestId m_nextId = 1;
+    uint64_t m_sequence = 0;
+    AsyncIOStats m_stats;
+    std::atomic<bool> m_isRunning{false};
+    bool m_isStopping = false;
+
+    ThreadPool m_workers;
+
+    std::unique_ptr<Ring> m_ring;
+    std::thread m_ringThread;
+    /// Most urgent first, only touched by m_ringThread
+    std::vector<RequestPtr> m_running;
+    unsigned int m_queueDepth = 0;
+    unsigned int m_numChunks = 0;  ///< In flight, only touched by the ring
+    int m_wakeFd = -1;
+    uint64_t m_wakeValue = 0;
+};
+}  // namespace GangerEngine
+
+#endif  // _ASYNCIO_H_
@@ -17,9 +17,17 @@
 #ifndef _AUDIOENGINE_H_
 #define _AUDIOENGINE_H_
 
+#include <GangerEngine/MappedFile.h>
+#include <GangerEngine/Mixer.h>
+#include <GangerEngine/MusicStream.h>
+#include <GangerEngine/SoundCache.h>
+#include <GangerEngine/VoiceManager.h>
+
 #include <SDL/SDL_mixer.h>
+#include <cstddef>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace GangerEngine {
 /// Control a audio file
@@ -28,15 +36,45 @@ class SoundEffect {
     friend class AudioEngine;
 
     /**
-     * \brief      Plays the effect file.
+     * \brief      Plays the effect file. It may be merged into the same
+     *             effect played this frame, or dropped if every voice is
+     *             busy with more important sounds, see VoiceManager.
      *
-     * \param[in]  loops  If loops == -1, loops forever
-     *                    otherwise play it loops+1 times
+     * \param[in]  loops   If loops == -1, loops forever
+     *                     otherwise play it loops+1 times
+     * \param[in]  volume  From 0 to 1, with any distance falloff applied
+     */
+    void Play(int loops = 0, float volume = 1.0f);
+
+    /**
+     * \brief      Plays the effect at a place in the world, attenuated and
+     *             panned by where the listener is.
+     *
+     * \param[in]  position  The position
+     * \param[in]  loops     If loops == -1, loops forever
+     *                       otherwise play it loops+1 times
+     * \param[in]  volume    From 0 to 1
      */
-    void Play(int loops = 0);
+    void PlayAt(const glm::vec2& position, int loops = 0,
+        float volume = 1.0f);
+
+    /// Sets the priority of the effect, shared by every handle to it.
+    void SetPriority(int priority);
+    /// Limits the voices the effect plays on at once, 0 for no limit.
+    void SetMaxInstances(int maxInstances);
 
  private:
-    Mix_Chunk* m_chunk = nullptr;
+    SoundData* m_sound = nullptr;
+    SoundCache* m_cache = nullptr;
+    VoiceManager* m_voices = nullptr;
+};
+
+/// What the audio engine keeps of a loaded song.
+struct MusicData {
+    std::string filePath;
+    Mix_Music* music = nullptr;  ///< Only when SDL_mixer plays the music
+    double loopStart = 0.0;
+    double loopEnd = 0.0;
 };
 
 /// Control a song file
@@ -52,6 +90,17 @@ class Music {
      */
     void Play(int loops = 1);
 
+    /**
+     * \brief      Sets the part of the song repeated when it loops. What is
+     *             before the start only plays once, and what is after the
+     *             end only in the last play. Only the engine stream applies
+     *             them, SDL_mixer loops the whole song.
+     *
+     * \param[in]  startSeconds  Where a loop jumps back to
+     * \param[in]  endSeconds    Where a loop jumps back from, 0 for the end
+     */
+    void SetLoopPoints(double startSeconds, double endSeconds = 0.0);
+
     /// Pauses whatever song is currently playing
     static void Pause();
     /// Stops whatever song is currently playing
@@ -60,7 +109,8 @@ class Music {
     static void Resume();
 
  private:
-    Mix_Music* m_music = nullptr;
+    MusicData* m_data = nullptr;
+    static MusicStream* m_stream;  ///< nullptr when SDL_mixer plays music
 };
 
 /// Create and load a song or sound file
@@ -71,13 +121,65 @@ class AudioEngine {
     /// Default destructor
     ~AudioEngine();
 
-    /// Initialize the audio engine
-    void Init();
+    /**
+     * \brief      Initialize the audio engine. The effects are mixed by the
+     *             engine Mixer and the music streamed by a MusicStream when
+     *             the device takes 16 bit stereo, SDL_mixer plays both
+     *             otherwise. It runs headless with the SDL "dummy" audio
+     *             driver.
+     *
+     *             The stream decodes wav songs as they play. Other formats,
+     *             like ogg, are decoded whole from LoadMusic on and kept
+     *             until Destroy, which takes 10 MB per minute of song at
+     *             44.1 kHz stereo, see GetMusicStats.
+     *
+     * \param[in]  numVoices  The effects that can play at once
+     */
+    void Init(int numVoices = 128);
     /// Destroy the audio engine
     void Destroy();
-    
+
+    /// Starts a new audio frame, call it once per game frame.
+    void Update();
+
+    /**
+     * \brief      Sets where the effects played at a position are heard
+     *             from, usually the player or the camera.
+     *
+     * \param[in]  position     The listener position
+     * \param[in]  minDistance  Closer effects are heard at their full volume
+     * \param[in]  maxDistance  Farther effects are not heard
+     */
+    void SetListener(const glm::vec2& position, float minDistance = 64.0f,
+        float maxDistance = 1024.0f);
+
+    /// Sets how much music is decoded ahead, from the next song played.
+    void SetMusicBuffer(int milliseconds);
+
+    /**
+     * \brief      Sets the memory the decoded effects may take. The files
+     *             are always kept, the least recently played effects are
+     *             decoded again when played. 64 MB by default.
+     *
+     * \param[in]  bytes  The bytes
+     */
+    void SetEffectBudget(size_t bytes);
+
+    /// Sets the memory the songs kept decoded may take, see
+    /// MusicStream::SetCacheBudget. 64 MB by default.
+    void SetMusicCacheBudget(size_t bytes);
+
+    VoiceStats GetVoiceStats() { return m_voices.GetStats(); }
+    MixerStats GetMixerStats() const { return m_mixer.GetStats(); }
+    MusicStreamStats GetMusicStats() const { return m_musicStream.GetStats(); }
+    SoundCacheStats GetEffectStats() const { return m_soundCache.GetStats(); }
+    /// Gets the memory every loaded effect takes.
+    void GetEffectMemory(std::vector<SoundMemory>* effects) const {
+        m_soundCache.GetMemory(effects);
+    }
+
     /**
-     * \brief      Loads and map a sound file
+     * \brief      Loads a sound file into the effects cache
      *
      * \param[in]  filePath  The file path
      *
@@ -95,8 +197,17 @@ class AudioEngine {
     Music LoadMusic(const std::string& filePath);
 
  private:
-    std::map<std::string, Mix_Chunk*> m_effectMap;  ///< Effects cache
-    std::map<std::string, Mix_Music*> m_musicMap;  ///< Music cache
+    /// Runs on the audio thread once SDL_mixer has mixed its channels.
+    static void MixOutput(void* engine, Uint8* stream, int length);
+
+    std::map<std::string, MusicData> m_musicMap;  ///< Music cache
+    std::map<std::string, MappedFile> m_musicFiles;  ///< What music reads
+    SoundCache m_soundCache;  ///< Effects cache
+    Mixer m_mixer;
+    VoiceManager m_voices;
+    MusicStream m_musicStream;
+    int m_sampleRate = MIX_DEFAULT_FREQUENCY;
+    int m_musicBufferMilliseconds = 1000;
 
     bool m_isInitialized = false;
 };
@@ -0,0 +1,84 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _BLOCKCOMPRESSOR_H_
+#define _BLOCKCOMPRESSOR_H_
+
+#include <GangerEngine/ImageProcessor.h>
+
+#include <cstddef>
+
+namespace GangerEngine {
+class ThreadPool;
+
+/// Encodes and decodes the S3TC block formats, BC1 and BC3. Both store
+/// 4x4 texel blocks: BC1 in 8 bytes with 1 bit alpha, BC3 in 16 bytes with
+/// an 8 bit alpha block in front. No OpenGL, so it runs anywhere.
+class BlockCompressor {
+ public:
+    /// Gets the bytes of a 4x4 block, 0 for uncompressed formats.
+    static size_t GetBlockSize(PixelFormat format);
+
+    /**
+     * \brief      Encodes one block.
+     *
+     * \param[in]  texels  The 16 RGBA8 texels, row after row
+     * \param[in]  format  BC1 or BC3
+     * \param      out     The block
+     */
+    static void EncodeBlock(const unsigned char* texels, PixelFormat format,
+        unsigned char* out);
+
+    /**
+     * \brief      Decodes one block.
+     *
+     * \param[in]  block   The block
+     * \param[in]  format  BC1 or BC3
+     * \param      texels  The 16 RGBA8 texels, row after row
+     */
+    static void DecodeBlock(const unsigned char* block, PixelFormat format,
+        unsigned char* texels);
+
+    /**
+     * \brief      Compresses a RGBA8 image. The blocks over the edges repeat
+     *             the last row and column.
+     *
+     * \param[in]  pixels   The pixels
+     * \param[in]  width    The width
+     * \param[in]  height   The height
+     * \param[in]  format   BC1 or BC3
+     * \param      out      ImageProcessor::GetLevelSize bytes
+     * \param      workers  Splits the block rows among its threads, may be
+     *                      null
+     */
+    static void Compress(const unsigned char* pixels, int width, int height,
+        PixelFormat format, unsigned char* out, ThreadPool* workers = nullptr);
+
+    /**
+     * \brief      Decompresses an image to RGBA8.
+     *
+     * \param[in]  blocks  The blocks
+     * \param[in]  width   The width
+     * \param[in]  height  The height
+     * \param[in]  format  BC1 or BC3
+     * \param      pixels  width * height * 4 bytes
+     */
+    static void Decompress(const unsigned char* blocks, int width,
+        int height, PixelFormat format, unsigned char* pixels);
+};
+}  // namespace GangerEngine
+
+#endif  // _BLOCKCOMPRESSOR_H_
@@ -0,0 +1,94 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _BOX2DDEBUGDRAW_H_
+#define _BOX2DDEBUGDRAW_H_
+
+#include <GangerEngine/DebugRenderer.h>
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace GangerEngine {
+/// Draws a whole b2World into a DebugRenderer in one pass. Box2D hands over
+/// the shapes already transformed to world space, and they are all batched
+/// into the renderer's single line draw.
+class Box2DDebugDraw : public b2Draw {
+ public:
+    /// Default constructor. Draws shapes and joints.
+    Box2DDebugDraw();
+
+    /**
+     * \brief      Sets the renderer to draw into.
+     *
+     * \param[in]  renderer  The debug renderer
+     */
+    void Init(DebugRenderer* renderer);
+
+    /**
+     * \brief      Draws the enabled categories of a world.
+     *
+     * \param[in]  world  The world
+     */
+    void DrawWorld(b2World* world);
+
+    /**
+     * \brief      Turns a category on or off.
+     *
+     * \param[in]  category  A b2Draw flag, like b2Draw::e_aabbBit
+     * \param[in]  enabled   True to draw it
+     */
+    void SetCategory(uint32 category, bool enabled) {
+        if (enabled)
+            AppendFlags(category);
+        else
+            ClearFlags(category);
+    }
+
+    /// Length of the axes drawn for transforms.
+    void SetAxisLength(float length) { m_axisLength = length; }
+
+    // b2Draw interface
+    void DrawPolygon(const b2Vec2* vertices, int32 vertexCount,
+        const b2Color& color) override;
+    void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount,
+        const b2Color& color) override;
+    void DrawCircle(const b2Vec2& center, float32 radius,
+        const b2Color& color) override;
+    void DrawSolidCircle(const b2Vec2& center, float32 radius,
+        const b2Vec2& axis, const b2Color& color) override;
+    void DrawSegment(const b2Vec2& p1, const b2Vec2& p2,
+        const b2Color& color) override;
+    void DrawTransform(const b2Transform& xf) override;
+    void DrawPoint(const b2Vec2& p, float32 size,
+        const b2Color& color) override;
+
+ private:
+    static ColorRGBA8 ToColor(const b2Color& color) {
+        return ColorRGBA8(static_cast<GLubyte>(color.r * 255.0f),
+            static_cast<GLubyte>(color.g * 255.0f),
+            static_cast<GLubyte>(color.b * 255.0f),
+            static_cast<GLubyte>(color.a * 255.0f));
+    }
+
+    DebugRenderer* m_renderer = nullptr;
+    std::vector<glm::vec2> m_points;  ///< Scratch for polygon conversion
+    float m_axisLength = 0.4f;
+};
+}  // namespace GangerEngine
+
+#endif  // _BOX2DDEBUGDRAW_H_
@@ -0,0 +1,50 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _COMPRESSION_H_
+#define _COMPRESSION_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace GangerEngine {
+/**
+ * \brief      Compresses bytes with a small LZ77 block format. Each sequence
+ *             is a token (literal and match length nibbles), the literals
+ *             and a 16 bit match offset. It favours decode speed over ratio.
+ *
+ * \param[in]  src   The bytes
+ * \param[in]  size  The number of bytes
+ * \param      out   The compressed bytes
+ */
+void CompressLZ(const unsigned char* src, size_t size,
+    std::vector<unsigned char>& out);
+
+/**
+ * \brief      Decompresses a CompressLZ block.
+ *
+ * \param[in]  src      The compressed bytes
+ * \param[in]  srcSize  The number of compressed bytes
+ * \param      dst      Where to write, dstSize bytes long
+ * \param[in]  dstSize  The exact decompressed size
+ *
+ * \return     False if the block is corrupt.
+ */
+bool DecompressLZ(const unsigned char* src, size_t srcSize,
+    unsigned char* dst, size_t dstSize);
+}  // namespace GangerEngine
+
+#endif  // _COMPRESSION_H_
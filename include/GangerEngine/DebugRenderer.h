@@ -35,9 +35,44 @@ class DebugRenderer {
     /// Initialize the debug renderer.
     void Init();
 
-    /// End the debug renderer.
+    /// Uploads the transient geometry drawn since the last End.
     void End();
 
+    /**
+     * \brief      Creates a retained layer. Retained geometry is uploaded once
+     *             and drawn by every Render until it is recorded again, which
+     *             suits static geometry like level collision outlines.
+     *
+     * \return     The layer id.
+     */
+    int CreateLayer();
+
+    /**
+     * \brief      Starts recording a retained layer, replacing its geometry.
+     *             Draw calls go to the layer until EndLayer.
+     *
+     * \param[in]  layer  The layer id
+     */
+    void BeginLayer(int layer);
+
+    /// Uploads the recorded layer and goes back to transient drawing.
+    void EndLayer();
+
+    /**
+     * \brief      Shows or hides a retained layer.
+     *
+     * \param[in]  layer    The layer id
+     * \param[in]  visible  True to render the layer
+     */
+    void SetLayerVisible(int layer, bool visible);
+
+    /**
+     * \brief      Frees a retained layer.
+     *
+     * \param[in]  layer  The layer id
+     */
+    void DestroyLayer(int layer);
+
     /**
      * \brief      Draws a line.
      *
@@ -59,7 +94,18 @@ class DebugRenderer {
         float angle);
 
     /**
-     * \brief      Draws a circle.
+     * \brief      Draws a closed polygon outline.
+     *
+     * \param[in]  points  The points
+     * \param[in]  count   The number of points, nothing is drawn under 2
+     * \param[in]  color   The color
+     */
+    void DrawPolygon(const glm::vec2* points, int count,
+        const ColorRGBA8& color);
+
+    /**
+     * \brief      Draws a circle. The number of segments is picked from the
+     *             radius on screen, using the view scale.
      *
      * \param[in]  center  The center
      * \param[in]  color   The color
@@ -69,7 +115,19 @@ class DebugRenderer {
         float radius);
 
     /**
-     * \brief      Renders the debug graphics.
+     * \brief      Sets the screen pixels per world unit, used to choose the
+     *             circle level of detail. Usually Camera2D::GetScale().
+     *
+     * \param[in]  scale  The view scale
+     */
+    void SetViewScale(float scale) { m_viewScale = scale; }
+
+    /// Gets the screen pixels per world unit.
+    float GetViewScale() const { return m_viewScale; }
+
+    /**
+     * \brief      Renders the visible retained layers and the transient
+     *             geometry.
      *
      * \param[in]  projectionMatrix  The projection matrix
      * \param[in]  lineWidth         The line width
@@ -86,11 +144,38 @@ class DebugRenderer {
     };
 
  private:
+    /// GPU buffers of a layer
+    struct Layer {
+        GLuint vbo = 0, vao = 0, ibo = 0;
+        int numElements = 0;
+        GLenum indexType = GL_UNSIGNED_INT;
+        GLsizeiptr vertexCapacity = 0;  ///< Allocated bytes of the vbo
+        GLsizeiptr indexCapacity = 0;  ///< Allocated bytes of the ibo
+        bool isVisible = true;
+        bool isAlive = false;
+    };
+
+    /// Creates the buffers of a layer
+    void InitLayer(Layer* layer);
+    /// Uploads m_verts and m_indices to a layer, with 16 bit indices when
+    /// they fit
+    void UploadLayer(Layer* layer, GLenum usage);
+    /// Draws a layer
+    void RenderLayer(const Layer& layer);
+    /// Deletes the buffers of a layer
+    void DisposeLayer(Layer* layer);
+
     GangerEngine::GLSLProgram m_program;
-    std::vector<DebugVertex> m_verts;
-    std::vector<GLuint> m_indices;
-    GLuint m_vbo = 0, m_vao = 0, m_ibo = 0;
-    int m_numElements = 0;
+    std::vector<DebugVertex> m_verts;  ///< Vertices being recorded
+    std::vector<GLuint> m_indices;  ///< Indices being recorded
+    std::vector<GLushort> m_shortIndices;  ///< Scratch for 16 bit indices
+    Layer m_transient;  ///< Streamed every frame
+    std::vector<Layer> m_layers;  ///< Retained layers
+    int m_recordingLayer = -1;  ///< The layer being recorded, -1 if none
+    // The transient geometry is put aside while a layer is recorded
+    std::vector<DebugVertex> m_transientVerts;
+    std::vector<GLuint> m_transientIndices;
+    float m_viewScale = 1.0f;
 };
 }  // namespace GangerEngine
 
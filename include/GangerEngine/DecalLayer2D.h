@@ -0,0 +1,115 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _DECALLAYER2D_H_
+#define _DECALLAYER2D_H_
+
+#include <GangerEngine/GLSLProgram.h>
+#include <GangerEngine/SpriteBatch.h>
+#include <GangerEngine/Vertex.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace GangerEngine {
+class Camera2D;
+
+/// Bakes long lived sprites, like particle splats, into render to texture
+/// chunks aligned to the world grid. However many decals have been baked,
+/// drawing the layer is one textured quad per visible chunk.
+class DecalLayer2D {
+ public:
+    /// Default constructor.
+    DecalLayer2D();
+    /// Default destructor.
+    ~DecalLayer2D();
+
+    /**
+     * \brief      Initializes the decal layer.
+     *
+     * \param[in]  chunkSize        The world size of a chunk, best a multiple
+     *                              of the level tile size
+     * \param[in]  chunkResolution  The texels per side of a chunk texture
+     */
+    void Init(float chunkSize, int chunkResolution);
+
+    /**
+     * \brief      Queues a decal. It is baked on the next Flush or Render.
+     *
+     * \param[in]  destRect  The destination rectangle in world space
+     * \param[in]  texture   The texture
+     * \param[in]  color     The color
+     */
+    void AddDecal(const glm::vec4& destRect, GLuint texture,
+        const ColorRGBA8& color);
+
+    /// Bakes all the queued decals into their chunks.
+    void Flush();
+
+    /**
+     * \brief      Bakes the queued decals and draws the chunks.
+     *
+     * \param[in]  projectionMatrix  The projection matrix
+     * \param[in]  camera            The camera to cull chunks, can be nullptr
+     */
+    void Render(const glm::mat4& projectionMatrix, Camera2D* camera = nullptr);
+
+    /// Erases all the baked decals.
+    void Clear();
+
+    /// Terminates the decal layer.
+    void Dispose();
+
+    /// Gets the number of allocated chunks.
+    int GetNumChunks() const { return static_cast<int>(m_chunks.size()); }
+
+ private:
+    struct Decal {
+        glm::vec4 destRect;
+        GLuint texture;
+        ColorRGBA8 color;
+    };
+
+    struct Chunk {
+        glm::ivec2 coord;
+        GLuint fbo = 0;
+        GLuint texture = 0;
+    };
+
+    /// Packs the chunk coordinates into a map key
+    static int64_t ChunkKey(int x, int y) {
+        return (static_cast<int64_t>(x) << 32) ^
+            static_cast<int64_t>(static_cast<uint32_t>(y));
+    }
+
+    /// Gets a chunk, creating it if needed
+    Chunk& GetChunk(int x, int y);
+
+    float m_chunkSize = 512.0f;
+    int m_chunkResolution = 512;
+    GLSLProgram m_program;
+    SpriteBatch m_spriteBatch;
+    std::vector<Decal> m_pending;
+    std::unordered_map<int64_t, Chunk> m_chunks;
+    std::vector<Chunk*> m_dirtyChunks;  ///< Chunks touched by the flush
+    bool m_isInitialized = false;
+};
+}  // namespace GangerEngine
+
+#endif  // _DECALLAYER2D_H_
@@ -0,0 +1,83 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _DIRECTORYSCANNER_H_
+#define _DIRECTORYSCANNER_H_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GangerEngine {
+struct DirEntry {
+    std::string path;  ///< The directory scanned, a slash and the name
+    bool isDirectory;
+};
+
+/// Lists directories on disk and keeps the listings. On Linux inotify tells
+/// which directories changed, so listing a big tree again only costs a copy
+/// until something in it is created, deleted or renamed. Elsewhere every
+/// call walks the disk.
+class DirectoryScanner {
+ public:
+    DirectoryScanner();
+    ~DirectoryScanner();
+
+    /**
+     * \brief      Lists a directory, sorted by path.
+     *
+     * \param[in]  directory    The directory
+     * \param[in]  isRecursive  If the subdirectories are listed too
+     * \param[in]  pattern      Keeps the entries whose name matches it, see
+     *                          IOManager::MatchGlob. Empty keeps them all.
+     * \param      entries      The entries are added here
+     *
+     * \return     False if it is not a directory.
+     */
+    bool Scan(const std::string& directory, bool isRecursive,
+        const std::string& pattern, std::vector<DirEntry>* entries);
+
+    /// Drops every listing, the next scans walk the disk again.
+    void Clear();
+
+    size_t GetNumCached();
+
+ private:
+    typedef std::pair<std::string, bool> ListingKey;  ///< With isRecursive
+
+    /// Walks a directory, false if it could not be opened. isWatched turns
+    /// false if some directory could not be watched.
+    bool Walk(const std::string& directory, bool isRecursive,
+        std::vector<DirEntry>* entries, bool* isWatched);
+    bool Watch(const std::string& directory);
+    /// Reads the pending inotify events and drops what they touch.
+    void ProcessEvents();
+    void Invalidate(const std::string& directory);
+
+    std::mutex m_mutex;
+    std::map<ListingKey, std::vector<DirEntry> > m_listings;
+    /// The paths each watch descriptor was added for
+    std::unordered_map<int, std::set<std::string> > m_watches;
+    int m_inotifyFd = -1;
+};
+}  // namespace GangerEngine
+
+#endif  // _DIRECTORYSCANNER_H_
@@ -0,0 +1,119 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _FLATHASHMAP_H_
+#define _FLATHASHMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GangerEngine {
+/// An open addressing hash map from already hashed 64 bit keys, like
+/// ResourceId::hash, to small values. The slots live in one array with
+/// linear probing, so a lookup is a couple of cache lines and never
+/// allocates. Values can not be removed.
+template <typename T>
+class FlatHashMap {
+ public:
+    /**
+     * \brief      Finds the value of a key.
+     *
+     * \param[in]  key   The key
+     *
+     * \return     The value, nullptr if the key is not in the map.
+     */
+    T* Find(uint64_t key) {
+        if (m_slots.empty()) return nullptr;
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = GetIndex(key, mask);; i = (i + 1) & mask) {
+            Slot& slot = m_slots[i];
+            if (!slot.isUsed) return nullptr;
+            if (slot.key == key) return &slot.value;
+        }
+    }
+
+    const T* Find(uint64_t key) const {
+        return const_cast<FlatHashMap*>(this)->Find(key);
+    }
+
+    /**
+     * \brief      Inserts a value, or overwrites the one of the key.
+     *
+     * \param[in]  key    The key
+     * \param[in]  value  The value
+     *
+     * \return     The value in the map.
+     */
+    T& Insert(uint64_t key, const T& value) {
+        // Keep the load under 3/4 so the probes stay short
+        if ((m_size + 1) * 4 > m_slots.size() * 3) {
+            Rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+        }
+
+        Slot& slot = FindSlot(key);
+        if (!slot.isUsed) {
+            slot.isUsed = true;
+            slot.key = key;
+            m_size++;
+        }
+        slot.value = value;
+        return slot.value;
+    }
+
+    void Clear() {
+        m_slots.clear();
+        m_size = 0;
+    }
+
+    size_t GetSize() const { return m_size; }
+
+ private:
+    struct Slot {
+        uint64_t key = 0;
+        T value = T();
+        bool isUsed = false;
+    };
+
+    static size_t GetIndex(uint64_t key, size_t mask) {
+        // Fold the high bits in, the low ones alone are weak for FNV
+        return static_cast<size_t>(key ^ (key >> 32)) & mask;
+    }
+
+    Slot& FindSlot(uint64_t key) {
+        size_t mask = m_slots.size() - 1;
+        size_t i = GetIndex(key, mask);
+        while (m_slots[i].isUsed && m_slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return m_slots[i];
+    }
+
+    void Rehash(size_t numSlots) {
+        std::vector<Slot> oldSlots(numSlots);
+        oldSlots.swap(m_slots);
+        for (auto& slot : oldSlots) {
+            if (slot.isUsed) FindSlot(slot.key) = slot;
+        }
+    }
+
+    std::vector<Slot> m_slots;  ///< A power of two of them
+    size_t m_size = 0;
+};
+}  // namespace GangerEngine
+
+#endif  // _FLATHASHMAP_H_
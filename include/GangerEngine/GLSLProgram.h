@@ -46,9 +46,14 @@ class GLSLProgram {
      *
      * \param[in]  vertexSource    The vertex source
      * \param[in]  fragmentSource  The fragment source
+     * \param[in]  vertexLength    The vertex source length, -1 if it is
+     *                             null terminated
+     * \param[in]  fragmentLength  The fragment source length, -1 if it is
+     *                             null terminated
      */
     void CompileShadersFromSource(const char* vertexSource,
-        const char* fragmentSource);
+        const char* fragmentSource, int vertexLength = -1,
+        int fragmentLength = -1);
 
     /// Link the shader.
     void LinkShaders();
@@ -81,8 +86,8 @@ class GLSLProgram {
  private:
     int m_numAttributes;
 
-    void CompileShader(const char* source, const std::string& name,
-        GLuint id);
+    void CompileShader(const char* source, int length,
+        const std::string& name, GLuint id);
 
     GLuint m_programID;
 
@@ -28,6 +28,13 @@ struct GLTexture {
     int width;  ///< The width
     int height;  ///< The height
 };
+
+/// The GPU side of a GLTexture, without the path. Cheap to copy around.
+struct GLTextureRef {
+    GLuint id = 0;  ///< The ID
+    int width = 0;  ///< The width
+    int height = 0;  ///< The height
+};
 }  // namespace GangerEngine
 
 #endif  // _GLTEXTURE_H_
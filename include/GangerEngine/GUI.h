@@ -22,9 +22,24 @@
 #include <glm/glm.hpp>
 #include <SDL/SDL_events.h>
 
+#include <memory>
 #include <string>
 
 namespace GangerEngine {
+/// Loads the CEGUI files through IOManager, so schemes, imagesets, fonts
+/// and layouts come from the mounted packages and directories like any other
+/// asset. The resource groups keep mapping to directories, now virtual ones.
+class GUIResourceProvider : public CEGUI::DefaultResourceProvider {
+ public:
+    void loadRawDataContainer(const CEGUI::String& filename,
+        CEGUI::RawDataContainer& output,
+        const CEGUI::String& resourceGroup) override;
+
+    size_t getResourceGroupFileNames(std::vector<CEGUI::String>& out_vec,
+        const CEGUI::String& file_pattern,
+        const CEGUI::String& resource_group) override;
+};
+
 /// The GUI class
 class GUI {
  public:
@@ -35,7 +50,8 @@ class GUI {
      */
     void Init(const std::string& resourceDirectory);
 
-    /// Destroy the GUI.
+    /// Destroy the GUI. The last one also destroys the CEGUI system, the
+    /// next Init creates it again.
     void Destroy();
 
     /// Draws the GUI.
@@ -118,6 +134,9 @@ class GUI {
 
  private:
     static CEGUI::OpenGL3Renderer* m_renderer;
+    /// CEGUI does not own a resource provider it is given
+    static std::unique_ptr<GUIResourceProvider> m_resourceProvider;
+    static int m_numGUIs;  ///< Initialized and not destroyed, sharing it all
     CEGUI::GUIContext* m_context = nullptr;
     CEGUI::Window* m_root = nullptr;
     unsigned int m_lastTime = 0;
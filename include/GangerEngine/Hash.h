@@ -0,0 +1,60 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _HASH_H_
+#define _HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace GangerEngine {
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+/**
+ * \brief      64 bit FNV-1a hash. It can run at compile time.
+ *
+ * \param[in]  data  The bytes
+ * \param[in]  size  The number of bytes
+ * \param[in]  hash  The hash to continue from
+ *
+ * \return     The hash.
+ */
+constexpr uint64_t HashFNV1a(const char* data, size_t size,
+    uint64_t hash = FNV_OFFSET_BASIS) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/// 64 bit FNV-1a hash of a null terminated string.
+constexpr uint64_t HashFNV1a(const char* str) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (; *str != '\0'; str++) {
+        hash = (hash ^ static_cast<uint8_t>(*str)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/// 64 bit FNV-1a hash of a string.
+inline uint64_t HashFNV1a(const std::string& str) {
+    return HashFNV1a(str.data(), str.size());
+}
+}  // namespace GangerEngine
+
+#endif  // _HASH_H_
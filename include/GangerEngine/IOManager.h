@@ -17,15 +17,22 @@
 #ifndef _IOMANAGER_H_
 #define _IOMANAGER_H_
 
+#include <GangerEngine/AsyncIO.h>
+#include <GangerEngine/DirectoryScanner.h>
+
+#include <future>
 #include <string>
 #include <vector>
 
 namespace GangerEngine {
-struct DirEntry {
-    std::string path;
-    bool isDirectory;
-};
+class AssetPackage;
+class MappedFile;
+struct PackageEntry;
 
+// Reads files through a virtual file system. Packages and directories are
+// mounted on a stack: a path is looked up from the last mount down to the
+// first, so a patch package or a mod directory overrides what came before,
+// and only then relative to the working directory.
 class IOManager {
  public:
     static bool ReadFileToBuffer(std::string filePath,
@@ -33,12 +40,89 @@ class IOManager {
     static bool ReadFileToBuffer(std::string filePath,
         std::string& buffer);
 
+    // Opens a read only view of a file without copying it when possible:
+    // uncompressed package entries point into the package, big files on disk
+    // are memory mapped. The view lives as long as the MappedFile.
+    static bool MapFile(const std::string& filePath, MappedFile* file);
+
     // Gets all directory entries in the directory specified by path and stores
-    // in rvEntries.
+    // in rvEntries, as "path/name".
     // Returns false if path is not a directory.
     static bool GetDirectoryEntries(const char* path,
         std::vector<DirEntry>* rvEntries);
+
+    // Lists a directory on disk, optionally its whole tree and only the
+    // names matching a pattern, see MatchGlob. Listings are cached until
+    // inotify reports a change, so listing a big content tree again is
+    // cheap. Returns false if it is not a directory.
+    static bool ScanDirectory(const std::string& directory,
+        std::vector<DirEntry>* entries, bool isRecursive = false,
+        const std::string& pattern = "");
     static bool MakeDirectory(const char* path);
+
+    // Mounts a package on top of the stack. The package must outlive its
+    // mount.
+    static void MountPackage(const AssetPackage* package);
+    static void UnmountPackage(const AssetPackage* package);
+
+    // Mounts a directory on top of the stack, its files are found by their
+    // path relative to it. Absolute paths never go through directories.
+    static void MountDirectory(const std::string& directory);
+    static void UnmountDirectory(const std::string& directory);
+
+    // Finds where a path resolves to. Returns the package entry when the top
+    // mount having it is a package, otherwise nullptr and, if asked, the
+    // path of the file on disk.
+    static const PackageEntry* Resolve(const std::string& filePath,
+        const AssetPackage** package, std::string* diskPath);
+
+    // Finds the mounted entry of a path, nullptr if it is only on disk.
+    static const PackageEntry* FindPackageEntry(const std::string& filePath,
+        const AssetPackage** package);
+
+    // Gets the path of a file on disk once the directory mounts are applied.
+    static std::string ResolvePath(const std::string& filePath);
+
+    // Gets the names of the files right inside a directory, gathered from
+    // every mount and the working directory, sorted and without duplicates.
+    // Returns false if no mount nor the disk have such a directory.
+    static bool GetFileNames(const std::string& directory,
+        std::vector<std::string>* names);
+
+    // Checks a name against a pattern where * matches any run of characters
+    // and ? any single one.
+    static bool MatchGlob(const std::string& pattern, const std::string& name);
+
+    // Queues a read or write on the async I/O, see AsyncIO. Reads resolve
+    // through the mounts like ReadFileToBuffer, writes go to the path as is.
+    // Callbacks run from ProcessAsyncCompletions, which IMainGame calls
+    // every frame.
+    static IORequestId SubmitAsync(IORequest request);
+    static IORequestId ReadFileAsync(const std::string& filePath,
+        IOCallback callback, IOPriority priority = IOPriority::NORMAL);
+    static std::future<IOResult> ReadFileFuture(const std::string& filePath,
+        IOPriority priority = IOPriority::NORMAL, IORequestId* id = nullptr);
+    // The data lands in a file next to it first, so a crash halfway never
+    // leaves a torn save behind.
+    static IORequestId WriteFileAsync(const std::string& filePath,
+        std::vector<unsigned char> data, IOCallback callback = nullptr,
+        IOPriority priority = IOPriority::NORMAL);
+    static bool CancelAsync(IORequestId id);
+    static void WaitForAsync(IORequestId id);
+    static void ProcessAsyncCompletions();
+
+    // The async I/O itself, to Init it with other settings before the first
+    // request, read its stats or Dispose it, which waits for pending writes.
+    static AsyncIO& GetAsyncIO();
+
+ private:
+    // A package or a directory, the other one is empty
+    struct Mount {
+        const AssetPackage* package;
+        std::string directory;  ///< Normalized, ending in /
+    };
+
+    static std::vector<Mount> m_mounts;
 };
 }  // namespace GangerEngine
 
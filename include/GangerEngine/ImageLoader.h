@@ -18,8 +18,12 @@
 #define _IMAGELOADER_H_
 
 #include <GangerEngine/GLTexture.h>
+#include <GangerEngine/ImageProcessor.h>
+#include <GangerEngine/PNGDecoder.h>
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace GangerEngine {
 /// Loads images into GLTextures
@@ -35,6 +39,123 @@ class ImageLoader {
      * \return     An GLTexture of the texture file.
      */
     static GLTexture LoadPNG(std::string filePath, bool linear = false);
+
+    /**
+     * \brief      Reads and decodes a png to RGBA8 pixels. It does not touch
+     *             OpenGL, so it is safe to call from worker threads.
+     *
+     * \param[in]  filePath  The file path
+     * \param      pixels    The decoded pixels, top row first
+     * \param      width     The width
+     * \param      height    The height
+     *
+     * \return     False if the file could not be read or decoded.
+     */
+    static bool DecodePNGFile(const std::string& filePath,
+        std::vector<unsigned char>& pixels, int& width, int& height);
+
+    /**
+     * \brief      Decodes a png already in memory, like DecodePNGFile.
+     *
+     * \param[in]  filePath  The file path, for the error messages
+     * \param[in]  data      The png bytes
+     * \param[in]  size      The size of the data
+     * \param      pixels    The decoded pixels, top row first
+     * \param      width     The width
+     * \param      height    The height
+     *
+     * \return     False if it could not be decoded.
+     */
+    static bool DecodePNGMemory(const std::string& filePath,
+        const unsigned char* data, size_t size,
+        std::vector<unsigned char>& pixels, int& width, int& height);
+
+    /**
+     * \brief      Selects the png decoder. Set it before loading anything,
+     *             the async loaders read it from their threads.
+     *
+     * \param[in]  decoder  The decoder
+     */
+    static void SetPNGDecoder(PNGDecoderType decoder) {
+        m_pngDecoder = decoder;
+    }
+
+    /**
+     * \brief      Uploads RGBA8 pixels to a new texture with mipmaps.
+     *
+     * \param[in]  filePath  The file path stored in the texture
+     * \param[in]  pixels    The pixels
+     * \param[in]  width     The width
+     * \param[in]  height    The height
+     * \param[in]  linear    Linear or nearest magnification filter
+     *
+     * \return     The GLTexture.
+     */
+    static GLTexture UploadRGBA(const std::string& filePath,
+        const unsigned char* pixels, int width, int height,
+        bool linear = false);
+
+    /**
+     * \brief      Uploads a RGBA8 mip chain laid out level after level, as
+     *             stored by the asset packages. A single level gets its
+     *             mipmaps generated.
+     *
+     * \param[in]  filePath  The file path stored in the texture
+     * \param[in]  levels    The pixels of every level
+     * \param[in]  width     The width of the first level
+     * \param[in]  height    The height of the first level
+     * \param[in]  numMips   The number of levels
+     * \param[in]  linear    Linear or nearest magnification filter
+     *
+     * \return     The GLTexture.
+     */
+    static GLTexture UploadMipChain(const std::string& filePath,
+        const unsigned char* levels, int width, int height, int numMips,
+        bool linear = false);
+
+    /**
+     * \brief      Uploads an image made by ImageProcessor to a new texture,
+     *             in its own format and with its mip chain.
+     *
+     * \param[in]  filePath  The file path stored in the texture
+     * \param[in]  image     The image
+     * \param[in]  linear    Linear or nearest magnification filter
+     *
+     * \return     The GLTexture.
+     */
+    static GLTexture UploadImage(const std::string& filePath,
+        const ProcessedImage& image, bool linear = false);
+
+    /**
+     * \brief      Uploads the levels of an image to the bound texture and
+     *             sets its parameters.
+     *
+     * \param[in]  image   The image
+     * \param[in]  data    The texels, laid out as image.data. Null when they
+     *                     come from the bound unpack buffer.
+     * \param[in]  linear  Linear or nearest magnification filter
+     */
+    static void UploadLevels(const ProcessedImage& image,
+        const unsigned char* data, bool linear = false);
+
+    /// Checks if the context takes BC1 and BC3 textures.
+    static bool HasBlockCompression();
+
+    /// Checks if R8 masks can be swizzled back to RGBA.
+    static bool HasTextureSwizzle();
+
+    /**
+     * \brief      Sets the wrap and filter parameters of the bound texture
+     *             and generates its mipmaps.
+     *
+     * \param[in]  linear           Linear or nearest magnification filter
+     * \param[in]  generateMipmaps  False if the levels were uploaded
+     */
+    static void FinishTexture(bool linear = false,
+        bool generateMipmaps = true);
+
+ private:
+    static PNGDecoderType m_pngDecoder;
 };
 }  // namespace GangerEngine
 
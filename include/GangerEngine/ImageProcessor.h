@@ -0,0 +1,133 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _IMAGEPROCESSOR_H_
+#define _IMAGEPROCESSOR_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace GangerEngine {
+class ThreadPool;
+
+/// The texel layouts a processed image can be uploaded in.
+enum class PixelFormat {
+    RGBA8,
+    RGB565,  ///< Opaque images, half the size
+    RGBA4444,  ///< Images with alpha, half the size
+    R8,  ///< Gray images and white alpha masks, a quarter of the size
+    BC1,  ///< S3TC blocks with 1 bit alpha, an eighth of the size
+    BC3  ///< S3TC blocks with 8 bit alpha, a quarter of the size
+};
+
+/// How images are prepared for the GPU.
+struct ImageOptions {
+    bool generateMips = true;  ///< Build the whole mip chain on the CPU
+    bool isSRGB = true;  ///< The pixels are sRGB, filter mips in linear light
+    bool premultiplyAlpha = false;  ///< For GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+    bool useMaskFormat = true;  ///< R8 for gray images and alpha masks
+    bool allowLossyFormats = false;  ///< RGB565 and RGBA4444 for the rest
+    bool useBlockCompression = true;  ///< Keep cooked BC textures compressed
+};
+
+/// An image ready to upload, its levels back to back.
+struct ProcessedImage {
+    PixelFormat format = PixelFormat::RGBA8;
+    bool isAlphaMask = false;  ///< R8 holds the alpha of a white image
+    bool isPremultiplied = false;
+    int width = 0;
+    int height = 0;
+    int numMips = 0;
+    std::vector<unsigned char> data;
+    std::vector<size_t> levelOffsets;  ///< Where each level starts in data
+};
+
+/// CPU side image work: mip chains, premultiplied alpha and texel format
+/// conversion. It does not touch OpenGL, so it runs on worker threads.
+class ImageProcessor {
+ public:
+    /**
+     * \brief      Turns decoded RGBA8 pixels into an image ready to upload.
+     *
+     * \param[in]  pixels   The pixels, top row first
+     * \param[in]  width    The width
+     * \param[in]  height   The height
+     * \param[in]  options  The options
+     * \param      image    The processed image
+     * \param      workers  Splits the work among its threads, may be null
+     */
+    static void Process(const unsigned char* pixels, int width, int height,
+        const ImageOptions& options, ProcessedImage* image,
+        ThreadPool* workers = nullptr);
+
+    /**
+     * \brief      Appends the smaller levels after a RGBA8 image down to 1x1,
+     *             each one a 2x2 box filter of the previous. Colors are
+     *             weighted by their alpha, so transparent texels do not
+     *             darken the edges.
+     *
+     * \param      levels   The first level on input, the chain on output
+     * \param[in]  width    The width
+     * \param[in]  height   The height
+     * \param[in]  isSRGB   Filter in linear light
+     * \param      workers  Splits the rows among its threads, may be null
+     *
+     * \return     The number of levels.
+     */
+    static int BuildMipChain(std::vector<unsigned char>& levels, int width,
+        int height, bool isSRGB = true, ThreadPool* workers = nullptr);
+
+    /// Multiplies the colors of RGBA8 pixels by their alpha.
+    static void PremultiplyAlpha(unsigned char* pixels, size_t numPixels);
+
+    /**
+     * \brief      Picks the smallest format the options allow for an image.
+     *
+     * \param[in]  pixels       The RGBA8 pixels
+     * \param[in]  numPixels    The number of pixels
+     * \param[in]  options      The options
+     * \param      isAlphaMask  Set for white images with alpha
+     *
+     * \return     The format.
+     */
+    static PixelFormat ChooseFormat(const unsigned char* pixels,
+        size_t numPixels, const ImageOptions& options, bool* isAlphaMask);
+
+    /// Gets the bytes per texel of an uncompressed format.
+    static size_t GetPixelSize(PixelFormat format);
+
+    /// Gets the bytes of a level in any format, blocks rounded up.
+    static size_t GetLevelSize(PixelFormat format, int width, int height);
+
+    static bool IsBlockCompressed(PixelFormat format) {
+        return format == PixelFormat::BC1 || format == PixelFormat::BC3;
+    }
+
+    /**
+     * \brief      Converts RGBA8 pixels to another format.
+     *
+     * \param[in]  pixels       The RGBA8 pixels
+     * \param[in]  numPixels    The number of pixels
+     * \param[in]  format       The format
+     * \param[in]  isAlphaMask  R8 keeps the alpha instead of the red
+     * \param      out          The converted texels
+     */
+    static void Convert(const unsigned char* pixels, size_t numPixels,
+        PixelFormat format, bool isAlphaMask, unsigned char* out);
+};
+}  // namespace GangerEngine
+
+#endif  // _IMAGEPROCESSOR_H_
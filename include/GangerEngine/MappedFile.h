@@ -0,0 +1,89 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace GangerEngine {
+/// A read only view of a whole file. Big files are memory mapped, small ones
+/// and the ones that can not be mapped are read into a buffer it owns. The
+/// bytes stay valid until the file is closed, moved from or destroyed.
+///
+/// IOManager::MapFile also serves the entries of mounted packages, straight
+/// from the package mapping when they are stored uncompressed.
+class MappedFile {
+ public:
+    /// Smaller files are read, the copy costs less than setting up a mapping.
+    static const size_t MAP_THRESHOLD = 64 * 1024;
+
+    MappedFile();
+    ~MappedFile();
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * \brief      Opens a file on disk, mounted packages are not searched.
+     *
+     * \param[in]  filePath      The file path
+     * \param[in]  allowMapping  False to always read into a buffer
+     *
+     * \return     False if it could not be opened or read.
+     */
+    bool Open(const std::string& filePath, bool allowMapping = true);
+
+    /// Releases the view.
+    void Close();
+
+    bool IsOpen() const { return m_isOpen; }
+    /// True if the bytes come from a mapping of the file itself.
+    bool IsMapped() const { return m_isMapped; }
+
+    /// Gets the bytes, nullptr for empty files.
+    const unsigned char* GetData() const { return m_data; }
+    /// Gets the bytes as text. It is not null terminated, use GetSize.
+    const char* GetText() const {
+        return reinterpret_cast<const char*>(m_data);
+    }
+    size_t GetSize() const { return m_size; }
+
+ private:
+    friend class IOManager;
+
+    /// Views memory owned by someone else, like a package.
+    void SetView(const unsigned char* data, size_t size);
+    /// Takes a buffer of size bytes.
+    void SetBuffer(std::unique_ptr<unsigned char[]> buffer, size_t size);
+#ifndef _WIN32
+    /// Reads files that do not report their size.
+    bool ReadToEnd(int fd, const std::string& filePath);
+#endif
+
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    std::unique_ptr<unsigned char[]> m_buffer;  ///< When it was read
+    bool m_isOpen = false;
+    bool m_isMapped = false;
+};
+}  // namespace GangerEngine
+
+#endif  // _MAPPEDFILE_H_
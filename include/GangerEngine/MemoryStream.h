@@ -0,0 +1,55 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _MEMORYSTREAM_H_
+#define _MEMORYSTREAM_H_
+
+#include <GangerEngine/MappedFile.h>
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+
+namespace GangerEngine {
+/// An input stream over memory it does not own, so text files can be parsed
+/// with the stream operators straight from a MappedFile, without copying
+/// them into a string first. The memory must outlive the stream.
+class MemoryStream : public std::istream {
+ public:
+    MemoryStream(const char* data, size_t size) :
+        std::istream(nullptr), m_buffer(data, size) {
+        rdbuf(&m_buffer);
+    }
+
+    explicit MemoryStream(const MappedFile& file) :
+        MemoryStream(file.GetText(), file.GetSize()) {
+    }
+
+ private:
+    class Buffer : public std::streambuf {
+     public:
+        Buffer(const char* data, size_t size) {
+            // Only read from, the get area just has no const version
+            char* begin = const_cast<char*>(data);
+            setg(begin, begin, begin + size);
+        }
+    };
+
+    Buffer m_buffer;
+};
+}  // namespace GangerEngine
+
+#endif  // _MEMORYSTREAM_H_
@@ -0,0 +1,206 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _MIXER_H_
+#define _MIXER_H_
+
+#include <GangerEngine/SPSCQueue.h>
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace GangerEngine {
+/// Counters of the mixer.
+struct MixerStats {
+    int numActive = 0;  ///< Voices playing as of the last mix
+    uint64_t numFramesMixed = 0;
+    uint64_t numVoiceFramesMixed = 0;  ///< Frames mixed summed over voices
+    uint64_t numCommandsDropped = 0;  ///< The command queue was full
+};
+
+/// Mixes the effect voices into a 16 bit stereo stream, meant to run in
+/// the audio callback.
+///
+/// The game thread drives it with commands, and learns which voices ended
+/// from the events it sends back, both through lock free queues, so the
+/// audio thread never waits on the game. Voices play 16 bit stereo samples
+/// at the output rate, like the decoded chunks of SDL_mixer, which must
+/// outlive the voices playing them. Gains ramp over each block to avoid
+/// clicks, and positional voices are attenuated and panned against the
+/// listener on every block, so they follow it as it moves.
+class Mixer {
+ public:
+    Mixer();
+    ~Mixer();
+
+    /**
+     * \brief      Allocates the voices, before the audio thread mixes.
+     *
+     * \param[in]  numVoices    The number of voices
+     * \param[in]  blockFrames  The frames mixed at once
+     */
+    void Init(int numVoices, int blockFrames = 1024);
+
+    // Game thread
+
+    /**
+     * \brief      Starts a voice, cutting whatever it was playing.
+     *
+     * \param[in]  voice      The voice
+     * \param[in]  serial     Given back when it ends, see PopFinished
+     * \param[in]  samples    Interleaved 16 bit stereo
+     * \param[in]  numFrames  The number of frames
+     * \param[in]  loops      If loops == -1, loops forever
+     *                        otherwise play it loops+1 times
+     * \param[in]  gain       The gain
+     * \param[in]  pan        From -1, left, to 1, right
+     *
+     * \return     False if the command queue is full.
+     */
+    bool Play(int voice, uint32_t serial, const int16_t* samples,
+        uint32_t numFrames, int loops, float gain, float pan = 0.0f);
+
+    /// Play, attenuated and panned by the position relative to the listener.
+    bool PlayAt(int voice, uint32_t serial, const int16_t* samples,
+        uint32_t numFrames, int loops, float gain,
+        const glm::vec2& position);
+
+    /// Stops a voice. False if the command queue is full, it plays on.
+    bool Stop(int voice);
+    /// Sets the gain of a voice. False if the command queue is full.
+    bool SetGain(int voice, float gain);
+
+    /**
+     * \brief      Sets where the positional voices are heard from.
+     *
+     * \param[in]  position     The listener position
+     * \param[in]  minDistance  Closer voices are heard at their full gain
+     * \param[in]  maxDistance  Farther voices are not heard
+     *
+     * \return     False if the command queue is full.
+     */
+    bool SetListener(const glm::vec2& position, float minDistance,
+        float maxDistance);
+
+    /**
+     * \brief      Gets a voice that ended by itself.
+     *
+     * \param      voice   The voice
+     * \param      serial  The serial it was started with
+     *
+     * \return     False if none is left.
+     */
+    bool PopFinished(int* voice, uint32_t* serial);
+
+    /**
+     * \brief      Cuts every voice playing some samples, so they can be
+     *             freed. Only call it with the audio thread locked out, see
+     *             SDL_LockAudio, it applies the queued commands itself.
+     *
+     * \param[in]  samples  The samples
+     */
+    void Drop(const int16_t* samples);
+
+    /// Uses the scalar kernels instead of the SIMD ones, to compare them.
+    void SetSIMDEnabled(bool isEnabled) { m_isSIMDEnabled = isEnabled; }
+
+    MixerStats GetStats() const;
+
+    // Audio thread
+
+    /**
+     * \brief      Adds the voices to a stream, saturating.
+     *
+     * \param      stream     Interleaved 16 bit stereo
+     * \param[in]  numFrames  The number of frames
+     */
+    void Mix(int16_t* stream, int numFrames);
+
+    /// The gain of a sound at some distance from the listener.
+    static float GetAttenuation(float distance, float minDistance,
+        float maxDistance);
+    /// The pan of a sound at some offset from the listener.
+    static float GetPan(const glm::vec2& offset, float minDistance);
+
+ private:
+    enum class CommandType {
+        PLAY,
+        STOP,
+        SET_GAIN,
+        SET_LISTENER,
+    };
+
+    struct Command {
+        CommandType type;
+        int voice;
+        uint32_t serial;
+        const int16_t* samples;
+        uint32_t numFrames;
+        int loops;
+        float gain;
+        float pan;
+        bool isPositional;
+        glm::vec2 position;  ///< Of the voice or the listener
+        float minDistance;
+        float maxDistance;
+    };
+
+    struct Finished {
+        int voice;
+        uint32_t serial;
+    };
+
+    struct Voice {
+        const int16_t* samples = nullptr;  ///< nullptr when idle
+        uint32_t numFrames = 0;
+        uint32_t cursor = 0;  ///< The next frame
+        int loops = 0;
+        uint32_t serial = 0;
+        float gain = 0.0f;
+        float pan = 0.0f;
+        bool isPositional = false;
+        glm::vec2 position = glm::vec2(0.0f);
+        float left = 0.0f;  ///< The gains the last block ended with
+        float right = 0.0f;
+    };
+
+    bool PushCommand(const Command& command);
+    void ProcessCommands();
+    void MixBlock(int numFrames);
+    void GetGains(const Voice& voice, float* left, float* right) const;
+
+    SPSCQueue<Command> m_commands;
+    SPSCQueue<Finished> m_finished;
+
+    // Only touched by the audio thread once Init returns
+    std::vector<Voice> m_voices;
+    std::vector<float> m_buffer;  ///< One block of interleaved frames
+    glm::vec2 m_listener = glm::vec2(0.0f);
+    float m_minDistance = 1.0f;
+    float m_maxDistance = 1.0f;
+
+    std::atomic<bool> m_isSIMDEnabled{true};
+    std::atomic<int> m_numActive{0};
+    std::atomic<uint64_t> m_numFramesMixed{0};
+    std::atomic<uint64_t> m_numVoiceFramesMixed{0};
+    uint64_t m_numCommandsDropped = 0;  ///< Only touched by the game thread
+};
+}  // namespace GangerEngine
+
+#endif  // _MIXER_H_
@@ -0,0 +1,170 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _MUSICSTREAM_H_
+#define _MUSICSTREAM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Mix_Chunk;
+
+namespace GangerEngine {
+/// Counters of the music stream.
+struct MusicStreamStats {
+    int bufferFrames = 0;  ///< The depth of the ring buffer
+    int bufferedFrames = 0;  ///< Decoded and not played yet
+    uint64_t numFramesDecoded = 0;
+    uint64_t numUnderruns = 0;  ///< Callbacks the decoder fell behind in
+    size_t cacheBytes = 0;  ///< Taken by the songs kept decoded
+};
+
+/// Plays one song at a time, decoded ahead on a thread of its own.
+///
+/// The decoder thread keeps a ring buffer of 16 bit stereo PCM at the output
+/// rate filled, and the audio callback only copies out of it. Loop points
+/// are applied by the decoder, so the jump back is as seamless as the rest
+/// of the stream. Wav files are decoded as they play, straight from a
+/// mapping of the file. Other formats, ogg among them, have no streaming
+/// decoder here, so SDL_mixer decodes them whole on a thread of their own.
+/// They are kept decoded, at 10 MB per minute of 44.1 kHz stereo, so only
+/// their first play waits for the decode, and Preload takes that wait out of
+/// the first play too. The least recently played are dropped past the cache
+/// budget.
+///
+/// Stop never waits for a decode, it goes on for the cache.
+class MusicStream {
+ public:
+    MusicStream();
+    ~MusicStream();
+
+    /**
+     * \brief      Sets up the stream, the audio device must be open.
+     *
+     * \param[in]  sampleRate    The output rate
+     * \param[in]  bufferFrames  The depth of the ring buffer
+     */
+    void Init(int sampleRate, int bufferFrames);
+
+    /// Changes the depth of the ring buffer from the next Play on.
+    void SetBufferFrames(int bufferFrames);
+
+    /**
+     * \brief      Starts a song, stopping the one playing.
+     *
+     * \param[in]  filePath   The file path
+     * \param[in]  loops      If loops == -1, loops forever
+     *                        otherwise play it loops times
+     * \param[in]  loopStart  Where a loop jumps back to, in seconds
+     * \param[in]  loopEnd    Where a loop jumps back from, in seconds. The
+     *                        last play goes on to the end. 0 for the end.
+     */
+    void Play(const std::string& filePath, int loops, double loopStart = 0.0,
+        double loopEnd = 0.0);
+    /**
+     * \brief      Decodes a song that can not be streamed on a thread of its
+     *             own, so its first play does not wait for it. Wav files are
+     *             streamed and skip it.
+     *
+     * \param[in]  filePath  The file path
+     */
+    void Preload(const std::string& filePath);
+    /// Frees the songs kept decoded, a song playing keeps its own until it
+    /// stops. The ones still decoding are kept.
+    void ClearCache();
+    /// Sets the bytes of decoded songs kept, dropping down to it. A song
+    /// over it is not kept. 64 MB by default.
+    void SetCacheBudget(size_t bytes);
+    void Pause();
+    void Resume();
+    void Stop();
+
+    void SetVolume(float volume) { m_volume = volume; }
+
+    /// False once the song ended, or if it was stopped.
+    bool IsPlaying() const;
+
+    MusicStreamStats GetStats() const;
+
+    /**
+     * \brief      Adds the song to a stream, saturating. Called by the audio
+     *             callback.
+     *
+     * \param      stream     Interleaved 16 bit stereo
+     * \param[in]  numFrames  The number of frames
+     */
+    void Mix(int16_t* stream, int numFrames);
+
+ private:
+    typedef std::shared_future<std::shared_ptr<Mix_Chunk> > ChunkFuture;
+
+    struct CachedChunk {
+        ChunkFuture chunk;
+        uint64_t lastUse = 0;
+    };
+
+    void Decode(std::string filePath, int loops, double loopStart,
+        double loopEnd);
+    /// Finds a song kept decoded, or starts decoding it.
+    ChunkFuture LoadChunk(const std::string& filePath);
+    /// Drops the least recently used songs while over the budget, with
+    /// m_chunkMutex held.
+    void TrimCache();
+    /// Waits for a song to decode. Returns false once the stream is
+    /// stopping.
+    bool WaitForChunk(const ChunkFuture& chunk);
+    /// Waits a little for the audio callback to free some room. Returns
+    /// false once the stream is stopping.
+    bool WaitForRoom();
+
+    int m_sampleRate = 44100;
+    int m_bufferFrames = 0;
+
+    std::vector<int16_t> m_ring;
+    size_t m_ringMask = 0;  ///< The frames it holds minus one
+    std::atomic<uint64_t> m_readFrame{0};  ///< Written by the callback
+    std::atomic<uint64_t> m_writeFrame{0};  ///< Written by the decoder
+
+    std::atomic<bool> m_isActive{false};  ///< Between Play and Stop
+    std::atomic<bool> m_isPrimed{false};  ///< The buffer was filled once
+    std::atomic<bool> m_isDecoded{false};  ///< The decoder reached the end
+    std::atomic<bool> m_isPaused{false};
+    std::atomic<float> m_volume{1.0f};
+    std::atomic<uint64_t> m_numFramesDecoded{0};
+    std::atomic<uint64_t> m_numUnderruns{0};
+
+    std::thread m_decoderThread;
+    std::mutex m_mutex;
+    std::condition_variable m_stopCondition;
+    bool m_isStopping = false;
+
+    mutable std::mutex m_chunkMutex;
+    std::map<std::string, CachedChunk> m_chunks;  ///< Songs kept decoded
+    uint64_t m_chunkUseCounter = 0;
+    size_t m_cacheBudget = 64 * 1024 * 1024;
+};
+}  // namespace GangerEngine
+
+#endif  // _MUSICSTREAM_H_
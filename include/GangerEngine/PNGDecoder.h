@@ -0,0 +1,94 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _PNGDECODER_H_
+#define _PNGDECODER_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace GangerEngine {
+/// The png decoders to pick from.
+enum class PNGDecoderType {
+    FAST,  ///< DecodePNGFast, PicoPNG for the formats it leaves out
+    PICOPNG  ///< The reference decoder only
+};
+
+/// The error codes of ReadPNGSize and DecodePNGFast start here, above the
+/// ones of PicoPNG, so the logs tell the decoders apart.
+const int PNG_ERROR_BASE = 1000;
+/// Returned by DecodePNGFast for valid pngs it leaves to PicoPNG.
+const int PNG_ERROR_UNSUPPORTED = PNG_ERROR_BASE + 1;
+
+/**
+ * \brief      Reads the size of a png from its header.
+ *
+ * \param[in]  in      The png file contents
+ * \param[in]  size    The size of the contents
+ * \param      width   The width
+ * \param      height  The height
+ *
+ * \return     0 on success, an error code otherwise.
+ */
+int ReadPNGSize(const unsigned char* in, size_t size, unsigned long& width,
+    unsigned long& height);
+
+/**
+ * \brief      Decodes a png straight into the caller's RGBA8 buffer, top row
+ *             first. The inflate is table driven and the scanlines are
+ *             unfiltered with SSE2 where available.
+ *
+ *             It covers the 8 bit, non interlaced pngs of every color type,
+ *             which is what image editors export. Other bit depths and
+ *             interlaced images return PNG_ERROR_UNSUPPORTED; PicoPNG
+ *             decodes those. Like PicoPNG, the CRCs and the Adler-32 are not
+ *             checked.
+ *
+ * \param[in]  in       The png file contents
+ * \param[in]  size     The size of the contents
+ * \param      out      The pixels, width * height * 4 bytes
+ * \param[in]  outSize  The size of out
+ *
+ * \return     0 on success, an error code otherwise.
+ */
+int DecodePNGFast(const unsigned char* in, size_t size, unsigned char* out,
+    size_t outSize);
+
+/// Like DecodePNG, sizing the image to the png.
+int DecodePNGFast(std::vector<unsigned char>& outImage,
+    unsigned long& width, unsigned long& height, const unsigned char* in,
+    size_t size);
+
+/**
+ * \brief      Decodes a png to RGBA8 with the given decoder. The fast one
+ *             hands the pngs it fails on to PicoPNG, so a file it does not
+ *             cover or rejects only fails when PicoPNG fails too.
+ *
+ * \param      outImage  The pixels, top row first
+ * \param      width     The width
+ * \param      height    The height
+ * \param[in]  in        The png file contents
+ * \param[in]  size      The size of the contents
+ * \param[in]  decoder   The decoder
+ *
+ * \return     0 on success, the decoder error code otherwise.
+ */
+int DecodePNGImage(std::vector<unsigned char>& outImage,
+    unsigned long& width, unsigned long& height, const unsigned char* in,
+    size_t size, PNGDecoderType decoder = PNGDecoderType::FAST);
+}  // namespace GangerEngine
+
+#endif  // _PNGDECODER_H_
@@ -20,11 +20,14 @@
 #include <GangerEngine/Vertex.h>
 #include <GangerEngine/SpriteBatch.h>
 #include <GangerEngine/GLTexture.h>
+#include <GangerEngine/ParticleCollision2D.h>
 
 #include <glm/glm.hpp>
 #include <functional>
 
 namespace GangerEngine {
+class DecalLayer2D;
+
 class Particle2D {
  public:
     glm::vec2 position = glm::vec2(0.0f);
@@ -55,9 +58,138 @@ class ParticleBatch2D {
     void AddParticle(const glm::vec2& position, const glm::vec2& velocity,
         const ColorRGBA8& color, float width);
 
+    /**
+     * \brief      Adds many particles in a single pass over the free slots.
+     *             The spawn scale is applied to the whole group, and spawns
+     *             that don't fit in a full batch are dropped.
+     *
+     * \param[in]  count      The number of particles
+     * \param[in]  positionX  The x positions
+     * \param[in]  positionY  The y positions
+     * \param[in]  velocityX  The x velocities
+     * \param[in]  velocityY  The y velocities
+     * \param[in]  colors     The colors
+     * \param[in]  widths     The widths
+     *
+     * \return     The number of particles added.
+     */
+    int AddParticles(int count, const float* positionX,
+        const float* positionY, const float* velocityX,
+        const float* velocityY, const ColorRGBA8* colors,
+        const float* widths);
+
+    /**
+     * \brief      Sets the world particles collide with during the update.
+     *             The tile grid and circle hash must outlive the batch.
+     *
+     * \param[in]  collision  The collision settings, default for none
+     */
+    void SetCollision(const ParticleCollision2D& collision) {
+        m_collision = collision;
+    }
+
+    /**
+     * \brief      Bakes particles into a decal layer instead of letting them
+     *             vanish, so long lived effects stop costing per particle.
+     *
+     * \param[in]  decalLayer   The decal layer, nullptr to stop baking
+     * \param[in]  staticSpeed  Particles slower than this are baked right
+     *                          away, 0 to only bake expired particles
+     */
+    void SetDecalLayer(DecalLayer2D* decalLayer, float staticSpeed = 0.0f) {
+        m_decalLayer = decalLayer;
+        m_staticSpeed = staticSpeed;
+    }
+
+    /**
+     * \brief      Sets the priority. When a ParticleBudget is over budget,
+     *             lower priority batches are throttled first.
+     *
+     * \param[in]  priority  The priority
+     */
+    void SetPriority(int priority) { m_priority = priority; }
+
+    /**
+     * \brief      Sets whether the batch is on screen. Off-screen batches are
+     *             simulated at a reduced rate and catch up on the first update
+     *             after they become visible. ParticleEngine2D sets it from the
+     *             batch bounds when it has a camera.
+     *
+     * \param[in]  visible  True if visible
+     */
+    void SetVisible(bool visible) { m_visible = visible; }
+
+    /**
+     * \brief      Sets how many updates an off-screen batch skips per
+     *             simulated update.
+     *
+     * \param[in]  divisor  The off-screen simulation rate divisor
+     */
+    void SetOffscreenDivisor(int divisor) { m_offscreenDivisor = divisor; }
+
+    /**
+     * \brief      Gets the bounding box of the live particles, grown to cover
+     *             any motion still pending from skipped updates.
+     *
+     * \return     The bounds as (x, y, width, height).
+     */
+    glm::vec4 GetBounds() const;
+
+    /**
+     * \brief      Sets the fraction of AddParticle calls that actually spawn.
+     *
+     * \param[in]  scale  The spawn scale, from 0 to 1
+     */
+    void SetSpawnScale(float scale) { m_spawnScale = scale; }
+
+    /**
+     * \brief      Sets the lifetime scale. Particles decay 1/scale times faster.
+     *
+     * \param[in]  scale  The lifetime scale, from 0 to 1
+     */
+    void SetLifeScale(float scale) { m_lifeScale = scale; }
+
+    /**
+     * \brief      Further divides the simulation rate while off-screen.
+     *
+     * \param[in]  divisor  The simulation rate divisor, 1 is no extra skipping
+     */
+    void SetSimulationDivisor(int divisor) { m_simulationDivisor = divisor; }
+
+    int GetPriority() const { return m_priority; }
+    bool IsVisible() const { return m_visible; }
+    float GetSpawnScale() const { return m_spawnScale; }
+    float GetLifeScale() const { return m_lifeScale; }
+    int GetSimulationDivisor() const { return m_simulationDivisor; }
+    int GetMaxParticles() const { return m_maxParticles; }
+    /// Live particles as of the last update.
+    int GetNumActiveParticles() const { return m_numActiveParticles; }
+
+    /**
+     * \brief      Gets and resets the number of spawns dropped by the spawn
+     *             scale since the last call.
+     *
+     * \return     The dropped spawns.
+     */
+    unsigned int TakeDroppedSpawns() {
+        unsigned int dropped = m_droppedSpawns;
+        m_droppedSpawns = 0;
+        return dropped;
+    }
+
  private:
     int FindFreeParticle();
 
+    /// Grows the bounds to hold a newly added particle
+    void AddToBounds(const glm::vec2& position, const glm::vec2& velocity,
+        float width);
+
+    /// Advances all the live particles by deltaTime
+    void Simulate(float deltaTime);
+
+    /// Bounces or kills a particle that moved into the collision world
+    void Collide(Particle2D* p, const glm::vec2& previousPosition);
+
     /// Function pointer for custom updates
     std::function<void(Particle2D*, float)> m_updateFunc;
 
@@ -65,7 +197,28 @@ class ParticleBatch2D {
     Particle2D* m_particles = nullptr;
     int m_maxParticles = 0;
     int m_lastFreeParticle = 0;
+    int m_numActiveParticles = 0;
     GLTexture m_texture;
+    ParticleCollision2D m_collision;
+    DecalLayer2D* m_decalLayer = nullptr;
+    float m_staticSpeed = 0.0f;
+
+    // Budget controls
+    int m_priority = 0;
+    bool m_visible = true;
+    float m_spawnScale = 1.0f;
+    float m_spawnCredit = 0.0f;
+    unsigned int m_droppedSpawns = 0;
+    float m_lifeScale = 1.0f;
+    int m_simulationDivisor = 1;
+
+    // Off-screen level of detail
+    int m_offscreenDivisor = 4;
+    int m_skippedUpdates = 0;
+    float m_pendingDeltaTime = 0.0f;
+    glm::vec2 m_boundsMin = glm::vec2(0.0f);
+    glm::vec2 m_boundsMax = glm::vec2(0.0f);
+    float m_maxSpeed = 0.0f;
 };
 }  // namespace GangerEngine
 
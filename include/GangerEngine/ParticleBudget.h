@@ -0,0 +1,83 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _PARTICLEBUDGET_H_
+#define _PARTICLEBUDGET_H_
+
+#include <vector>
+
+namespace GangerEngine {
+class ParticleBatch2D;
+
+/// What the particle budget measured and throttled on the last frame.
+struct ParticleBudgetStats {
+    int liveParticles = 0;  ///< Live particles across all the batches
+    float updateMilliseconds = 0.0f;  ///< Time spent updating particles
+    float drawMilliseconds = 0.0f;  ///< Time spent drawing particles
+    float pressure = 0.0f;  ///< Load relative to the budget, 1 is at budget
+    float throttle = 0.0f;  ///< Current throttle level, 0 none, 1 maximum
+    int throttledBatches = 0;  ///< Batches running with reduced settings
+    int slowedBatches = 0;  ///< Off-screen batches with a reduced sim rate
+    unsigned int droppedSpawns = 0;  ///< Spawns discarded since last frame
+};
+
+/// Keeps the particle batches of a ParticleEngine2D under a global budget
+/// of live particles and milliseconds per frame.
+class ParticleBudget {
+ public:
+    /**
+     * \brief      Sets the budget. A limit of zero disables that limit.
+     *
+     * \param[in]  maxParticles     The maximum live particles
+     * \param[in]  maxMilliseconds  The maximum update plus draw time
+     */
+    void Init(int maxParticles, float maxMilliseconds);
+
+    /**
+     * \brief      Measures the batches and adjusts their spawn, lifetime and
+     *             simulation rate scales. Lower priority batches are
+     *             throttled first.
+     *
+     * \param[in]  batches             The batches to govern
+     * \param[in]  updateMilliseconds  The update time of the last frame
+     * \param[in]  drawMilliseconds    The draw time of the last frame
+     */
+    void Govern(const std::vector<ParticleBatch2D*>& batches,
+        float updateMilliseconds, float drawMilliseconds);
+
+    /// Returns true if any limit is set.
+    bool IsEnabled() const {
+        return m_maxParticles > 0 || m_maxMilliseconds > 0.0f;
+    }
+
+    /**
+     * \brief      Gets the stats of the last governed frame.
+     *
+     * \return     The stats.
+     */
+    const ParticleBudgetStats& GetStats() const { return m_stats; }
+
+ private:
+    int m_maxParticles = 0;
+    float m_maxMilliseconds = 0.0f;
+    float m_smoothedMilliseconds = 0.0f;
+    float m_throttle = 0.0f;
+    ParticleBudgetStats m_stats;
+    std::vector<ParticleBatch2D*> m_sortedBatches;  ///< Lowest priority first
+};
+}  // namespace GangerEngine
+
+#endif  // _PARTICLEBUDGET_H_
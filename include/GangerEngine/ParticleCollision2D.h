@@ -0,0 +1,142 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _PARTICLECOLLISION2D_H_
+#define _PARTICLECOLLISION2D_H_
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace GangerEngine {
+/// What happens to a particle that hits something
+enum class ParticleCollisionResponse {
+    BOUNCE,
+    KILL
+};
+
+/// A grid of solid tiles packed one bit per tile.
+class TileOccupancyGrid {
+ public:
+    /**
+     * \brief      Sets up an empty grid.
+     *
+     * \param[in]  origin    The world position of the bottom left tile
+     * \param[in]  tileSize  The world size of a tile
+     * \param[in]  width     The width in tiles
+     * \param[in]  height    The height in tiles
+     */
+    void Init(const glm::vec2& origin, float tileSize, int width, int height);
+
+    /**
+     * \brief      Marks a tile as solid or empty.
+     *
+     * \param[in]  x      The tile x
+     * \param[in]  y      The tile y
+     * \param[in]  solid  True if solid
+     */
+    void SetSolid(int x, int y, bool solid);
+
+    /// Returns true if the tile is solid. Tiles outside the grid are empty.
+    bool IsSolid(int x, int y) const {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+            return false;
+        return (m_bits[y * m_wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    /// Returns true if the world position is inside a solid tile.
+    bool IsSolidAt(const glm::vec2& position) const {
+        glm::vec2 tile = (position - m_origin) * m_invTileSize;
+        return IsSolid(static_cast<int>(std::floor(tile.x)),
+            static_cast<int>(std::floor(tile.y)));
+    }
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    float GetTileSize() const { return m_tileSize; }
+
+ private:
+    glm::vec2 m_origin = glm::vec2(0.0f);
+    float m_tileSize = 1.0f;
+    float m_invTileSize = 1.0f;
+    int m_width = 0;
+    int m_height = 0;
+    int m_wordsPerRow = 0;
+    std::vector<uint64_t> m_bits;
+};
+
+/// Circles bucketed in a uniform grid for fast point queries.
+class CircleSpatialHash {
+ public:
+    /**
+     * \brief      Sets the cell size and removes all the circles.
+     *
+     * \param[in]  cellSize  The cell size, about the typical circle diameter
+     */
+    void Init(float cellSize);
+
+    /// Removes all the circles, keeping the allocated memory.
+    void Clear();
+
+    /**
+     * \brief      Adds a circle.
+     *
+     * \param[in]  center  The center
+     * \param[in]  radius  The radius
+     */
+    void AddCircle(const glm::vec2& center, float radius);
+
+    /**
+     * \brief      Finds a circle that contains a point.
+     *
+     * \param[in]  point   The point
+     * \param[out] center  The center of the circle found
+     * \param[out] radius  The radius of the circle found
+     *
+     * \return     True if the point is inside a circle.
+     */
+    bool FindCircle(const glm::vec2& point, glm::vec2& center,
+        float& radius) const;
+
+ private:
+    struct Circle {
+        glm::vec2 center;
+        float radius;
+    };
+
+    static int64_t CellKey(int x, int y) {
+        return (static_cast<int64_t>(x) << 32) ^
+            static_cast<int64_t>(static_cast<uint32_t>(y));
+    }
+
+    float m_cellSize = 1.0f;
+    float m_invCellSize = 1.0f;
+    std::vector<Circle> m_circles;
+    std::unordered_map<int64_t, std::vector<int> > m_cells;
+};
+
+/// Collision settings for a ParticleBatch2D.
+struct ParticleCollision2D {
+    const TileOccupancyGrid* tiles = nullptr;  ///< Solid tiles, can be null
+    const CircleSpatialHash* circles = nullptr;  ///< Solid circles, can be null
+    ParticleCollisionResponse response = ParticleCollisionResponse::BOUNCE;
+    float restitution = 0.5f;  ///< Speed kept after a bounce
+};
+}  // namespace GangerEngine
+
+#endif  // _PARTICLECOLLISION2D_H_
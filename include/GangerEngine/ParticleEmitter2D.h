@@ -0,0 +1,130 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _PARTICLEEMITTER2D_H_
+#define _PARTICLEEMITTER2D_H_
+
+#include <GangerEngine/Vertex.h>
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GangerEngine {
+class ParticleBatch2D;
+
+/// The area particles are spawned in, around the emitter position
+enum class EmitterShape {
+    POINT,
+    CIRCLE,  ///< Uniform in a circle of radius size.x
+    BOX  ///< Uniform in a box of half extents size
+};
+
+/// Describes how an emitter spawns particles
+struct ParticleEmitterDesc {
+    float spawnRate = 0.0f;  ///< Particles per unit of deltaTime
+    int burstCount = 0;  ///< Particles spawned by Burst()
+    EmitterShape shape = EmitterShape::POINT;
+    glm::vec2 shapeSize = glm::vec2(0.0f);
+    float minSpeed = 0.0f;
+    float maxSpeed = 0.0f;
+    float minAngle = 0.0f;  ///< Velocity direction range in degrees
+    float maxAngle = 360.0f;
+    ColorRGBA8 minColor = ColorRGBA8(255, 255, 255, 255);
+    ColorRGBA8 maxColor = ColorRGBA8(255, 255, 255, 255);
+    float minWidth = 1.0f;
+    float maxWidth = 1.0f;
+};
+
+/// Spawns particles into a ParticleBatch2D from a data driven description.
+/// All the random values come from a counter based generator, so the same
+/// seed always spawns the same particles.
+class ParticleEmitter2D {
+ public:
+    /**
+     * \brief      Initializes the emitter.
+     *
+     * \param[in]  batch  The batch to spawn into
+     * \param[in]  desc   The emitter description
+     * \param[in]  seed   The random seed
+     */
+    void Init(ParticleBatch2D* batch, const ParticleEmitterDesc& desc,
+        uint32_t seed = 0);
+
+    /**
+     * \brief      Loads the emitter description from a text file. Each line
+     *             is a key followed by its values, # starts a comment:
+     *
+     *             rate 10
+     *             burst 5
+     *             shape circle 4
+     *             speed 1.5 2.5
+     *             angle 0 360
+     *             color 200 0 0 255 255 40 40 255
+     *             width 20 30
+     *
+     * \param[in]  filePath  The file path
+     * \param[out] desc      The loaded description
+     *
+     * \return     False if the file could not be read or parsed.
+     */
+    static bool LoadFromFile(const std::string& filePath,
+        ParticleEmitterDesc& desc);
+
+    /**
+     * \brief      Spawns particles at the spawn rate.
+     *
+     * \param[in]  deltaTime  The delta time
+     */
+    void Update(float deltaTime);
+
+    /// Spawns the burst count of particles.
+    void Burst() { Emit(m_desc.burstCount); }
+
+    /**
+     * \brief      Spawns particles in a single bulk add to the batch.
+     *
+     * \param[in]  count  The number of particles
+     */
+    void Emit(int count);
+
+    void SetPosition(const glm::vec2& position) { m_position = position; }
+    const glm::vec2& GetPosition() const { return m_position; }
+    const ParticleEmitterDesc& GetDesc() const { return m_desc; }
+
+ private:
+    /// Random float in [0, 1) for a particle counter and a value stream
+    float Random(uint32_t counter, uint32_t stream) const;
+
+    ParticleBatch2D* m_batch = nullptr;
+    ParticleEmitterDesc m_desc;
+    glm::vec2 m_position = glm::vec2(0.0f);
+    float m_spawnAccumulator = 0.0f;
+    uint32_t m_seed = 0;
+    uint32_t m_counter = 0;  ///< Particles spawned so far
+
+    // Structure of arrays scratch space for the bulk spawn
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_velocityX;
+    std::vector<float> m_velocityY;
+    std::vector<float> m_widths;
+    std::vector<ColorRGBA8> m_colors;
+};
+}  // namespace GangerEngine
+
+#endif  // _PARTICLEEMITTER2D_H_
@@ -17,11 +17,14 @@
 #ifndef _PARTICLEENGINE2D_H_
 #define _PARTICLEENGINE2D_H_
 
+#include <GangerEngine/ParticleBudget.h>
+
 #include <vector>
 
 namespace GangerEngine {
 class ParticleBatch2D;
 class SpriteBatch;
+class Camera2D;
 
 class ParticleEngine2D {
  public:
@@ -36,8 +39,44 @@ class ParticleEngine2D {
 
     void Draw(SpriteBatch* spriteBatch);
 
+    /**
+     * \brief      Sets the camera used to cull batches. Batches outside the
+     *             view are not drawn and are simulated at a reduced rate.
+     *
+     * \param[in]  camera  The camera, nullptr to treat all batches as visible
+     */
+    void SetCamera(Camera2D* camera) { m_camera = camera; }
+
+    /**
+     * \brief      Limits the particles of all the batches. When over budget,
+     *             spawns, lifetimes and off-screen simulation rates are scaled
+     *             down starting with the lowest priority batches.
+     *
+     * \param[in]  maxParticles     The maximum live particles, 0 for no limit
+     * \param[in]  maxMilliseconds  The maximum update plus draw time per
+     *                              frame, 0 for no limit
+     */
+    void SetBudget(int maxParticles, float maxMilliseconds) {
+        m_budget.Init(maxParticles, maxMilliseconds);
+    }
+
+    /**
+     * \brief      Gets what was measured and throttled on the last frame.
+     *
+     * \return     The budget stats.
+     */
+    const ParticleBudgetStats& GetBudgetStats() const {
+        return m_budget.GetStats();
+    }
+
  private:
+    /// Checks the batch bounds against the camera
+    bool IsBatchInView(const ParticleBatch2D* batch);
+
     std::vector<ParticleBatch2D*> m_batches;
+    Camera2D* m_camera = nullptr;
+    ParticleBudget m_budget;
+    float m_updateMilliseconds = 0.0f;  ///< Update time since the last draw
 };
 }  // namespace GangerEngine
 
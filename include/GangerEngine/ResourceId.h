@@ -0,0 +1,51 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _RESOURCEID_H_
+#define _RESOURCEID_H_
+
+#include <GangerEngine/Hash.h>
+
+#include <cstdint>
+#include <string>
+
+namespace GangerEngine {
+/// Names a resource by the hash of its path, so lookups never build or
+/// compare strings. From a string literal the hash is computed at compile
+/// time:
+///
+///     static constexpr ResourceId BRICKS("Textures/red_bricks.png");
+///
+/// The path is only kept as a pointer, used to load the resource on a miss,
+/// so it must outlive the call the id is passed to.
+struct ResourceId {
+    // Not explicit, so a plain path works wherever an id is taken
+    constexpr ResourceId(const char* path) :
+        path(path), hash(HashFNV1a(path)) {
+    }
+    /// Views a string path for the call the id is passed to. The id does
+    /// not own the path, so it must not outlive the string, nor be kept
+    /// once the string changes: build it at the call, ResourceId(path).
+    explicit ResourceId(const std::string& path) :
+        path(path.c_str()), hash(HashFNV1a(path)) {
+    }
+
+    const char* path;  ///< The path
+    uint64_t hash;  ///< The 64 bit FNV-1a hash of the path
+};
+}  // namespace GangerEngine
+
+#endif  // _RESOURCEID_H_
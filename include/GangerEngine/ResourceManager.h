@@ -18,18 +18,67 @@
 #define _RESOURCEMANAGER_H_
 
 #include <string>
+#include <vector>
 
+#include <GangerEngine/AssetPackage.h>
 #include <GangerEngine/TextureCache.h>
 
+#include <memory>
+
 namespace GangerEngine {
 // This is a way for us to access all our resources, such as
 // models or textures.
 class ResourceManager {
  public:
-    static GLTexture GetTexture(std::string texturePath);
+    /// Gets a texture kept until the next screen, see
+    /// TextureCache::GetTexture.
+    static GLTexture GetTexture(const ResourceId& texturePath);
+    /// Gets a texture without its path, see TextureCache::GetTextureRef.
+    static GLTextureRef GetTextureRef(const ResourceId& texture);
+    /// Gets a reference counted texture, see TextureCache::AcquireTexture.
+    static TextureHandle AcquireTexture(const ResourceId& texturePath);
+    /// Sets the GPU memory budget of the unreferenced textures, see
+    /// TextureCache::SetMemoryBudget.
+    static void SetTextureMemoryBudget(size_t bytes);
+    /// Evicts every unreferenced texture.
+    static void EvictUnusedTextures();
+    /// Starts a texture scope, see TextureCache::BeginScope. IMainGame calls
+    /// it on every screen change.
+    static void BeginTextureScope();
+    /// Keeps a texture loaded across screens, see TextureCache::PinTexture.
+    static void PinTexture(const ResourceId& texturePath);
+    /// Gets the texture cache counters.
+    static TextureCacheStats GetTextureStats();
+
+    /// Loads a texture in the background, see TextureCache::GetTextureAsync.
+    static GLTexture GetTextureAsync(const ResourceId& texturePath);
+    /// Uploads pending textures within the budget, once per frame.
+    static void ProcessTextureUploads();
+    /// Blocks until a group of async textures is ready.
+    static void WaitForTextures(std::vector<GLTexture>& textures);
+    /// Checks if an async texture is ready.
+    static bool IsTextureReady(const ResourceId& texturePath);
+    /// Sets the texture upload budget in bytes per frame.
+    static void SetTextureUploadBudget(size_t bytesPerFrame);
+    /// Packs small textures into atlas pages, see TextureCache::SetAtlasMode.
+    static void SetAtlasMode(bool enabled, int pageSize = 2048,
+        int maxEntrySize = 256);
+    /// Sets how textures are prepared, see TextureCache::SetImageOptions.
+    static void SetImageOptions(const ImageOptions& options);
+
+    /**
+     * \brief      Maps a cooked package and mounts it, its textures and files
+     *             are used instead of the ones on disk. Mount before loading.
+     *
+     * \param[in]  packagePath  The package path
+     *
+     * \return     False if it is not a valid package.
+     */
+    static bool MountPackage(const std::string& packagePath);
 
  private:
     static TextureCache m_textureCache;
+    static std::vector<std::unique_ptr<AssetPackage> > m_packages;
 };
 }  // namespace GangerEngine
 
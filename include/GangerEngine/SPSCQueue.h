@@ -0,0 +1,87 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace GangerEngine {
+/// A bounded queue between exactly one producer thread and one consumer
+/// thread. Neither side ever locks nor allocates once it is created, so the
+/// audio thread can use it.
+template <typename T>
+class SPSCQueue {
+ public:
+    /**
+     * \brief      Creates the queue.
+     *
+     * \param[in]  capacity  Rounded up to a power of two
+     */
+    explicit SPSCQueue(size_t capacity = 1024) {
+        Resize(capacity);
+    }
+
+    /// Empties the queue and changes its capacity. Neither thread may be
+    /// using it meanwhile.
+    void Resize(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        m_items.assign(size, T());
+        m_mask = size - 1;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+    /// Producer only. Returns false if the queue is full.
+    bool Push(const T& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer only. Returns false if the queue is empty.
+    bool Pop(T* item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        *item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Only exact from one of the two threads.
+    size_t GetSize() const {
+        return m_tail.load(std::memory_order_acquire) -
+            m_head.load(std::memory_order_acquire);
+    }
+
+ private:
+    std::vector<T> m_items;
+    size_t m_mask;
+    std::atomic<size_t> m_head{0};
+    // Apart, so the two threads do not fight over one cache line
+    char m_padding[64];
+    std::atomic<size_t> m_tail{0};
+};
+}  // namespace GangerEngine
+
+#endif  // _SPSCQUEUE_H_
@@ -0,0 +1,152 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _SOUNDCACHE_H_
+#define _SOUNDCACHE_H_
+
+#include <SDL/SDL_mixer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace GangerEngine {
+class Mixer;
+
+/// How a sound is kept to be decoded again.
+enum class SoundStorage {
+    FILE,  ///< The file as loaded, decoded by SDL_mixer
+    ADPCM  ///< IMA ADPCM of the decoded samples, a byte a stereo frame
+};
+
+/// What the audio engine keeps of a loaded effect, shared by the
+/// SoundEffects handed out for it.
+struct SoundData {
+    std::vector<unsigned char> compact;  ///< Kept to decode it again
+    SoundStorage storage = SoundStorage::FILE;
+    uint32_t numFrames = 0;  ///< Decoded, for the ADPCM storage
+    Mix_Chunk* chunk = nullptr;  ///< The decoded samples, nullptr if evicted
+    int priority = 0;  ///< Higher priorities steal the voices of lower ones
+    int maxInstances = 0;  ///< Voices it may play on at once, 0 for any
+    int numInstances = 0;  ///< Voices it plays on now
+    uint64_t lastPlayed = 0;  ///< The cache clock when last played
+    uint64_t numPlays = 0;
+    uint64_t numDecodes = 0;
+};
+
+/// The memory held by one sound.
+struct SoundMemory {
+    std::string filePath;
+    SoundStorage storage = SoundStorage::FILE;
+    size_t compactBytes = 0;  ///< Always held
+    size_t pcmBytes = 0;  ///< Held while decoded
+    int numInstances = 0;
+    uint64_t lastPlayed = 0;
+    uint64_t numPlays = 0;
+    uint64_t numDecodes = 0;
+};
+
+/// Counters of the sound cache.
+struct SoundCacheStats {
+    size_t budget = 0;
+    size_t compactBytes = 0;
+    size_t pcmBytes = 0;  ///< May go over the budget while the rest plays
+    int numSounds = 0;
+    int numDecoded = 0;
+    uint64_t numHits = 0;  ///< Plays that found the samples decoded
+    uint64_t numDecodes = 0;
+    uint64_t numEvictions = 0;
+};
+
+/// Keeps the sound effects in memory in a compact form, and their decoded
+/// samples only as long as they fit in a budget.
+///
+/// The compact form is the file as loaded when it is the smaller, like an
+/// ogg, or else an IMA ADPCM encoding of the decoded samples, a quarter of
+/// their size. A wav at a higher rate than the device takes more memory
+/// than its decoded samples, so it is kept as ADPCM, which is lossy: the
+/// plays after an eviction sound slightly noisier than the first one. So a
+/// big library only keeps the effects played lately decoded. Playing an
+/// evicted effect decodes it again, and going over the budget evicts the
+/// least recently played effects that are not playing.
+class SoundCache {
+ public:
+    SoundCache();
+    ~SoundCache();
+
+    /**
+     * \brief      Sets up the cache, the audio device must be open.
+     *
+     * \param[in]  mixer  The mixer playing the samples, nullptr when
+     *                    SDL_mixer plays them
+     */
+    void Init(Mixer* mixer = nullptr);
+
+    /// Sets the bytes of decoded samples kept, evicting down to it.
+    void SetBudget(size_t bytes);
+
+    /**
+     * \brief      Loads a sound, or finds it loaded, and decodes it.
+     *
+     * \param[in]  filePath  The file path
+     *
+     * \return     nullptr if it can not be read or decoded.
+     */
+    SoundData* Load(const std::string& filePath);
+
+    /**
+     * \brief      Makes sure a sound about to play is decoded.
+     *
+     * \param      sound  The sound
+     *
+     * \return     False if it fails to decode.
+     */
+    bool Acquire(SoundData* sound);
+
+    /// Frees every sound, once nothing plays them.
+    void Clear();
+
+    SoundCacheStats GetStats() const;
+    /// Gets the memory of every sound, by file path.
+    void GetMemory(std::vector<SoundMemory>* sounds) const;
+
+ private:
+    bool Decode(SoundData* sound);
+    /// Keeps the ADPCM of the decoded samples instead of the file, when it
+    /// is the smaller.
+    void Compact(SoundData* sound);
+    /// Evicts until the samples fit in the budget, sparing a sound.
+    void Trim(const SoundData* keep);
+    void Evict(SoundData* sound);
+
+    std::map<std::string, SoundData> m_sounds;
+    Mixer* m_mixer = nullptr;
+    bool m_canEncode = false;  ///< The device takes 16 bit stereo
+
+    size_t m_budget = 64 * 1024 * 1024;
+    size_t m_compactBytes = 0;
+    size_t m_pcmBytes = 0;
+    int m_numDecoded = 0;
+    uint64_t m_clock = 0;  ///< Ticks on every play
+    uint64_t m_numHits = 0;
+    uint64_t m_numDecodes = 0;
+    uint64_t m_numEvictions = 0;
+};
+}  // namespace GangerEngine
+
+#endif  // _SOUNDCACHE_H_
@@ -0,0 +1,129 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _TEXTUREATLAS_H_
+#define _TEXTUREATLAS_H_
+
+#include <GangerEngine/GLTexture.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace GangerEngine {
+/// Packs small textures into shared pages with a skyline packer.
+///
+/// The textures it hands out carry a virtual id with ATLAS_ID_BIT set.
+/// SpriteBatch resolves it to the page id and remaps the uv rectangle, so
+/// sprites from the same page end up in one render batch. The remap follows
+/// the engine shaders, which sample at (u, 1 - v), and it only holds for uv
+/// rectangles inside [0, 1]: atlas textures can not repeat.
+class TextureAtlas {
+ public:
+    /// Marks the virtual ids, GL never hands out names this large.
+    static const GLuint ATLAS_ID_BIT = 0x80000000u;
+
+    TextureAtlas();
+    ~TextureAtlas();
+
+    /**
+     * \brief      Initializes the atlas.
+     *
+     * \param[in]  pageSize      The texels per side of a page
+     * \param[in]  padding       The extruded border around each entry, a
+     *                           power of two. It also caps the mip levels so
+     *                           neighbours never bleed in.
+     * \param[in]  maxEntrySize  Bigger textures are not accepted
+     */
+    void Init(int pageSize = 2048, int padding = 4, int maxEntrySize = 256);
+
+    /// Deletes the pages.
+    void Dispose();
+
+    /**
+     * \brief      Checks if a texture of this size goes into the atlas.
+     */
+    bool Accepts(int width, int height) const {
+        return m_pageSize > 0 && width <= m_maxEntrySize &&
+            height <= m_maxEntrySize;
+    }
+
+    /**
+     * \brief      Packs RGBA8 pixels into a page, opening a new one if needed.
+     *
+     * \param[in]  filePath  The file path stored in the texture
+     * \param[in]  pixels    The pixels, top row first
+     * \param[in]  width     The width
+     * \param[in]  height    The height
+     *
+     * \return     The texture with a virtual id.
+     */
+    GLTexture Add(const std::string& filePath, const unsigned char* pixels,
+        int width, int height);
+
+    int GetNumPages() const { return static_cast<int>(m_pages.size()); }
+    int GetPageSize() const { return m_pageSize; }
+
+    /**
+     * \brief      Turns a virtual id into its page id and remaps the uv
+     *             rectangle. Real ids are left untouched.
+     *
+     * \param      texture  The texture id
+     * \param      uvRect   The uv rectangle
+     */
+    static void Resolve(GLuint* texture, glm::vec4* uvRect) {
+        if ((*texture & ATLAS_ID_BIT) == 0) return;
+        ResolveRegion(texture, uvRect);
+    }
+
+    /// Rebuilds the mipmaps of the pages that got new entries.
+    static void UpdateMipmaps();
+
+ private:
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct Page {
+        GLuint id = 0;
+        std::vector<SkylineNode> skyline;
+    };
+
+    /// Where the virtual ids point to, shared by every atlas.
+    struct Region {
+        GLuint page;
+        glm::vec4 rect;  ///< x, y, width and height in page uvs
+    };
+
+    static void ResolveRegion(GLuint* texture, glm::vec4* uvRect);
+
+    void AddPage();
+    bool Pack(Page& page, int width, int height, int* x, int* y);
+
+    std::vector<Page> m_pages;
+    int m_pageSize = 0;
+    int m_padding = 4;
+    int m_maxEntrySize = 256;
+
+    static std::vector<Region> m_regions;
+    static std::vector<GLuint> m_dirtyPages;
+};
+}  // namespace GangerEngine
+
+#endif  // _TEXTUREATLAS_H_
@@ -17,22 +17,246 @@
 #ifndef _TEXTURECACHE_H_
 #define _TEXTURECACHE_H_
 
+#include <GangerEngine/AsyncIO.h>
+#include <GangerEngine/FlatHashMap.h>
 #include <GangerEngine/GLTexture.h>
+#include <GangerEngine/ImageProcessor.h>
+#include <GangerEngine/ResourceId.h>
+#include <GangerEngine/TextureAtlas.h>
+#include <GangerEngine/TextureHandle.h>
+#include <GangerEngine/ThreadPool.h>
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <map>
+#include <vector>
 
 namespace GangerEngine {
+class AssetPackage;
+struct PackageEntry;
+
+/// Counters of the texture cache.
+struct TextureCacheStats {
+    size_t residentBytes = 0;  ///< Estimated GPU bytes, atlas pages included
+    size_t budgetBytes = 0;
+    int numTextures = 0;  ///< Known textures, resident or evicted
+    int numResident = 0;
+    int numReferenced = 0;  ///< With a live TextureHandle
+    uint64_t hits = 0;
+    uint64_t misses = 0;  ///< First loads and reloads
+    uint64_t reloads = 0;  ///< Misses on evicted textures
+    uint64_t evictions = 0;
+    uint64_t failures = 0;  ///< Background loads left with the placeholder
+};
+
 // This caches the textures so that multiple sprites can use the same textures
 class TextureCache {
  public:
     TextureCache();
     ~TextureCache();
 
-    GLTexture GetTexture(std::string texturePath);
+    /// Gets a texture. Nothing tells when a plain copy is gone, so it is
+    /// kept until the scope ends, see BeginScope, PinTexture and
+    /// AcquireTexture.
+    /// Callers that keep plain copies across scopes, like statics, must pin
+    /// the texture.
+    GLTexture GetTexture(const ResourceId& texturePath);
+
+    /**
+     * \brief      Gets a texture like GetTexture, without copying its path.
+     *             Once the texture is loaded this does not allocate, meant
+     *             for lookups every frame or tile.
+     *
+     * \param[in]  texture  The texture id
+     *
+     * \return     The texture.
+     */
+    GLTextureRef GetTextureRef(const ResourceId& texture);
+
+    /**
+     * \brief      Gets a reference counted texture. Once no handle points to
+     *             it, it can be evicted when the cache is over budget, and
+     *             it is reloaded the next time it is acquired.
+     *
+     * \param[in]  texturePath  The texture path
+     *
+     * \return     The handle.
+     */
+    TextureHandle AcquireTexture(const ResourceId& texturePath);
+
+    /**
+     * \brief      Sets the GPU memory the cache aims for. Unreferenced
+     *             textures are evicted, least recently used first, while the
+     *             resident bytes are over it. The textures handed out as
+     *             plain copies, by GetTexture, GetTextureRef or
+     *             GetTextureAsync, are only unreferenced once the scope they
+     *             were last handed out in ended, see BeginScope.
+     *
+     * \param[in]  bytes  The budget in bytes
+     */
+    void SetMemoryBudget(size_t bytes);
+
+    /// Evicts every unreferenced texture now, like between screens.
+    void EvictUnused();
+
+    /**
+     * \brief      Starts a scope of plain copies, like when a screen is
+     *             entered. The textures handed out as plain copies before
+     *             it, and not again since, count as unreferenced: the
+     *             budget and EvictUnused may evict them, and a stale copy
+     *             then points to a deleted texture.
+     */
+    void BeginScope();
+
+    /// Keeps a texture for good, for plain copies that outlive scopes.
+    void PinTexture(const ResourceId& texturePath);
+
+    /// Gets the counters.
+    TextureCacheStats GetStats() const;
+
+    /**
+     * \brief      Starts loading a texture without blocking. The png is
+     *             decoded on a worker thread and uploaded by ProcessUploads.
+     *             Until then the returned id shows a transparent 1x1
+     *             placeholder and width and height are 0. A texture that
+     *             fails to load is logged and keeps the placeholder.
+     *
+     * \param[in]  texturePath  The texture path
+     *
+     * \return     The texture, real or placeholder.
+     */
+    GLTexture GetTextureAsync(const ResourceId& texturePath);
+
+    /**
+     * \brief      Uploads decoded textures, at most the budget in bytes per
+     *             call. Call it once per frame from the GL thread.
+     */
+    void ProcessUploads();
+
+    /**
+     * \brief      Blocks until every texture of the group is decoded and
+     *             uploaded, or failed to load, then refreshes the group with
+     *             the real sizes.
+     *
+     * \param      textures  The textures returned by GetTextureAsync
+     */
+    void WaitForTextures(std::vector<GLTexture>& textures);
+
+    /**
+     * \brief      Checks if a texture has finished loading.
+     *
+     * \param[in]  texturePath  The texture path
+     *
+     * \return     True if it is uploaded, or failed to load and keeps
+     *             the placeholder.
+     */
+    bool IsTextureReady(const ResourceId& texturePath);
+
+    /**
+     * \brief      Sets how many bytes ProcessUploads may send per call. At
+     *             least one row is sent for every texture in flight.
+     *
+     * \param[in]  bytesPerFrame  The bytes per frame
+     */
+    void SetUploadBudget(size_t bytesPerFrame) {
+        m_uploadBudget = bytesPerFrame;
+    }
+
+    size_t GetNumPending() const { return m_pending.size(); }
+
+    /**
+     * \brief      Packs the small textures loaded by GetTexture from now on
+     *             into shared atlas pages, so SpriteBatch can draw them in one
+     *             batch. Only for sprites that keep their uvs inside [0, 1].
+     *             Needs a GL context.
+     *
+     * \param[in]  enabled       If the atlas is used
+     * \param[in]  pageSize      The texels per side of a page
+     * \param[in]  maxEntrySize  Bigger textures keep their own GL texture
+     */
+    void SetAtlasMode(bool enabled, int pageSize = 2048,
+        int maxEntrySize = 256);
+
+    /**
+     * \brief      Sets how the textures loaded from now on are prepared. The
+     *             mip chain, premultiplication and format conversion run on
+     *             the worker threads, so the GL thread only uploads.
+     *             Cooked textures keep the mips they were cooked with.
+     *
+     * \param[in]  options  The options
+     */
+    void SetImageOptions(const ImageOptions& options) {
+        m_imageOptions = options;
+    }
 
  private:
-    std::map<std::string, GLTexture> m_textureMap;
+    /// A texture on its way from disk to the GPU.
+    struct PendingTexture {
+        std::string filePath;
+        GLuint id = 0;  ///< The id handed out with the placeholder
+        GLuint pixelBuffer = 0;  ///< Staging unpack buffer
+        IORequestId readRequest = 0;  ///< Reading the png, 0 if cooked
+        ImageOptions options;  ///< Taken when the load started
+        ProcessedImage image;
+        size_t uploadedBytes = 0;
+        bool isDecoded = false;  ///< Guarded by m_mutex
+        bool isFailed = false;  ///< Guarded by m_mutex
+    };
+
+    friend class TextureHandle;
+
+    TextureEntry* Acquire(const ResourceId& texturePath);
+    /// Acquire for a plain copy, kept for the scope.
+    TextureEntry* AcquirePlain(const ResourceId& texturePath);
+    TextureEntry* FindEntry(const ResourceId& texturePath);
+    TextureEntry* AddEntry(const ResourceId& texturePath);
+    /// Called by the last handle of an entry.
+    void Release(TextureEntry* entry);
+    /// Evicts unreferenced textures until the resident bytes fit.
+    void Trim(size_t budget);
+    void Evict(TextureEntry* entry);
+    void MakeResident(TextureEntry* entry, const GLTexture& texture,
+        size_t bytes);
+    size_t GetAtlasBytes() const;
+    /// The options with what the GL context can not do turned off.
+    ImageOptions GetImageOptions() const;
+
+    GLTexture LoadTexture(const std::string& texturePath, size_t* bytes);
+    /// Reads a cooked texture, decompressing what the options rule out.
+    static bool ReadPackagedImage(const AssetPackage& package,
+        const PackageEntry& entry, const ImageOptions& options,
+        ProcessedImage* image);
+    /// Estimates the GPU bytes of an uploaded image.
+    static size_t GetImageBytes(const ProcessedImage& image);
+    /// Hands a decoded image over to the GL thread, from any thread.
+    void SetDecoded(PendingTexture* pending, ProcessedImage* image,
+        bool isDecoded);
+    bool WaitDecoded(PendingTexture& pending);
+    bool Upload(PendingTexture& pending, size_t maxBytes, size_t* sentBytes);
+    void FinishPending(size_t index);
+
+    /// A deque never moves its elements, so handles can point to them.
+    std::deque<TextureEntry> m_entries;
+    FlatHashMap<TextureEntry*> m_entryMap;  ///< By the hash of the path
+    size_t m_residentBytes = 0;
+    size_t m_memoryBudget = static_cast<size_t>(-1);
+    uint64_t m_useCounter = 0;
+    uint64_t m_scope = 1;  ///< The plain copies handed out now belong to it
+    TextureCacheStats m_stats;
+
+    TextureAtlas m_atlas;
+    bool m_isAtlasEnabled = false;
+    ImageOptions m_imageOptions;
+
+    std::vector<std::shared_ptr<PendingTexture> > m_pending;
+    ThreadPool m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_decodedCondition;
+    size_t m_uploadBudget = 1 << 20;
 };
 }  // namespace GangerEngine
 
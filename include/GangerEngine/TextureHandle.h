@@ -0,0 +1,76 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _TEXTUREHANDLE_H_
+#define _TEXTUREHANDLE_H_
+
+#include <GangerEngine/GLTexture.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GangerEngine {
+class TextureCache;
+
+/// A texture slot of the TextureCache, shared by all the handles to it.
+struct TextureEntry {
+    GLTexture texture;
+    TextureCache* cache = nullptr;
+    size_t bytes = 0;  ///< Estimated GPU bytes, mipmaps included
+    uint64_t lastUse = 0;  ///< For the LRU eviction
+    int refCount = 0;  ///< Live TextureHandles
+    uint64_t scope = 0;  ///< Last handed out as a plain GLTexture in it
+    bool isPinned = false;  ///< Never evicted, see TextureCache::PinTexture
+    bool isResident = false;  ///< Uploaded, false once evicted
+    bool isPending = false;  ///< Still loading in the background
+    bool isFailed = false;  ///< The background load failed, a placeholder
+};
+
+/// A reference counted texture. While a handle lives its texture stays on
+/// the GPU; once the last one goes the cache may evict it, and acquiring it
+/// again reloads it. Handles must be used and released on the GL thread.
+class TextureHandle {
+ public:
+    TextureHandle() {
+    }
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other);
+    ~TextureHandle();
+
+    TextureHandle& operator=(const TextureHandle& other);
+    TextureHandle& operator=(TextureHandle&& other);
+
+    /// Drops the reference.
+    void Reset();
+
+    bool IsValid() const { return m_entry != nullptr; }
+
+    /// Gets the texture, an empty one while not IsValid.
+    const GLTexture& GetTexture() const;
+    GLuint GetID() const { return m_entry ? m_entry->texture.id : 0; }
+    int GetWidth() const { return m_entry ? m_entry->texture.width : 0; }
+    int GetHeight() const { return m_entry ? m_entry->texture.height : 0; }
+
+ private:
+    friend class TextureCache;
+
+    explicit TextureHandle(TextureEntry* entry);
+
+    TextureEntry* m_entry = nullptr;
+};
+}  // namespace GangerEngine
+
+#endif  // _TEXTUREHANDLE_H_
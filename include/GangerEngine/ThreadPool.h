@@ -0,0 +1,87 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GangerEngine {
+/// A fixed set of worker threads draining a FIFO job queue.
+class ThreadPool {
+ public:
+    ThreadPool();
+    ~ThreadPool();
+
+    /**
+     * \brief      Starts the workers. Calling it again is a no-op.
+     *
+     * \param[in]  numThreads  The number of workers, 0 picks one less than
+     *                         the hardware threads (at least one).
+     */
+    void Init(unsigned int numThreads = 0);
+
+    /// Waits for the queued jobs and joins the workers.
+    void Dispose();
+
+    /**
+     * \brief      Queues a job to run on a worker thread.
+     *
+     * \param[in]  job   The job.
+     */
+    void Enqueue(std::function<void()> job);
+
+    /// Blocks until the queue is empty and no job is running.
+    void WaitIdle();
+
+    /**
+     * \brief      Splits [0, count) in chunks run by the workers and the
+     *             calling thread, and returns once every chunk is done. The
+     *             caller takes the chunks no worker picked up, so it is safe
+     *             to call from a job.
+     *
+     * \param[in]  count     The number of items
+     * \param[in]  grain     The items per chunk
+     * \param[in]  function  Called with the [begin, end) of each chunk
+     */
+    void ParallelFor(size_t count, size_t grain,
+        const std::function<void(size_t, size_t)>& function);
+
+    bool IsRunning() const { return !m_workers.empty(); }
+    unsigned int GetNumThreads() const {
+        return static_cast<unsigned int>(m_workers.size());
+    }
+
+ private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()> > m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_jobCondition;
+    std::condition_variable m_idleCondition;
+    int m_numBusy = 0;
+    bool m_isStopping = false;
+};
+}  // namespace GangerEngine
+
+#endif  // _THREADPOOL_H_
@@ -0,0 +1,141 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _VOICEMANAGER_H_
+#define _VOICEMANAGER_H_
+
+#include <GangerEngine/Mixer.h>
+#include <GangerEngine/SoundCache.h>
+
+#include <SDL/SDL_mixer.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace GangerEngine {
+/// Counters of the voices.
+struct VoiceStats {
+    int numVoices = 0;
+    int numActive = 0;
+    int peakActive = 0;  ///< The most voices playing at once
+    uint64_t numPlayed = 0;  ///< Started on a voice of their own
+    uint64_t numMerged = 0;  ///< Folded into the same sound of the frame
+    uint64_t numStolen = 0;  ///< Voices cut off for a more important sound
+    uint64_t numRejected = 0;  ///< Not played, nothing could be stolen
+};
+
+/// Hands out the voices of the engine Mixer, or the SDL_mixer channels
+/// when there is none, to the effects played.
+///
+/// When every voice is busy the least important one is stolen: the lowest
+/// priority, then the quietest, then the oldest. A sound only steals from
+/// lower priorities, or from its own priority when it is at least as loud,
+/// and is dropped otherwise. A sound at its instance limit steals the
+/// quietest of its own voices instead. The same sound played again in one
+/// frame, like every pellet of a shotgun, shares the voice of the first.
+/// Positional sounds are compared by how loud they are heard from the
+/// listener. A stop or listener change that does not fit in the mixer
+/// queue is retried on the next Update, and the voice stays taken until
+/// then.
+class VoiceManager {
+ public:
+    VoiceManager();
+    ~VoiceManager();
+
+    /**
+     * \brief      Allocates the voices, the audio device must be open.
+     *
+     * \param[in]  numVoices  The number of voices
+     * \param      mixer      Plays the voices, initialized with as many.
+     *                        nullptr plays them on SDL_mixer channels.
+     */
+    void Init(int numVoices, Mixer* mixer = nullptr);
+    /// Stops every voice.
+    void Dispose();
+
+    /**
+     * \brief      Plays a sound on a voice.
+     *
+     * \param      sound     The sound
+     * \param[in]  loops     If loops == -1, loops forever
+     *                       otherwise play it loops+1 times
+     * \param[in]  volume    From 0 to 1
+     * \param[in]  position  Optional, where the sound plays in the world
+     *
+     * \return     The voice, -1 if the sound was dropped.
+     */
+    int Play(SoundData* sound, int loops, float volume,
+        const glm::vec2* position = nullptr);
+
+    /// Stops the voices of a sound, before it is freed.
+    void Stop(const SoundData* sound);
+
+    /**
+     * \brief      Sets where the positional sounds are heard from.
+     *
+     * \param[in]  position     The listener position
+     * \param[in]  minDistance  Closer sounds are heard at their full volume
+     * \param[in]  maxDistance  Farther sounds are not heard
+     */
+    void SetListener(const glm::vec2& position, float minDistance,
+        float maxDistance);
+
+    /// Starts a new frame and frees the voices that finished. Call it once
+    /// per frame.
+    void Update();
+
+    VoiceStats GetStats();
+    /// Zeroes the counters, keeping the voice counts.
+    void ResetStats();
+
+ private:
+    struct Voice {
+        SoundData* sound = nullptr;  ///< nullptr when free
+        int loops = 0;
+        float gain = 0.0f;  ///< The volume asked for
+        float volume = 0.0f;  ///< How loud it is heard
+        bool isPositional = false;
+        glm::vec2 position = glm::vec2(0.0f);
+        uint32_t serial = 0;  ///< Tells apart the plays of a mixer voice
+        uint64_t order = 0;  ///< When it started, to find the oldest
+        uint64_t frame = 0;  ///< The frame it started in
+        bool isStopping = false;  ///< Its stop did not fit in the queue yet
+    };
+
+    /// Frees the voices that are done.
+    void Refresh();
+    /// Finds the voice to steal among those of a sound, or all if nullptr.
+    int FindVictim(const SoundData* sound) const;
+    bool Start(int voice, SoundData* sound, int loops, float gain,
+        float volume, const glm::vec2* position);
+    /// False if the voice plays on, its stop did not fit in the queue.
+    bool Halt(int voice);
+    void Release(int voice);
+
+    std::vector<Voice> m_voices;
+    Mixer* m_mixer = nullptr;
+    glm::vec2 m_listener = glm::vec2(0.0f);
+    float m_minDistance = 1.0f;
+    float m_maxDistance = 1.0f;
+    bool m_isListenerPending = false;  ///< Not handed to the mixer yet
+    uint64_t m_frame = 1;
+    uint64_t m_order = 0;
+    VoiceStats m_stats;
+};
+}  // namespace GangerEngine
+
+#endif  // _VOICEMANAGER_H_
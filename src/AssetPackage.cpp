@@ -0,0 +1,184 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/AssetPackage.h>
+#include <GangerEngine/Compression.h>
+#include <GangerEngine/Hash.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace GangerEngine {
+    AssetPackage::AssetPackage() {
+        // Empty
+    }
+
+    AssetPackage::~AssetPackage() {
+        Close();
+    }
+
+    bool AssetPackage::Open(const std::string& filePath) {
+        Close();
+
+        if (!Map(filePath)) return false;
+        if (!Validate()) {
+            printf("%s is not a valid asset package\n", filePath.c_str());
+            Close();
+            return false;
+        }
+
+        m_filePath = filePath;
+        return true;
+    }
+
+    void AssetPackage::Close() {
+        if (m_data == nullptr) return;
+
+        m_file.Close();
+        m_data = nullptr;
+        m_size = 0;
+        m_header = nullptr;
+        m_entries = nullptr;
+        m_strings = nullptr;
+        m_filePath.clear();
+    }
+
+    const PackageEntry* AssetPackage::Find(const std::string& path) const {
+        if (m_header == nullptr) return nullptr;
+
+        std::string normalized = NormalizePath(path);
+        uint64_t hash = HashFNV1a(normalized);
+
+        // The entries are sorted by hash
+        uint32_t first = 0;
+        uint32_t last = m_header->numEntries;
+        while (first < last) {
+            uint32_t middle = first + (last - first) / 2;
+            if (m_entries[middle].pathHash < hash) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+
+        // Walk the run of equal hashes in case of a collision
+        for (uint32_t i = first; i < m_header->numEntries &&
+            m_entries[i].pathHash == hash; i++) {
+            if (normalized == GetPath(m_entries[i])) return &m_entries[i];
+        }
+        return nullptr;
+    }
+
+    bool AssetPackage::Read(const PackageEntry& entry,
+        std::vector<unsigned char>& buffer) const {
+        buffer.resize(static_cast<size_t>(entry.rawSize));
+        if (entry.rawSize == 0) return true;
+
+        if (entry.flags & ASSET_FLAG_COMPRESSED) {
+            return DecompressLZ(GetPayload(entry),
+                static_cast<size_t>(entry.size), &buffer[0], buffer.size());
+        }
+
+        memcpy(&buffer[0], GetPayload(entry), buffer.size());
+        return true;
+    }
+
+    uint64_t AssetPackage::GetMipChainSize(uint32_t width, uint32_t height,
+        uint32_t numMips, uint32_t flags) {
+        uint64_t blockSize = 0;
+        if (flags & ASSET_FLAG_BC1) blockSize = 8;
+        if (flags & ASSET_FLAG_BC3) blockSize = 16;
+
+        uint64_t size = 0;
+        for (uint32_t i = 0; i < numMips; i++) {
+            if (blockSize > 0) {
+                size += static_cast<uint64_t>((width + 3) / 4) *
+                    ((height + 3) / 4) * blockSize;
+            } else {
+                size += static_cast<uint64_t>(width) * height * 4;
+            }
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        return size;
+    }
+
+    std::string AssetPackage::NormalizePath(const std::string& path) {
+        std::string normalized = path;
+        for (auto& c : normalized) {
+            if (c == '\\') c = '/';
+        }
+        while (normalized.compare(0, 2, "./") == 0) {
+            normalized.erase(0, 2);
+        }
+        return normalized;
+    }
+
+    bool AssetPackage::Map(const std::string& filePath) {
+        // Payloads are used in place for as long as the package is open
+        if (!m_file.Open(filePath) || m_file.GetSize() == 0) {
+            m_file.Close();
+            return false;
+        }
+
+        m_data = m_file.GetData();
+        m_size = m_file.GetSize();
+        return true;
+    }
+
+    bool AssetPackage::Validate() {
+        if (m_size < sizeof(PackageHeader)) return false;
+
+        m_header = reinterpret_cast<const PackageHeader*>(m_data);
+        if (memcmp(m_header->magic, PACKAGE_MAGIC, sizeof(PACKAGE_MAGIC)) !=
+            0 || m_header->version != PACKAGE_VERSION) {
+            return false;
+        }
+
+        uint64_t tocSize = sizeof(PackageHeader) +
+            static_cast<uint64_t>(m_header->numEntries) * sizeof(PackageEntry);
+        if (tocSize + m_header->stringTableSize > m_size) return false;
+
+        m_entries = reinterpret_cast<const PackageEntry*>(
+            m_data + sizeof(PackageHeader));
+        m_strings = reinterpret_cast<const char*>(m_data + tocSize);
+        if (m_header->stringTableSize == 0 ||
+            m_strings[m_header->stringTableSize - 1] != '\0') {
+            return m_header->numEntries == 0;
+        }
+
+        // Bounds check once here so lookups can trust the entries
+        for (uint32_t i = 0; i < m_header->numEntries; i++) {
+            const PackageEntry& entry = m_entries[i];
+            if (entry.offset > m_size || entry.size > m_size - entry.offset ||
+                entry.pathOffset >= m_header->stringTableSize) {
+                return false;
+            }
+            if (!(entry.flags & ASSET_FLAG_COMPRESSED) &&
+                entry.rawSize != entry.size) {
+                return false;
+            }
+            if (entry.type == static_cast<uint32_t>(AssetType::TEXTURE) &&
+                (entry.numMips == 0 || entry.rawSize != GetMipChainSize(
+                entry.width, entry.height, entry.numMips, entry.flags))) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace GangerEngine
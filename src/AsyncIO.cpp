@@ -0,0 +1,777 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/AsyncIO.h>
+
+#ifdef EFGE_USE_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GangerEngine {
+    // Files move in chunks this big, so a cancel or a more urgent request
+    // does not wait behind a whole big file
+    static const uint64_t CHUNK_SIZE = 1 << 20;
+
+    struct AsyncIO::Request {
+        IORequestId id = 0;
+        uint64_t sequence = 0;  ///< Keeps the order within a priority
+        IORequest params;
+        std::unique_ptr<std::promise<IOResult> > promise;
+        std::atomic<bool> isCancelled{false};
+
+        // Progress on the ring
+        int fd = -1;
+        uint64_t size = 0;
+        uint64_t nextOffset = 0;  ///< Where the next chunk starts
+        uint64_t doneBytes = 0;
+        int numChunks = 0;  ///< In flight
+        bool isFailed = false;
+    };
+
+#ifdef EFGE_USE_IO_URING
+    // The user data of the wake up read, chunks use their address
+    static const uint64_t WAKE_TAG = 0;
+
+    /// The rings shared with the kernel.
+    struct AsyncIO::Ring {
+        int fd = -1;
+        void* sqMap = MAP_FAILED;
+        size_t sqMapSize = 0;
+        void* cqMap = MAP_FAILED;
+        size_t cqMapSize = 0;
+        void* sqesMap = MAP_FAILED;
+        size_t sqesMapSize = 0;
+
+        unsigned int* sqHead = nullptr;
+        unsigned int* sqTail = nullptr;
+        unsigned int* sqMask = nullptr;
+        unsigned int* sqArray = nullptr;
+        unsigned int sqEntries = 0;
+        io_uring_sqe* sqes = nullptr;
+        unsigned int* cqHead = nullptr;
+        unsigned int* cqTail = nullptr;
+        unsigned int* cqMask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+        unsigned int numToSubmit = 0;
+
+        // Gets a cleared entry, visible to the kernel once committed
+        io_uring_sqe* GetSqe() {
+            unsigned int tail = *sqTail;
+            if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >=
+                sqEntries) {
+                Enter(0);
+            }
+            unsigned int index = tail & *sqMask;
+            io_uring_sqe* sqe = &sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqArray[index] = index;
+            return sqe;
+        }
+
+        void CommitSqe() {
+            __atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+            numToSubmit++;
+        }
+
+        // Submits the committed entries and waits for some completions
+        void Enter(unsigned int minComplete) {
+            for (;;) {
+                long result = syscall(__NR_io_uring_enter, fd, numToSubmit,
+                    minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0,
+                    nullptr, 0);
+                if (result >= 0) {
+                    numToSubmit -= static_cast<unsigned int>(result);
+                    return;
+                }
+                if (errno == EINTR) continue;
+                // Out of resources until some completions are reaped
+                if (errno != EAGAIN && errno != EBUSY) {
+                    perror("io_uring_enter");
+                }
+                return;
+            }
+        }
+    };
+
+    /// A read or write of a piece of a request.
+    struct AsyncIO::Chunk {
+        Request* request;
+        uint64_t offset;
+        uint32_t length;
+    };
+#else
+    struct AsyncIO::Ring {
+    };
+
+    struct AsyncIO::Chunk {
+    };
+#endif
+
+    // Writes go to a file next to the target, renamed over it once complete
+    static std::string MakeTempPath(const std::string& filePath,
+        IORequestId id) {
+        return filePath + "." + std::to_string(id) + ".tmp";
+    }
+
+    static bool ReplaceFile(const std::string& tempPath,
+        const std::string& filePath) {
+#ifdef _WIN32
+        // rename does not overwrite on Windows
+        remove(filePath.c_str());
+#endif
+        if (rename(tempPath.c_str(), filePath.c_str()) != 0) {
+            perror(filePath.c_str());
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    AsyncIO::AsyncIO() {
+    }
+
+    AsyncIO::~AsyncIO() {
+        Dispose();
+    }
+
+    void AsyncIO::Init(unsigned int queueDepth, unsigned int numThreads,
+        bool allowIOUring) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isRunning) return;
+
+        m_isStopping = false;
+        m_queueDepth = std::max(queueDepth, 1u);
+        // One more entry for the wake up read
+        if (allowIOUring && InitRing(m_queueDepth + 1)) {
+            m_ringThread = std::thread(&AsyncIO::RingLoop, this);
+        } else {
+            m_workers.Init(std::max(numThreads, 1u));
+        }
+        m_isRunning = true;
+    }
+
+    void AsyncIO::Dispose() {
+        std::vector<RequestPtr> queued;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_isRunning) return;
+            m_isStopping = true;
+            queued.swap(m_queue);
+        }
+        for (auto& request : queued) {
+            request->isCancelled = true;
+            Complete(request, IOStatus::CANCELLED);
+        }
+        WaitIdle();
+
+        if (m_ring) {
+            Wake();
+            m_ringThread.join();
+            DisposeRing();
+        } else {
+            m_workers.Dispose();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = false;
+        m_isRunning = false;
+    }
+
+    IORequestId AsyncIO::Submit(IORequest request) {
+        return Enqueue(std::move(request), nullptr);
+    }
+
+    std::future<IOResult> AsyncIO::SubmitFuture(IORequest request,
+        IORequestId* id) {
+        std::unique_ptr<std::promise<IOResult> > promise(
+            new std::promise<IOResult>());
+        std::future<IOResult> future = promise->get_future();
+        IORequestId requestId = Enqueue(std::move(request),
+            std::move(promise));
+        if (id != nullptr) *id = requestId;
+        return future;
+    }
+
+    bool AsyncIO::Cancel(IORequestId id) {
+        RequestPtr request;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_requests.find(id);
+            if (it == m_requests.end()) return false;
+
+            request = it->second;
+            request->isCancelled = true;
+            // In flight, the I/O thread completes it after its chunks
+            auto queued = std::find(m_queue.begin(), m_queue.end(), request);
+            if (queued == m_queue.end()) return true;
+
+            m_queue.erase(queued);
+            std::make_heap(m_queue.begin(), m_queue.end(), IsLessUrgent);
+        }
+        Complete(request, IOStatus::CANCELLED);
+        return true;
+    }
+
+    bool AsyncIO::SetPriority(IORequestId id, IOPriority priority) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& request : m_queue) {
+            if (request->id == id) {
+                request->params.priority = priority;
+                std::make_heap(m_queue.begin(), m_queue.end(), IsLessUrgent);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void AsyncIO::ProcessCompletions() {
+        std::vector<std::pair<IOCallback, IOResult> > completions;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            completions.swap(m_completions);
+        }
+        // Callbacks may submit new requests
+        for (auto& completion : completions) {
+            completion.first(completion.second);
+        }
+    }
+
+    void AsyncIO::Wait(IORequestId id) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [this, id] {
+            return m_requests.find(id) == m_requests.end();
+        });
+    }
+
+    void AsyncIO::WaitIdle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_requests.empty(); });
+    }
+
+    AsyncIOStats AsyncIO::GetStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        AsyncIOStats stats = m_stats;
+        stats.numQueued = static_cast<int>(m_queue.size());
+        stats.numInFlight = static_cast<int>(m_requests.size() -
+            m_queue.size());
+        return stats;
+    }
+
+    const char* AsyncIO::GetBackendName() const {
+        return m_ring ? "io_uring" : "threads";
+    }
+
+    IORequestId AsyncIO::Enqueue(IORequest params,
+        std::unique_ptr<std::promise<IOResult> > promise) {
+        Init();
+
+        auto request = std::make_shared<Request>();
+        request->params = std::move(params);
+        request->promise = std::move(promise);
+        IORequestId id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            id = request->id = m_nextId++;
+            request->sequence = m_sequence++;
+            m_requests[id] = request;
+            m_queue.push_back(request);
+            std::push_heap(m_queue.begin(), m_queue.end(), IsLessUrgent);
+        }
+
+        // Each job serves whatever is the most urgent when it runs
+        if (m_ring) {
+            Wake();
+        } else {
+            m_workers.Enqueue([this] { RunNext(); });
+        }
+        return id;
+    }
+
+    bool AsyncIO::IsLessUrgent(const RequestPtr& a, const RequestPtr& b) {
+        if (a->params.priority != b->params.priority) {
+            return a->params.priority < b->params.priority;
+        }
+        return a->sequence > b->sequence;
+    }
+
+    AsyncIO::RequestPtr AsyncIO::PopLocked() {
+        std::pop_heap(m_queue.begin(), m_queue.end(), IsLessUrgent);
+        RequestPtr request = std::move(m_queue.back());
+        m_queue.pop_back();
+        return request;
+    }
+
+    void AsyncIO::Complete(const RequestPtr& request, IOStatus status) {
+        IORequest& params = request->params;
+        IOResult result;
+        result.id = request->id;
+        result.status = status;
+        result.filePath = params.filePath;
+        if (status == IOStatus::OK && params.operation == IOOperation::READ) {
+            result.data = std::move(params.data);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (status == IOStatus::OK) {
+                m_stats.numCompleted++;
+                if (params.operation == IOOperation::READ) {
+                    m_stats.bytesRead += result.data.size();
+                } else {
+                    m_stats.bytesWritten += params.data.size();
+                }
+            } else if (status == IOStatus::FAILED) {
+                m_stats.numFailed++;
+            } else {
+                m_stats.numCancelled++;
+            }
+        }
+
+        if (request->promise) {
+            request->promise->set_value(std::move(result));
+        } else if (params.callback && params.isImmediate) {
+            params.callback(result);
+        } else if (params.callback) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_completions.emplace_back(std::move(params.callback),
+                std::move(result));
+        }
+
+        // Only now, so waiting for it also waits for an immediate callback
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.erase(request->id);
+        m_doneCondition.notify_all();
+    }
+
+    void AsyncIO::RunNext() {
+        RequestPtr request;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Its request was cancelled while queued
+            if (m_queue.empty()) return;
+            request = PopLocked();
+        }
+
+        IOStatus status;
+        if (request->params.source) {
+            status = request->params.source(request->params.data) ?
+                IOStatus::OK : IOStatus::FAILED;
+        } else if (request->params.operation == IOOperation::READ) {
+            status = Read(*request);
+        } else {
+            status = Write(*request);
+        }
+        Complete(request, status);
+    }
+
+    IOStatus AsyncIO::Read(Request& request) {
+        const std::string& filePath = request.params.filePath;
+        std::vector<unsigned char>& data = request.params.data;
+        std::ifstream file(filePath, std::ios::binary);
+        if (file.fail()) {
+            perror(filePath.c_str());
+            return IOStatus::FAILED;
+        }
+
+        file.seekg(0, std::ios::end);
+        std::streamoff fileSize = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (fileSize < 0 ||
+            static_cast<uint64_t>(fileSize) > data.max_size()) {
+            printf("%s is too big to read\n", filePath.c_str());
+            return IOStatus::FAILED;
+        }
+
+        data.resize(static_cast<size_t>(fileSize));
+        for (size_t offset = 0; offset < data.size();) {
+            if (request.isCancelled) return IOStatus::CANCELLED;
+
+            std::streamsize length = static_cast<std::streamsize>(
+                std::min<uint64_t>(CHUNK_SIZE, data.size() - offset));
+            file.read(reinterpret_cast<char*>(&data[offset]), length);
+            if (file.gcount() != length) {
+                printf("Could not read %s\n", filePath.c_str());
+                return IOStatus::FAILED;
+            }
+            offset += static_cast<size_t>(length);
+        }
+        return IOStatus::OK;
+    }
+
+    IOStatus AsyncIO::Write(Request& request) {
+        const std::string& filePath = request.params.filePath;
+        const std::vector<unsigned char>& data = request.params.data;
+        std::string tempPath = MakeTempPath(filePath, request.id);
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (file.fail()) {
+                perror(tempPath.c_str());
+                return IOStatus::FAILED;
+            }
+
+            for (size_t offset = 0; offset < data.size();) {
+                std::streamsize length = static_cast<std::streamsize>(
+                    std::min<uint64_t>(CHUNK_SIZE, data.size() - offset));
+                if (!request.isCancelled) {
+                    file.write(reinterpret_cast<const char*>(&data[offset]),
+                        length);
+                }
+                if (request.isCancelled || file.fail()) {
+                    if (!request.isCancelled) {
+                        printf("Could not write %s\n", filePath.c_str());
+                    }
+                    file.close();
+                    remove(tempPath.c_str());
+                    return request.isCancelled ? IOStatus::CANCELLED :
+                        IOStatus::FAILED;
+                }
+                offset += static_cast<size_t>(length);
+            }
+        }
+        return ReplaceFile(tempPath, filePath) ? IOStatus::OK :
+            IOStatus::FAILED;
+    }
+
+#ifdef EFGE_USE_IO_URING
+    bool AsyncIO::InitRing(unsigned int entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries,
+            &params));
+        // Old kernels, seccomp filters and io_uring_disabled end up here
+        if (fd < 0) return false;
+
+        m_ring.reset(new Ring());
+        Ring& ring = *m_ring;
+        ring.fd = fd;
+
+        // Plain reads and writes came along with the probe
+        std::vector<unsigned char> probeBuffer(sizeof(io_uring_probe) +
+            256 * sizeof(io_uring_probe_op));
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(
+            &probeBuffer[0]);
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+            256) < 0 || probe->last_op < IORING_OP_WRITE ||
+            !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) ||
+            !(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)) {
+            DisposeRing();
+            return false;
+        }
+
+        ring.sqMapSize = params.sq_off.array +
+            params.sq_entries * sizeof(unsigned int);
+        ring.cqMapSize = params.cq_off.cqes +
+            params.cq_entries * sizeof(io_uring_cqe);
+        bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (isSingleMap) {
+            ring.sqMapSize = ring.cqMapSize =
+                std::max(ring.sqMapSize, ring.cqMapSize);
+        }
+        ring.sqMap = mmap(nullptr, ring.sqMapSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (ring.sqMap != MAP_FAILED && isSingleMap) {
+            ring.cqMap = ring.sqMap;
+        } else if (ring.sqMap != MAP_FAILED) {
+            ring.cqMap = mmap(nullptr, ring.cqMapSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        }
+        ring.sqesMapSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring.sqesMap = mmap(nullptr, ring.sqesMapSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        m_wakeFd = eventfd(0, EFD_CLOEXEC);
+        if (ring.sqMap == MAP_FAILED || ring.cqMap == MAP_FAILED ||
+            ring.sqesMap == MAP_FAILED || m_wakeFd < 0) {
+            perror("io_uring");
+            DisposeRing();
+            return false;
+        }
+
+        char* sq = static_cast<char*>(ring.sqMap);
+        ring.sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+        ring.sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+        ring.sqMask = reinterpret_cast<unsigned int*>(sq +
+            params.sq_off.ring_mask);
+        ring.sqArray = reinterpret_cast<unsigned int*>(sq +
+            params.sq_off.array);
+        ring.sqEntries = params.sq_entries;
+        ring.sqes = static_cast<io_uring_sqe*>(ring.sqesMap);
+
+        char* cq = static_cast<char*>(ring.cqMap);
+        ring.cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+        ring.cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+        ring.cqMask = reinterpret_cast<unsigned int*>(cq +
+            params.cq_off.ring_mask);
+        ring.cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void AsyncIO::DisposeRing() {
+        if (!m_ring) return;
+
+        Ring& ring = *m_ring;
+        if (ring.sqesMap != MAP_FAILED) munmap(ring.sqesMap, ring.sqesMapSize);
+        if (ring.cqMap != MAP_FAILED && ring.cqMap != ring.sqMap) {
+            munmap(ring.cqMap, ring.cqMapSize);
+        }
+        if (ring.sqMap != MAP_FAILED) munmap(ring.sqMap, ring.sqMapSize);
+        if (ring.fd >= 0) close(ring.fd);
+        if (m_wakeFd >= 0) close(m_wakeFd);
+        m_wakeFd = -1;
+        m_ring.reset();
+    }
+
+    void AsyncIO::Wake() {
+        uint64_t one = 1;
+        ssize_t written = write(m_wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+
+    void AsyncIO::RingLoop() {
+        PushWakeRead();
+        for (;;) {
+            // Start the most urgent requests while there is room for their
+            // chunks, the rest stay queued where priorities still apply. A
+            // request more urgent than a running one starts anyway, so it
+            // gets the next free slots instead of waiting behind a big file
+            for (;;) {
+                RequestPtr request;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_queue.empty() || (m_numChunks >= m_queueDepth &&
+                        !IsMoreUrgentThanRunning(m_queue.front()))) {
+                        break;
+                    }
+                    request = PopLocked();
+                }
+                StartRequest(request);
+                SubmitChunks();
+            }
+            SubmitChunks();
+            RetireRequests();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_isStopping && m_running.empty()) break;
+            }
+
+            // The freed slots are refilled at the top, once the queue had a
+            // chance to start something more urgent
+            m_ring->Enter(1);
+            ReapCompletions();
+        }
+    }
+
+    bool AsyncIO::IsMoreUrgentThanRunning(const RequestPtr& request) const {
+        // Only the running requests with chunks left compete for slots
+        for (auto& running : m_running) {
+            const Request& r = *running;
+            if (r.isFailed || r.isCancelled || r.nextOffset >= r.size) {
+                continue;
+            }
+            if (IsLessUrgent(running, request)) return true;
+        }
+        return false;
+    }
+
+    void AsyncIO::StartRequest(const RequestPtr& request) {
+        Request& r = *request;
+        // Kept most urgent first, the order SubmitChunks serves them in
+        auto position = std::find_if(m_running.begin(), m_running.end(),
+            [&request](const RequestPtr& running) {
+                return IsLessUrgent(running, request);
+            });
+        m_running.insert(position, request);
+        if (r.isCancelled) return;
+
+        // Package entries, usually a copy out of the mapping
+        if (r.params.source) {
+            r.isFailed = !r.params.source(r.params.data);
+            return;
+        }
+
+        const std::string& filePath = r.params.filePath;
+        if (r.params.operation == IOOperation::WRITE) {
+            std::string tempPath = MakeTempPath(filePath, r.id);
+            r.fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC |
+                O_CLOEXEC, 0644);
+            if (r.fd < 0) {
+                perror(tempPath.c_str());
+                r.isFailed = true;
+                return;
+            }
+            r.size = r.params.data.size();
+            return;
+        }
+
+        struct stat fileStat;
+        r.fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (r.fd < 0 || fstat(r.fd, &fileStat) != 0) {
+            perror(filePath.c_str());
+            r.isFailed = true;
+            return;
+        }
+        if (!S_ISREG(fileStat.st_mode)) {
+            printf("%s is not a regular file\n", filePath.c_str());
+            r.isFailed = true;
+            return;
+        }
+        r.size = static_cast<uint64_t>(fileStat.st_size);
+        r.params.data.resize(static_cast<size_t>(r.size));
+    }
+
+    void AsyncIO::SubmitChunks() {
+        for (auto& request : m_running) {
+            Request& r = *request;
+            while (m_numChunks < m_queueDepth && !r.isFailed &&
+                !r.isCancelled && r.nextOffset < r.size) {
+                Chunk* chunk = new Chunk();
+                chunk->request = &r;
+                chunk->offset = r.nextOffset;
+                chunk->length = static_cast<uint32_t>(
+                    std::min(CHUNK_SIZE, r.size - r.nextOffset));
+                r.nextOffset += chunk->length;
+                r.numChunks++;
+                m_numChunks++;
+                PushChunk(chunk);
+            }
+        }
+    }
+
+    void AsyncIO::PushChunk(Chunk* chunk) {
+        Request& r = *chunk->request;
+        io_uring_sqe* sqe = m_ring->GetSqe();
+        sqe->opcode = r.params.operation == IOOperation::READ ?
+            IORING_OP_READ : IORING_OP_WRITE;
+        sqe->fd = r.fd;
+        sqe->off = chunk->offset;
+        sqe->addr = reinterpret_cast<uintptr_t>(
+            &r.params.data[static_cast<size_t>(chunk->offset)]);
+        sqe->len = chunk->length;
+        sqe->user_data = reinterpret_cast<uintptr_t>(chunk);
+        m_ring->CommitSqe();
+    }
+
+    void AsyncIO::PushWakeRead() {
+        io_uring_sqe* sqe = m_ring->GetSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = m_wakeFd;
+        sqe->addr = reinterpret_cast<uintptr_t>(&m_wakeValue);
+        sqe->len = sizeof(m_wakeValue);
+        sqe->user_data = WAKE_TAG;
+        m_ring->CommitSqe();
+    }
+
+    void AsyncIO::ReapCompletions() {
+        Ring& ring = *m_ring;
+        unsigned int head = *ring.cqHead;
+        unsigned int tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = ring.cqes[head & *ring.cqMask];
+            if (cqe.user_data == WAKE_TAG) {
+                PushWakeRead();
+                continue;
+            }
+
+            Chunk* chunk = reinterpret_cast<Chunk*>(
+                static_cast<uintptr_t>(cqe.user_data));
+            Request& r = *chunk->request;
+            int result = cqe.res;
+            if (result == -EAGAIN || result == -EINTR) {
+                PushChunk(chunk);
+                continue;
+            }
+
+            if (result > 0) {
+                uint32_t length = static_cast<uint32_t>(result);
+                r.doneBytes += length;
+                // Short transfer, the rest goes again
+                if (length < chunk->length && !r.isCancelled) {
+                    chunk->offset += length;
+                    chunk->length -= length;
+                    PushChunk(chunk);
+                    continue;
+                }
+            } else if (!r.isFailed) {
+                bool isRead = r.params.operation == IOOperation::READ;
+                printf("Could not %s %s: %s\n", isRead ? "read" : "write",
+                    r.params.filePath.c_str(), result < 0 ?
+                    strerror(-result) : "unexpected end of file");
+                r.isFailed = true;
+            }
+            r.numChunks--;
+            m_numChunks--;
+            delete chunk;
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    void AsyncIO::RetireRequests() {
+        for (size_t i = 0; i < m_running.size();) {
+            RequestPtr request = m_running[i];
+            Request& r = *request;
+            bool isDone = r.isFailed || r.isCancelled || r.doneBytes >= r.size;
+            if (r.numChunks > 0 || !isDone) {
+                i++;
+                continue;
+            }
+            m_running.erase(m_running.begin() + i);
+
+            if (r.fd >= 0) close(r.fd);
+            r.fd = -1;
+            IOStatus status = r.isCancelled ? IOStatus::CANCELLED :
+                r.isFailed ? IOStatus::FAILED : IOStatus::OK;
+            if (r.params.operation == IOOperation::WRITE &&
+                !r.params.source) {
+                std::string tempPath = MakeTempPath(r.params.filePath, r.id);
+                if (status != IOStatus::OK) {
+                    remove(tempPath.c_str());
+                } else if (!ReplaceFile(tempPath, r.params.filePath)) {
+                    status = IOStatus::FAILED;
+                }
+            }
+            Complete(request, status);
+        }
+    }
+#else
+    bool AsyncIO::InitRing(unsigned int entries) {
+        return false;
+    }
+
+    void AsyncIO::DisposeRing() {
+    }
+
+    void AsyncIO::Wake() {
+    }
+
+    void AsyncIO::RingLoop() {
+    }
+#endif
+}  // namespace GangerEngine
@@ -16,33 +16,72 @@
 
 #include <GangerEngine/AudioEngine.h>
 #include <GangerEngine/GangerErrors.h>
+#include <GangerEngine/IOManager.h>
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
+#include <utility>
 
 namespace GangerEngine {
-    void SoundEffect::Play(int loops /* = 0 */ ) {
-        if (Mix_PlayChannel(-1, m_chunk, loops) == -1) {
-            if (Mix_PlayChannel(0, m_chunk, loops) == -1) {
-                FatalError("Mix_PlayChannel error: " +
-                    std::string(Mix_GetError()));
-            }
+    MusicStream* Music::m_stream = nullptr;
+
+    void SoundEffect::Play(int loops /* = 0 */, float volume /* = 1.0f */) {
+        if (m_cache->Acquire(m_sound)) m_voices->Play(m_sound, loops, volume);
+    }
+
+    void SoundEffect::PlayAt(const glm::vec2& position, int loops /* = 0 */,
+        float volume /* = 1.0f */) {
+        if (m_cache->Acquire(m_sound)) {
+            m_voices->Play(m_sound, loops, volume, &position);
         }
     }
 
+    void SoundEffect::SetPriority(int priority) {
+        m_sound->priority = priority;
+    }
+
+    void SoundEffect::SetMaxInstances(int maxInstances) {
+        m_sound->maxInstances = maxInstances;
+    }
+
     void Music::Play(int loops /* = -1 */) {
-        Mix_PlayMusic(m_music, loops);
+        if (m_stream != nullptr) {
+            m_stream->Play(m_data->filePath, loops, m_data->loopStart,
+                m_data->loopEnd);
+        } else {
+            Mix_PlayMusic(m_data->music, loops);
+        }
+    }
+
+    void Music::SetLoopPoints(double startSeconds,
+        double endSeconds /* = 0.0 */) {
+        m_data->loopStart = startSeconds;
+        m_data->loopEnd = endSeconds;
     }
 
     void Music::Pause() {
-        Mix_PauseMusic();
+        if (m_stream != nullptr) {
+            m_stream->Pause();
+        } else {
+            Mix_PauseMusic();
+        }
     }
 
     void Music::Stop() {
-        Mix_HaltMusic();
+        if (m_stream != nullptr) {
+            m_stream->Stop();
+        } else {
+            Mix_HaltMusic();
+        }
     }
 
     void Music::Resume() {
-        Mix_ResumeMusic();
+        if (m_stream != nullptr) {
+            m_stream->Resume();
+        } else {
+            Mix_ResumeMusic();
+        }
     }
 
     AudioEngine::AudioEngine() {
@@ -54,7 +93,7 @@ namespace GangerEngine {
     }
 
 
-    void AudioEngine::Init() {
+    void AudioEngine::Init(int numVoices /* = 128 */) {
         if (m_isInitialized) {  // If it is already initialize
             FatalError("Tried to initialize Audio Engine twice!\n");
         }
@@ -70,51 +109,86 @@ namespace GangerEngine {
             FatalError("Mix_OpenAudio error: " + std::string(Mix_GetError()));
         }
 
+        int channels;
+        Uint16 format;
+        Mix_QuerySpec(&m_sampleRate, &format, &channels);
+        if (format == AUDIO_S16SYS && channels == 2) {
+            m_mixer.Init(numVoices);
+            m_voices.Init(numVoices, &m_mixer);
+            m_soundCache.Init(&m_mixer);
+            m_musicStream.Init(m_sampleRate,
+                m_sampleRate * m_musicBufferMilliseconds / 1000);
+            Music::m_stream = &m_musicStream;
+            Mix_SetPostMix(MixOutput, this);
+        } else {
+            printf("The audio device is not 16 bit stereo, effects and "
+                "music are played by SDL_mixer\n");
+            m_voices.Init(numVoices);
+            m_soundCache.Init();
+        }
+        SetListener(glm::vec2(0.0f));
+
         m_isInitialized = true;
     }
 
     void AudioEngine::Destroy() {
         if (m_isInitialized) {  // If it is initialized
             m_isInitialized = false;
-
-            for (auto& it : m_effectMap) {  // Iterate all the effects
-                Mix_FreeChunk(it.second);
+            m_voices.Dispose();
+            if (Music::m_stream == &m_musicStream) {
+                m_musicStream.Stop();
+                m_musicStream.ClearCache();
+                Music::m_stream = nullptr;
             }
+            // Waits for the audio thread, nothing plays the chunks after it
+            Mix_SetPostMix(nullptr, nullptr);
+
+            m_soundCache.Clear();
 
             for (auto& it : m_musicMap) {  // Iterate all the musics
-                Mix_FreeMusic(it.second);
+                if (it.second.music != nullptr) Mix_FreeMusic(it.second.music);
             }
 
-            m_effectMap.clear();
             m_musicMap.clear();
+            m_musicFiles.clear();
 
             Mix_CloseAudio();
             Mix_Quit();
         }
     }
 
-    SoundEffect AudioEngine::LoadSoundEffect(const std::string& filePath) {
-        // Try to find the audio in the cache
-        auto it = m_effectMap.find(filePath);
+    void AudioEngine::Update() {
+        m_voices.Update();
+    }
 
-        SoundEffect effect;
+    void AudioEngine::SetMusicBuffer(int milliseconds) {
+        m_musicBufferMilliseconds = milliseconds;
+        m_musicStream.SetBufferFrames(m_sampleRate * milliseconds / 1000);
+    }
 
-        if (it == m_effectMap.end()) {
-            // Failed to find it, must load
-            Mix_Chunk* chunk = Mix_LoadWAV(filePath.c_str());
-            // Check for errors
-            if (chunk == nullptr) {
-                FatalError("Mix_LoadWAV error: " + std::string(Mix_GetError()));
-            }
+    void AudioEngine::SetEffectBudget(size_t bytes) {
+        m_soundCache.SetBudget(bytes);
+    }
 
-            effect.m_chunk = chunk;
-            m_effectMap[filePath] = chunk;
+    void AudioEngine::SetMusicCacheBudget(size_t bytes) {
+        m_musicStream.SetCacheBudget(bytes);
+    }
 
-        } else {
-            // Its already cached
-            effect.m_chunk = it->second;
-        }
+    void AudioEngine::SetListener(const glm::vec2& position,
+        float minDistance /* = 64.0f */, float maxDistance /* = 1024.0f */) {
+        m_voices.SetListener(position, minDistance, maxDistance);
+    }
 
+    SoundEffect AudioEngine::LoadSoundEffect(const std::string& filePath) {
+        SoundEffect effect;
+        effect.m_sound = m_soundCache.Load(filePath);
+        // Check for errors
+        if (effect.m_sound == nullptr) {
+            FatalError("Failed to load sound effect " + filePath + ": " +
+                std::string(Mix_GetError()));
+        }
+        effect.m_cache = &m_soundCache;
+        effect.m_voices = &m_voices;
         return effect;
     }
 
@@ -125,21 +199,43 @@ namespace GangerEngine {
         Music music;
 
         if (it == m_musicMap.end()) {
-            // Failed to find it, must load
-            Mix_Music* mixMusic = Mix_LoadMUS(filePath.c_str());
+            MusicData& data = m_musicMap[filePath];
+            data.filePath = filePath;
+            music.m_data = &data;
+            // The stream opens the file each time it plays it, the songs
+            // it can not stream are decoded ahead and kept
+            if (Music::m_stream != nullptr) {
+                Music::m_stream->Preload(filePath);
+                return music;
+            }
+
+            // Failed to find it, must load. Music is decoded as it plays,
+            // so the file stays open as long as the music is cached
+            MappedFile file;
+            if (!IOManager::MapFile(filePath, &file)) {
+                FatalError("Failed to open music " + filePath);
+            }
+            Mix_Music* mixMusic = Mix_LoadMUS_RW(SDL_RWFromConstMem(
+                file.GetData(), static_cast<int>(file.GetSize())), 1);
             // Check for errors
             if (mixMusic == nullptr) {
                 FatalError("Mix_LoadMUS error: " + std::string(Mix_GetError()));
             }
-
-            music.m_music = mixMusic;
-            m_musicMap[filePath] = mixMusic;
+            m_musicFiles[filePath] = std::move(file);
+            data.music = mixMusic;
 
         } else {
             // Its already cached
-            music.m_music = it->second;
+            music.m_data = &it->second;
         }
 
         return music;
     }
+
+    void AudioEngine::MixOutput(void* engine, Uint8* stream, int length) {
+        AudioEngine* audioEngine = static_cast<AudioEngine*>(engine);
+        int16_t* frames = reinterpret_cast<int16_t*>(stream);
+        audioEngine->m_musicStream.Mix(frames, length / 4);
+        audioEngine->m_mixer.Mix(frames, length / 4);
+    }
 }  // namespace GangerEngine
@@ -0,0 +1,431 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/BlockCompressor.h>
+#include <GangerEngine/ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace GangerEngine {
+    // Blocks per chunk of work
+    static const size_t BLOCKS_PER_CHUNK = 1024;
+
+    static uint16_t PackColor(const float* color) {
+        static const float SCALES[3] = { 31.0f, 63.0f, 31.0f };
+        int packed[3];
+        for (int c = 0; c < 3; c++) {
+            int value = static_cast<int>(color[c] * SCALES[c] / 255.0f + 0.5f);
+            packed[c] = std::min(std::max(value, 0),
+                static_cast<int>(SCALES[c]));
+        }
+        return static_cast<uint16_t>(packed[0] << 11 | packed[1] << 5 |
+            packed[2]);
+    }
+
+    static void UnpackColor(uint16_t packed, int* color) {
+        int r = (packed >> 11) & 31;
+        int g = (packed >> 5) & 63;
+        int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // The colors a block decodes to. Four color blocks interpolate two
+    // colors between the ends, the others one and leave index 3 transparent.
+    static void GetPalette(uint16_t color0, uint16_t color1, bool isFourColor,
+        int palette[4][3]) {
+        UnpackColor(color0, palette[0]);
+        UnpackColor(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            if (isFourColor) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            } else {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+    }
+
+    static void WriteColorBlock(uint16_t color0, uint16_t color1,
+        uint32_t indices, unsigned char* out) {
+        out[0] = static_cast<unsigned char>(color0);
+        out[1] = static_cast<unsigned char>(color0 >> 8);
+        out[2] = static_cast<unsigned char>(color1);
+        out[3] = static_cast<unsigned char>(color1 >> 8);
+        for (int i = 0; i < 4; i++) {
+            out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+        }
+    }
+
+    // Fits the two end colors along the principal axis of the block, then
+    // refines them with least squares against the chosen indices. Texels
+    // under half alpha become transparent when allowed, which needs the three
+    // color mode.
+    static void EncodeColorBlock(const unsigned char* texels,
+        bool allowTransparent, unsigned char* out) {
+        bool isOpaque[16];
+        int numOpaque = 0;
+        for (int i = 0; i < 16; i++) {
+            isOpaque[i] = !allowTransparent || texels[i * 4 + 3] >= 128;
+            if (isOpaque[i]) numOpaque++;
+        }
+        if (numOpaque == 0) {
+            WriteColorBlock(0, 0, 0xffffffffu, out);
+            return;
+        }
+        bool isFourColor = numOpaque == 16;
+
+        float mean[3] = {};
+        for (int i = 0; i < 16; i++) {
+            if (!isOpaque[i]) continue;
+            for (int c = 0; c < 3; c++) mean[c] += texels[i * 4 + c];
+        }
+        for (int c = 0; c < 3; c++) mean[c] /= numOpaque;
+
+        // Covariance as xx, xy, xz, yy, yz, zz
+        float covariance[6] = {};
+        for (int i = 0; i < 16; i++) {
+            if (!isOpaque[i]) continue;
+            float r = texels[i * 4] - mean[0];
+            float g = texels[i * 4 + 1] - mean[1];
+            float b = texels[i * 4 + 2] - mean[2];
+            covariance[0] += r * r;
+            covariance[1] += r * g;
+            covariance[2] += r * b;
+            covariance[3] += g * g;
+            covariance[4] += g * b;
+            covariance[5] += b * b;
+        }
+
+        // A few power iterations find the principal axis
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] +
+                    covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] +
+                    covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] +
+                    covariance[5] * axis[2] };
+            float length = std::max(std::fabs(next[0]),
+                std::max(std::fabs(next[1]), std::fabs(next[2])));
+            // A flat block, any axis will do
+            if (length < 1e-6f) break;
+            for (int c = 0; c < 3; c++) axis[c] = next[c] / length;
+        }
+
+        float minT = 1e30f, maxT = -1e30f;
+        for (int i = 0; i < 16; i++) {
+            if (!isOpaque[i]) continue;
+            float t = 0.0f;
+            for (int c = 0; c < 3; c++) {
+                t += (texels[i * 4 + c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        float axisLength = axis[0] * axis[0] + axis[1] * axis[1] +
+            axis[2] * axis[2];
+        float ends[2][3];
+        for (int c = 0; c < 3; c++) {
+            ends[0][c] = mean[c] + axis[c] * maxT / axisLength;
+            ends[1][c] = mean[c] + axis[c] * minT / axisLength;
+        }
+
+        // How far each index is from the first end to the second
+        static const float FOUR_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f,
+            2.0f / 3.0f };
+        static const float THREE_WEIGHTS[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+        const float* weights = isFourColor ? FOUR_WEIGHTS : THREE_WEIGHTS;
+        int numColors = isFourColor ? 4 : 3;
+
+        int bestError = -1;
+        for (int iteration = 0; iteration < 3; iteration++) {
+            uint16_t color0 = PackColor(ends[0]);
+            uint16_t color1 = PackColor(ends[1]);
+            // The order of the ends selects the mode
+            if (isFourColor ? color0 < color1 : color0 > color1) {
+                std::swap(color0, color1);
+                std::swap(ends[0], ends[1]);
+            }
+
+            int palette[4][3];
+            GetPalette(color0, color1, isFourColor, palette);
+
+            uint32_t indices = 0;
+            int error = 0;
+            int chosen[16];
+            for (int i = 0; i < 16; i++) {
+                chosen[i] = 3;
+                if (!isOpaque[i]) {
+                    indices |= 3u << (i * 2);
+                    continue;
+                }
+
+                int bestDistance = 1 << 30;
+                for (int p = 0; p < numColors; p++) {
+                    int distance = 0;
+                    for (int c = 0; c < 3; c++) {
+                        int delta = texels[i * 4 + c] - palette[p][c];
+                        distance += delta * delta;
+                    }
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        chosen[i] = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(chosen[i]) << (i * 2);
+                error += bestDistance;
+            }
+
+            if (bestError < 0 || error < bestError) {
+                bestError = error;
+                WriteColorBlock(color0, color1, indices, out);
+            }
+            if (error == 0) break;
+
+            // Solve for the ends that best fit these indices
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float ax[3] = {}, bx[3] = {};
+            for (int i = 0; i < 16; i++) {
+                if (!isOpaque[i]) continue;
+                float t = weights[chosen[i]];
+                float s = 1.0f - t;
+                aa += s * s;
+                ab += s * t;
+                bb += t * t;
+                for (int c = 0; c < 3; c++) {
+                    ax[c] += s * texels[i * 4 + c];
+                    bx[c] += t * texels[i * 4 + c];
+                }
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::fabs(determinant) < 1e-6f) break;
+            for (int c = 0; c < 3; c++) {
+                ends[0][c] = (ax[c] * bb - bx[c] * ab) / determinant;
+                ends[1][c] = (bx[c] * aa - ax[c] * ab) / determinant;
+            }
+        }
+    }
+
+    static void DecodeColorBlock(const unsigned char* block,
+        bool isAlwaysFourColor, unsigned char* texels) {
+        uint16_t color0 = static_cast<uint16_t>(block[0] | block[1] << 8);
+        uint16_t color1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+        bool isFourColor = isAlwaysFourColor || color0 > color1;
+        int palette[4][3];
+        GetPalette(color0, color1, isFourColor, palette);
+
+        for (int i = 0; i < 16; i++) {
+            int index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+            for (int c = 0; c < 3; c++) {
+                texels[i * 4 + c] = static_cast<unsigned char>(
+                    palette[index][c]);
+            }
+            texels[i * 4 + 3] = !isFourColor && index == 3 ? 0 : 255;
+        }
+    }
+
+    // The eight alphas of a block. Ends in descending order interpolate six
+    // values, in ascending order four plus 0 and 255.
+    static void GetAlphaPalette(int alpha0, int alpha1, int palette[8]) {
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+        if (alpha0 > alpha1) {
+            for (int i = 2; i < 8; i++) {
+                palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+            }
+        } else {
+            for (int i = 2; i < 6; i++) {
+                palette[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    static int FitAlphas(const unsigned char* texels, int alpha0, int alpha1,
+        uint64_t* indices) {
+        int palette[8];
+        GetAlphaPalette(alpha0, alpha1, palette);
+
+        int error = 0;
+        *indices = 0;
+        for (int i = 0; i < 16; i++) {
+            int alpha = texels[i * 4 + 3];
+            int best = 0;
+            int bestDistance = 1 << 30;
+            for (int p = 0; p < 8; p++) {
+                int distance = (alpha - palette[p]) * (alpha - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            *indices |= static_cast<uint64_t>(best) << (i * 3);
+            error += bestDistance;
+        }
+        return error;
+    }
+
+    static void EncodeAlphaBlock(const unsigned char* texels,
+        unsigned char* out) {
+        int minAlpha = 255, maxAlpha = 0;
+        // Without the 0 and 255 the six value mode can encode exactly
+        int minInner = 255, maxInner = 0;
+        for (int i = 0; i < 16; i++) {
+            int alpha = texels[i * 4 + 3];
+            minAlpha = std::min(minAlpha, alpha);
+            maxAlpha = std::max(maxAlpha, alpha);
+            if (alpha != 0 && alpha != 255) {
+                minInner = std::min(minInner, alpha);
+                maxInner = std::max(maxInner, alpha);
+            }
+        }
+
+        int alpha0 = maxAlpha;
+        int alpha1 = minAlpha;
+        uint64_t indices = 0;
+        if (alpha0 != alpha1) {
+            int error = FitAlphas(texels, alpha0, alpha1, &indices);
+            if (error > 0 && minInner <= maxInner) {
+                uint64_t innerIndices;
+                int innerError = FitAlphas(texels, minInner, maxInner,
+                    &innerIndices);
+                if (innerError < error) {
+                    alpha0 = minInner;
+                    alpha1 = maxInner;
+                    indices = innerIndices;
+                }
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(alpha0);
+        out[1] = static_cast<unsigned char>(alpha1);
+        for (int i = 0; i < 6; i++) {
+            out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+        }
+    }
+
+    static void DecodeAlphaBlock(const unsigned char* block,
+        unsigned char* texels) {
+        int palette[8];
+        GetAlphaPalette(block[0], block[1], palette);
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++) {
+            indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        }
+        for (int i = 0; i < 16; i++) {
+            texels[i * 4 + 3] = static_cast<unsigned char>(
+                palette[(indices >> (i * 3)) & 7]);
+        }
+    }
+
+    size_t BlockCompressor::GetBlockSize(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::BC1:
+                return 8;
+            case PixelFormat::BC3:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    void BlockCompressor::EncodeBlock(const unsigned char* texels,
+        PixelFormat format, unsigned char* out) {
+        if (format == PixelFormat::BC3) {
+            EncodeAlphaBlock(texels, out);
+            // The color part of BC3 is always read as four colors
+            EncodeColorBlock(texels, false, out + 8);
+        } else {
+            EncodeColorBlock(texels, true, out);
+        }
+    }
+
+    void BlockCompressor::DecodeBlock(const unsigned char* block,
+        PixelFormat format, unsigned char* texels) {
+        if (format == PixelFormat::BC3) {
+            DecodeColorBlock(block + 8, true, texels);
+            DecodeAlphaBlock(block, texels);
+        } else {
+            DecodeColorBlock(block, false, texels);
+        }
+    }
+
+    void BlockCompressor::Compress(const unsigned char* pixels, int width,
+        int height, PixelFormat format, unsigned char* out,
+        ThreadPool* workers) {
+        size_t blockSize = GetBlockSize(format);
+        int blocksWide = (width + 3) / 4;
+        int blocksHigh = (height + 3) / 4;
+
+        auto compressRows = [=](size_t beginRow, size_t endRow) {
+            unsigned char texels[64];
+            for (size_t blockY = beginRow; blockY < endRow; blockY++) {
+                for (int blockX = 0; blockX < blocksWide; blockX++) {
+                    for (int i = 0; i < 16; i++) {
+                        int x = std::min(blockX * 4 + i % 4, width - 1);
+                        int y = std::min(static_cast<int>(blockY) * 4 + i / 4,
+                            height - 1);
+                        memcpy(texels + i * 4,
+                            pixels + (static_cast<size_t>(y) * width + x) * 4,
+                            4);
+                    }
+                    EncodeBlock(texels, format, out +
+                        (blockY * blocksWide + blockX) * blockSize);
+                }
+            }
+        };
+
+        if (workers != nullptr) {
+            size_t grain = std::max<size_t>(BLOCKS_PER_CHUNK / blocksWide, 1);
+            workers->ParallelFor(blocksHigh, grain, compressRows);
+        } else {
+            compressRows(0, blocksHigh);
+        }
+    }
+
+    void BlockCompressor::Decompress(const unsigned char* blocks, int width,
+        int height, PixelFormat format, unsigned char* pixels) {
+        size_t blockSize = GetBlockSize(format);
+        int blocksWide = (width + 3) / 4;
+        int blocksHigh = (height + 3) / 4;
+
+        unsigned char texels[64];
+        for (int blockY = 0; blockY < blocksHigh; blockY++) {
+            for (int blockX = 0; blockX < blocksWide; blockX++) {
+                DecodeBlock(blocks, format, texels);
+                blocks += blockSize;
+
+                // Only the texels inside the image
+                for (int i = 0; i < 16; i++) {
+                    int x = blockX * 4 + i % 4;
+                    int y = blockY * 4 + i / 4;
+                    if (x >= width || y >= height) continue;
+                    memcpy(pixels + (static_cast<size_t>(y) * width + x) * 4,
+                        texels + i * 4, 4);
+                }
+            }
+        }
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,87 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/Box2DDebugDraw.h>
+
+namespace GangerEngine {
+    Box2DDebugDraw::Box2DDebugDraw() {
+        SetFlags(e_shapeBit | e_jointBit);
+    }
+
+    void Box2DDebugDraw::Init(DebugRenderer* renderer) {
+        m_renderer = renderer;
+    }
+
+    void Box2DDebugDraw::DrawWorld(b2World* world) {
+        world->SetDebugDraw(this);
+        world->DrawDebugData();
+        world->SetDebugDraw(nullptr);
+    }
+
+    void Box2DDebugDraw::DrawPolygon(const b2Vec2* vertices,
+        int32 vertexCount, const b2Color& color) {
+        m_points.resize(vertexCount);
+        for (int32 i = 0; i < vertexCount; i++) {
+            m_points[i] = glm::vec2(vertices[i].x, vertices[i].y);
+        }
+        m_renderer->DrawPolygon(m_points.data(), vertexCount, ToColor(color));
+    }
+
+    void Box2DDebugDraw::DrawSolidPolygon(const b2Vec2* vertices,
+        int32 vertexCount, const b2Color& color) {
+        // The debug renderer only draws lines
+        DrawPolygon(vertices, vertexCount, color);
+    }
+
+    void Box2DDebugDraw::DrawCircle(const b2Vec2& center, float32 radius,
+        const b2Color& color) {
+        m_renderer->DrawCircle(glm::vec2(center.x, center.y), ToColor(color),
+            radius);
+    }
+
+    void Box2DDebugDraw::DrawSolidCircle(const b2Vec2& center, float32 radius,
+        const b2Vec2& axis, const b2Color& color) {
+        ColorRGBA8 c = ToColor(color);
+        glm::vec2 p(center.x, center.y);
+        m_renderer->DrawCircle(p, c, radius);
+        // Show the rotation
+        m_renderer->DrawLine(p, p + glm::vec2(axis.x, axis.y) * radius, c);
+    }
+
+    void Box2DDebugDraw::DrawSegment(const b2Vec2& p1, const b2Vec2& p2,
+        const b2Color& color) {
+        m_renderer->DrawLine(glm::vec2(p1.x, p1.y), glm::vec2(p2.x, p2.y),
+            ToColor(color));
+    }
+
+    void Box2DDebugDraw::DrawTransform(const b2Transform& xf) {
+        glm::vec2 p(xf.p.x, xf.p.y);
+        glm::vec2 xAxis(xf.q.GetXAxis().x, xf.q.GetXAxis().y);
+        glm::vec2 yAxis(xf.q.GetYAxis().x, xf.q.GetYAxis().y);
+        m_renderer->DrawLine(p, p + xAxis * m_axisLength,
+            ColorRGBA8(255, 0, 0, 255));
+        m_renderer->DrawLine(p, p + yAxis * m_axisLength,
+            ColorRGBA8(0, 255, 0, 255));
+    }
+
+    void Box2DDebugDraw::DrawPoint(const b2Vec2& p, float32 size,
+        const b2Color& color) {
+        // Size is in pixels
+        float halfSize = size * 0.5f / m_renderer->GetViewScale();
+        m_renderer->DrawBox(glm::vec4(p.x - halfSize, p.y - halfSize,
+            halfSize * 2.0f, halfSize * 2.0f), ToColor(color), 0.0f);
+    }
+}  // namespace GangerEngine
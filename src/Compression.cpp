@@ -0,0 +1,156 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/Compression.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace GangerEngine {
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_OFFSET = 65535;
+    const int HASH_BITS = 16;
+
+    static inline uint32_t Read32(const unsigned char* p) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static void WriteLength(std::vector<unsigned char>& out, size_t length) {
+        for (; length >= 255; length -= 255) {
+            out.push_back(255);
+        }
+        out.push_back(static_cast<unsigned char>(length));
+    }
+
+    static void EmitSequence(std::vector<unsigned char>& out,
+        const unsigned char* literals, size_t numLiterals, size_t offset,
+        size_t matchLength) {
+        size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+        unsigned char token = static_cast<unsigned char>(
+            (numLiterals < 15 ? numLiterals : 15) << 4 |
+            (matchCode < 15 ? matchCode : 15));
+        out.push_back(token);
+        if (numLiterals >= 15) WriteLength(out, numLiterals - 15);
+        out.insert(out.end(), literals, literals + numLiterals);
+
+        // The last sequence is literals only
+        if (matchLength == 0) return;
+
+        out.push_back(static_cast<unsigned char>(offset & 0xFF));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (matchCode >= 15) WriteLength(out, matchCode - 15);
+    }
+
+    void CompressLZ(const unsigned char* src, size_t size,
+        std::vector<unsigned char>& out) {
+        out.clear();
+        out.reserve(size / 2 + 16);
+
+        // Last position seen for each hashed 4 byte sequence, plus one
+        std::vector<uint32_t> table(1 << HASH_BITS, 0);
+
+        size_t anchor = 0;
+        size_t i = 0;
+        while (i + MIN_MATCH <= size) {
+            uint32_t sequence = Read32(&src[i]);
+            uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(i + 1);
+
+            if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET ||
+                Read32(&src[candidate - 1]) != sequence) {
+                i++;
+                continue;
+            }
+
+            size_t match = candidate - 1;
+            size_t length = MIN_MATCH;
+            while (i + length < size &&
+                src[match + length] == src[i + length]) {
+                length++;
+            }
+
+            EmitSequence(out, &src[anchor], i - anchor, i - match, length);
+            i += length;
+            anchor = i;
+        }
+
+        EmitSequence(out, src + anchor, size - anchor, 0, 0);
+    }
+
+    bool DecompressLZ(const unsigned char* src, size_t srcSize,
+        unsigned char* dst, size_t dstSize) {
+        const unsigned char* ip = src;
+        const unsigned char* ipEnd = src + srcSize;
+        unsigned char* op = dst;
+        unsigned char* opEnd = dst + dstSize;
+
+        while (ip < ipEnd) {
+            unsigned char token = *ip++;
+
+            size_t numLiterals = token >> 4;
+            if (numLiterals == 15) {
+                unsigned char byte;
+                do {
+                    if (ip >= ipEnd) return false;
+                    byte = *ip++;
+                    numLiterals += byte;
+                } while (byte == 255);
+            }
+            if (numLiterals > static_cast<size_t>(ipEnd - ip) ||
+                numLiterals > static_cast<size_t>(opEnd - op)) {
+                return false;
+            }
+            memcpy(op, ip, numLiterals);
+            ip += numLiterals;
+            op += numLiterals;
+
+            if (ip == ipEnd) break;
+
+            if (ipEnd - ip < 2) return false;
+            size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15) {
+                unsigned char byte;
+                do {
+                    if (ip >= ipEnd) return false;
+                    byte = *ip++;
+                    matchLength += byte;
+                } while (byte == 255);
+            }
+            matchLength += MIN_MATCH;
+
+            if (offset == 0 || offset > static_cast<size_t>(op - dst) ||
+                matchLength > static_cast<size_t>(opEnd - op)) {
+                return false;
+            }
+
+            // Matches may overlap their own output, copy forward
+            const unsigned char* match = op - offset;
+            for (size_t i = 0; i < matchLength; i++) {
+                op[i] = match[i];
+            }
+            op += matchLength;
+        }
+
+        return op == opEnd;
+    }
+}  // namespace GangerEngine
@@ -75,14 +75,18 @@ void main() {
         m_program.AddAttribute("vertexColor");
         m_program.LinkShaders();
 
+        InitLayer(&m_transient);
+    }
+
+    void DebugRenderer::InitLayer(Layer* layer) {
         // Set up buffers
-        glGenVertexArrays(1, &m_vao);
-        glGenBuffers(1, &m_vbo);
-        glGenBuffers(1, &m_ibo);
+        glGenVertexArrays(1, &layer->vao);
+        glGenBuffers(1, &layer->vbo);
+        glGenBuffers(1, &layer->ibo);
 
-        glBindVertexArray(m_vao);
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+        glBindVertexArray(layer->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, layer->vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, layer->ibo);
 
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(DebugVertex),
@@ -93,37 +97,99 @@ void main() {
                 DebugVertex, color)));
 
         glBindVertexArray(0);
+        layer->isAlive = true;
     }
 
-    void DebugRenderer::End() {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        // Orphan the buffer
-        glBufferData(GL_ARRAY_BUFFER, m_verts.size() * sizeof(DebugVertex),
-            nullptr, GL_DYNAMIC_DRAW);
-        // Upload the data
-        glBufferSubData(GL_ARRAY_BUFFER, 0, m_verts.size() *
-            sizeof(DebugVertex), m_verts.data());
+    void DebugRenderer::UploadLayer(Layer* layer, GLenum usage) {
+        const void* indexData = m_indices.data();
+        GLsizeiptr indexBytes = m_indices.size() * sizeof(GLuint);
+        layer->indexType = GL_UNSIGNED_INT;
+        // Half the index bandwidth when every vertex is addressable with 16
+        // bits
+        if (m_verts.size() <= 65536) {
+            m_shortIndices.resize(m_indices.size());
+            for (size_t i = 0; i < m_indices.size(); i++) {
+                m_shortIndices[i] = static_cast<GLushort>(m_indices[i]);
+            }
+            indexData = m_shortIndices.data();
+            indexBytes = m_shortIndices.size() * sizeof(GLushort);
+            layer->indexType = GL_UNSIGNED_SHORT;
+        }
+        GLsizeiptr vertexBytes = m_verts.size() * sizeof(DebugVertex);
+
+        glBindBuffer(GL_ARRAY_BUFFER, layer->vbo);
+        if (vertexBytes > layer->vertexCapacity || usage == GL_STATIC_DRAW) {
+            // Grow the buffer
+            glBufferData(GL_ARRAY_BUFFER, vertexBytes, m_verts.data(), usage);
+            layer->vertexCapacity = vertexBytes;
+        } else {
+            // Orphan the buffer and upload the data
+            glBufferData(GL_ARRAY_BUFFER, layer->vertexCapacity, nullptr,
+                usage);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, m_verts.data());
+        }
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-        // Orphan the buffer
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint),
-            nullptr, GL_DYNAMIC_DRAW);
-        // Upload the data
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_indices.size() *
-            sizeof(GLuint), m_indices.data());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, layer->ibo);
+        if (indexBytes > layer->indexCapacity || usage == GL_STATIC_DRAW) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData,
+                usage);
+            layer->indexCapacity = indexBytes;
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, layer->indexCapacity,
+                nullptr, usage);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, indexData);
+        }
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-        m_numElements = static_cast<int>(m_indices.size());
+        layer->numElements = static_cast<int>(m_indices.size());
         m_indices.clear();
         m_verts.clear();
     }
 
-    glm::vec2 RotatePoint(const glm::vec2& pos, float angle) {
-        glm::vec2 newv;
-        newv.x = pos.x * cos(angle) - pos.y * sin(angle);
-        newv.y = pos.x * sin(angle) + pos.y * cos(angle);
-        return newv;
+    void DebugRenderer::End() {
+        UploadLayer(&m_transient, GL_STREAM_DRAW);
+    }
+
+    int DebugRenderer::CreateLayer() {
+        // Reuse a destroyed layer slot if there is one
+        int id = 0;
+        while (id < static_cast<int>(m_layers.size()) && m_layers[id].isAlive)
+            id++;
+        if (id == static_cast<int>(m_layers.size()))
+            m_layers.emplace_back();
+
+        m_layers[id] = Layer();
+        InitLayer(&m_layers[id]);
+        return id;
+    }
+
+    void DebugRenderer::BeginLayer(int layer) {
+        if (m_recordingLayer != -1)
+            EndLayer();
+        m_recordingLayer = layer;
+        // Put the transient geometry drawn so far aside
+        m_transientVerts.swap(m_verts);
+        m_transientIndices.swap(m_indices);
+        m_verts.clear();
+        m_indices.clear();
+    }
+
+    void DebugRenderer::EndLayer() {
+        if (m_recordingLayer == -1)
+            return;
+        UploadLayer(&m_layers[m_recordingLayer], GL_STATIC_DRAW);
+        m_recordingLayer = -1;
+        m_verts.swap(m_transientVerts);
+        m_indices.swap(m_transientIndices);
+    }
+
+    void DebugRenderer::SetLayerVisible(int layer, bool visible) {
+        m_layers[layer].isVisible = visible;
+    }
+
+    void DebugRenderer::DestroyLayer(int layer) {
+        DisposeLayer(&m_layers[layer]);
     }
 
     void DebugRenderer::DrawLine(const glm::vec2& a, const glm::vec2& b,
@@ -142,69 +208,101 @@ void main() {
 
     void DebugRenderer::DrawBox(const glm::vec4& destRect,
         const ColorRGBA8& color, float angle) {
-        int i = static_cast<int>(m_verts.size());
-        m_verts.resize(m_verts.size() + 4);
-
         glm::vec2 halfDims(destRect.z / 2.0f, destRect.w / 2.0f);
+        glm::vec2 center = glm::vec2(destRect.x, destRect.y) + halfDims;
+
+        // Rotate the corners with a single sin/cos pair
+        float c = cos(angle);
+        float s = sin(angle);
+        glm::vec2 axisX(c * halfDims.x, s * halfDims.x);
+        glm::vec2 axisY(-s * halfDims.y, c * halfDims.y);
+
+        glm::vec2 corners[4] = {
+            center - axisX + axisY,  // Top left
+            center - axisX - axisY,  // Bottom left
+            center + axisX - axisY,  // Bottom right
+            center + axisX + axisY  // Top right
+        };
+        DrawPolygon(corners, 4, color);
+    }
 
-        // Get points centered at origin
-        glm::vec2 tl(-halfDims.x, halfDims.y);
-        glm::vec2 bl(-halfDims.x, -halfDims.y);
-        glm::vec2 br(halfDims.x, -halfDims.y);
-        glm::vec2 tr(halfDims.x, halfDims.y);
-
-        glm::vec2 positionOffset(destRect.x, destRect.y);
-
-        // Rotate the points
-        m_verts[i].position = RotatePoint(tl, angle) + halfDims +
-            positionOffset;
-        m_verts[i + 1].position = RotatePoint(bl, angle) + halfDims +
-            positionOffset;
-        m_verts[i + 2].position = RotatePoint(br, angle) + halfDims +
-            positionOffset;
-        m_verts[i + 3].position = RotatePoint(tr, angle) + halfDims +
-            positionOffset;
-
-        for (int j = i; j < i + 4; j++) {
-            m_verts[j].color = color;
-        }
-
-        m_indices.reserve(m_indices.size() + 8);
-
-        m_indices.push_back(i);
-        m_indices.push_back(i + 1);
+    void DebugRenderer::DrawPolygon(const glm::vec2* points, int count,
+        const ColorRGBA8& color) {
+        // Not even a line, and nothing to index into
+        if (count < 2) return;
 
-        m_indices.push_back(i + 1);
-        m_indices.push_back(i + 2);
+        int start = static_cast<int>(m_verts.size());
+        m_verts.resize(m_verts.size() + count);
+        DebugVertex* verts = &m_verts[start];
+        for (int i = 0; i < count; i++) {
+            verts[i].position = points[i];
+            verts[i].color = color;
+        }
 
-        m_indices.push_back(i + 2);
-        m_indices.push_back(i + 3);
+        int startIndex = static_cast<int>(m_indices.size());
+        m_indices.resize(m_indices.size() + count * 2);
+        GLuint* indices = &m_indices[startIndex];
+        for (int i = 0; i < count; i++) {
+            indices[i * 2] = start + i;
+            indices[i * 2 + 1] = start + (i + 1 == count ? 0 : i + 1);
+        }
+    }
 
-        m_indices.push_back(i + 3);
-        m_indices.push_back(i);
+    // Unit circles with 8 to 256 segments, built once
+    const int NUM_CIRCLE_LODS = 6;
+    const int MIN_CIRCLE_SEGMENTS = 8;
+
+    static const std::vector<glm::vec2>& GetUnitCircle(int lod) {
+        static std::vector<glm::vec2> tables[NUM_CIRCLE_LODS];
+        static bool isBuilt = false;
+        if (!isBuilt) {
+            for (int l = 0; l < NUM_CIRCLE_LODS; l++) {
+                int numSegments = MIN_CIRCLE_SEGMENTS << l;
+                tables[l].resize(numSegments);
+                for (int i = 0; i < numSegments; i++) {
+                    float angle = (static_cast<float>(i) / numSegments) *
+                        PI * 2.0f;
+                    tables[l][i] = glm::vec2(cos(angle), sin(angle));
+                }
+            }
+            isBuilt = true;
+        }
+        return tables[lod];
     }
 
     void DebugRenderer::DrawCircle(const glm::vec2& center,
         const ColorRGBA8& color, float radius) {
-        static const int NUM_VERTS = 100;
+        // Use the fewest segments that keep the distance between a chord and
+        // the arc under half a pixel: r * (1 - cos(PI / n)) < 0.5, which is
+        // roughly n > PI * sqrt(r)
+        float screenRadius = radius * m_viewScale;
+        int lod = 0;
+        while (lod < NUM_CIRCLE_LODS - 1 && static_cast<float>(
+            MIN_CIRCLE_SEGMENTS << lod) < PI * sqrt(screenRadius)) {
+            lod++;
+        }
+        const std::vector<glm::vec2>& unitCircle = GetUnitCircle(lod);
+        const int numVerts = static_cast<int>(unitCircle.size());
+
         // Set up vertices
         int start = static_cast<int>(m_verts.size());
-        m_verts.resize(m_verts.size() + NUM_VERTS);
-        for (int i = 0; i < NUM_VERTS; i++) {
-            float angle = (static_cast<float>(i) / NUM_VERTS) * PI * 2.0f;
-            m_verts[start + i].position.x = cos(angle) * radius + center.x;
-            m_verts[start + i].position.y = sin(angle) * radius + center.y;
-            m_verts[start + i].color = color;
+        m_verts.resize(m_verts.size() + numVerts);
+        DebugVertex* verts = &m_verts[start];
+        for (int i = 0; i < numVerts; i++) {
+            verts[i].position = unitCircle[i] * radius + center;
+            verts[i].color = color;
         }
 
         // Set up indices for indexed drawing
-        m_indices.reserve(m_indices.size() + NUM_VERTS * 2);
-        for (int i = 0; i < NUM_VERTS - 1; i++) {
-            m_indices.push_back(start + i);
-            m_indices.push_back(start + i + 1);
+        int startIndex = static_cast<int>(m_indices.size());
+        m_indices.resize(m_indices.size() + numVerts * 2);
+        GLuint* indices = &m_indices[startIndex];
+        for (int i = 0; i < numVerts - 1; i++) {
+            indices[i * 2] = start + i;
+            indices[i * 2 + 1] = start + i + 1;
         }
-        m_indices.push_back(start + NUM_VERTS - 1);
-        m_indices.push_back(start);
+        indices[numVerts * 2 - 2] = start + numVerts - 1;
+        indices[numVerts * 2 - 1] = start;
     }
 
     void DebugRenderer::Render(const glm::mat4& projectionMatrix,
@@ -215,21 +313,40 @@ void main() {
         glUniformMatrix4fv(pUniform, 1, GL_FALSE, &projectionMatrix[0][0]);
 
         glLineWidth(lineWidth);
-        glBindVertexArray(m_vao);
-        glDrawElements(GL_LINES, m_numElements, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        for (auto& layer : m_layers) {
+            if (layer.isAlive && layer.isVisible)
+                RenderLayer(layer);
+        }
+        RenderLayer(m_transient);
 
         m_program.Unuse();
     }
 
+    void DebugRenderer::RenderLayer(const Layer& layer) {
+        if (layer.numElements == 0)
+            return;
+        glBindVertexArray(layer.vao);
+        glDrawElements(GL_LINES, layer.numElements, layer.indexType, 0);
+        glBindVertexArray(0);
+    }
+
     void DebugRenderer::Dispose() {
-        if (m_vao)
-            glDeleteVertexArrays(1, &m_vao);
-        if (m_vbo)
-            glDeleteBuffers(1, &m_vbo);
-        if (m_ibo)
-            glDeleteBuffers(1, &m_ibo);
+        for (auto& layer : m_layers) {
+            DisposeLayer(&layer);
+        }
+        m_layers.clear();
+        DisposeLayer(&m_transient);
 
         m_program.Dispose();
     }
+
+    void DebugRenderer::DisposeLayer(Layer* layer) {
+        if (layer->vao)
+            glDeleteVertexArrays(1, &layer->vao);
+        if (layer->vbo)
+            glDeleteBuffers(1, &layer->vbo);
+        if (layer->ibo)
+            glDeleteBuffers(1, &layer->ibo);
+        *layer = Layer();
+    }
 }  // namespace GangerEngine
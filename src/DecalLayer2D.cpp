@@ -0,0 +1,256 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/DecalLayer2D.h>
+#include <GangerEngine/Camera2D.h>
+#include <GangerEngine/GangerErrors.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace GangerEngine {
+    const char* DECAL_VERT_SRC = R"(#version 330
+//The vertex shader operates on each vertex
+
+in vec2 vertexPosition;
+in vec2 vertexUV;
+in vec4 vertexColor;
+
+out vec2 fragmentUV;
+out vec4 fragmentColor;
+
+uniform mat4 P;
+
+void main() {
+    gl_Position.xy = (P * vec4(vertexPosition, 0.0, 1.0)).xy;
+    gl_Position.z = 0.0;
+    gl_Position.w = 1.0;
+
+    fragmentColor = vertexColor;
+
+    //Textures are stored upside down, like in the demo shaders
+    fragmentUV = vec2(vertexUV.x, 1.0 - vertexUV.y);
+})";
+
+    const char* DECAL_FRAG_SRC = R"(#version 330
+//The fragment shader operates on each pixel in a given polygon
+
+in vec2 fragmentUV;
+in vec4 fragmentColor;
+
+out vec4 color;
+
+uniform sampler2D mySampler;
+
+void main() {
+    color = fragmentColor * texture(mySampler, fragmentUV);
+})";
+
+    DecalLayer2D::DecalLayer2D() {
+        // Empty
+    }
+
+    DecalLayer2D::~DecalLayer2D() {
+        Dispose();
+    }
+
+    void DecalLayer2D::Init(float chunkSize, int chunkResolution) {
+        m_chunkSize = chunkSize;
+        m_chunkResolution = chunkResolution;
+
+        m_program.CompileShadersFromSource(DECAL_VERT_SRC, DECAL_FRAG_SRC);
+        m_program.AddAttribute("vertexPosition");
+        m_program.AddAttribute("vertexUV");
+        m_program.AddAttribute("vertexColor");
+        m_program.LinkShaders();
+
+        m_spriteBatch.Init();
+        m_isInitialized = true;
+    }
+
+    void DecalLayer2D::AddDecal(const glm::vec4& destRect, GLuint texture,
+        const ColorRGBA8& color) {
+        m_pending.push_back({ destRect, texture, color });
+    }
+
+    DecalLayer2D::Chunk& DecalLayer2D::GetChunk(int x, int y) {
+        auto it = m_chunks.find(ChunkKey(x, y));
+        if (it != m_chunks.end())
+            return it->second;
+
+        Chunk& chunk = m_chunks[ChunkKey(x, y)];
+        chunk.coord = glm::ivec2(x, y);
+
+        glGenTextures(1, &chunk.texture);
+        glBindTexture(GL_TEXTURE_2D, chunk.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_chunkResolution,
+            m_chunkResolution, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &chunk.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, chunk.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, chunk.texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+            GL_FRAMEBUFFER_COMPLETE) {
+            FatalError("Decal chunk framebuffer is incomplete!");
+        }
+
+        // Start out fully transparent
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        return chunk;
+    }
+
+    void DecalLayer2D::Flush() {
+        if (m_pending.empty() || !m_isInitialized)
+            return;
+
+        // Save the state we are about to change
+        GLint previousFbo = 0;
+        GLint previousViewport[4];
+        GLfloat previousClearColor[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+        // Find every chunk a decal overlaps, a decal on a chunk border is
+        // baked into all of them
+        m_dirtyChunks.clear();
+        for (auto& d : m_pending) {
+            int x0 = static_cast<int>(std::floor(d.destRect.x / m_chunkSize));
+            int y0 = static_cast<int>(std::floor(d.destRect.y / m_chunkSize));
+            int x1 = static_cast<int>(std::floor((d.destRect.x +
+                d.destRect.z) / m_chunkSize));
+            int y1 = static_cast<int>(std::floor((d.destRect.y +
+                d.destRect.w) / m_chunkSize));
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    Chunk* chunk = &GetChunk(x, y);
+                    if (std::find(m_dirtyChunks.begin(), m_dirtyChunks.end(),
+                        chunk) == m_dirtyChunks.end()) {
+                        m_dirtyChunks.push_back(chunk);
+                    }
+                }
+            }
+        }
+
+        m_program.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(m_program.GetUniformLocation("mySampler"), 0);
+        GLint pUniform = m_program.GetUniformLocation("P");
+
+        // Colors are blended as usual, alpha accumulates so the chunk ends up
+        // with premultiplied colors
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+            GL_ONE_MINUS_SRC_ALPHA);
+        glViewport(0, 0, m_chunkResolution, m_chunkResolution);
+
+        for (auto& chunk : m_dirtyChunks) {
+            glm::vec2 origin = glm::vec2(chunk->coord) * m_chunkSize;
+            glm::mat4 projection = glm::ortho(origin.x, origin.x + m_chunkSize,
+                origin.y, origin.y + m_chunkSize);
+            glUniformMatrix4fv(pUniform, 1, GL_FALSE, &projection[0][0]);
+
+            m_spriteBatch.Begin(GlyphSortType::NONE);
+            glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
+            for (auto& d : m_pending) {
+                if (d.destRect.x < origin.x + m_chunkSize &&
+                    d.destRect.x + d.destRect.z > origin.x &&
+                    d.destRect.y < origin.y + m_chunkSize &&
+                    d.destRect.y + d.destRect.w > origin.y) {
+                    m_spriteBatch.Draw(d.destRect, uvRect, d.texture, 0.0f,
+                        d.color);
+                }
+            }
+            m_spriteBatch.End();
+
+            glBindFramebuffer(GL_FRAMEBUFFER, chunk->fbo);
+            m_spriteBatch.RenderBatch();
+        }
+        m_pending.clear();
+
+        m_program.Unuse();
+
+        // Restore the state
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFbo));
+        glViewport(previousViewport[0], previousViewport[1],
+            previousViewport[2], previousViewport[3]);
+        glClearColor(previousClearColor[0], previousClearColor[1],
+            previousClearColor[2], previousClearColor[3]);
+    }
+
+    void DecalLayer2D::Render(const glm::mat4& projectionMatrix,
+        Camera2D* camera) {
+        Flush();
+        if (m_chunks.empty())
+            return;
+
+        m_program.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(m_program.GetUniformLocation("mySampler"), 0);
+        glUniformMatrix4fv(m_program.GetUniformLocation("P"), 1, GL_FALSE,
+            &projectionMatrix[0][0]);
+
+        // The chunk textures hold premultiplied colors
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        // The chunk textures are not stored upside down, so flip the UVs
+        // back to cancel the flip in the shader
+        glm::vec4 uvRect(0.0f, 1.0f, 1.0f, -1.0f);
+        ColorRGBA8 white(255, 255, 255, 255);
+        glm::vec2 dims(m_chunkSize);
+        m_spriteBatch.Begin(GlyphSortType::NONE);
+        for (auto& it : m_chunks) {
+            glm::vec2 origin = glm::vec2(it.second.coord) * m_chunkSize;
+            if (camera && !camera->IsBoxInView(origin, dims))
+                continue;
+            m_spriteBatch.Draw(glm::vec4(origin, dims), uvRect,
+                it.second.texture, 0.0f, white);
+        }
+        m_spriteBatch.End();
+        m_spriteBatch.RenderBatch();
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_program.Unuse();
+    }
+
+    void DecalLayer2D::Clear() {
+        for (auto& it : m_chunks) {
+            glDeleteFramebuffers(1, &it.second.fbo);
+            glDeleteTextures(1, &it.second.texture);
+        }
+        m_chunks.clear();
+        m_pending.clear();
+    }
+
+    void DecalLayer2D::Dispose() {
+        if (!m_isInitialized)
+            return;
+        Clear();
+        m_spriteBatch.Dispose();
+        m_program.Dispose();
+        m_isInitialized = false;
+    }
+}  // namespace GangerEngine
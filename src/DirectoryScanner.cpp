@@ -0,0 +1,233 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/DirectoryScanner.h>
+#include <GangerEngine/AssetPackage.h>
+#include <GangerEngine/IOManager.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GangerEngine {
+    static void AppendMatching(const std::vector<DirEntry>& listing,
+        const std::string& pattern, std::vector<DirEntry>* entries) {
+        for (auto& entry : listing) {
+            if (pattern.empty() || IOManager::MatchGlob(pattern,
+                entry.path.substr(entry.path.rfind('/') + 1))) {
+                entries->push_back(entry);
+            }
+        }
+    }
+
+    DirectoryScanner::DirectoryScanner() {
+#ifdef __linux__
+        m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    }
+
+    DirectoryScanner::~DirectoryScanner() {
+#ifdef __linux__
+        if (m_inotifyFd >= 0) close(m_inotifyFd);
+#endif
+    }
+
+    bool DirectoryScanner::Scan(const std::string& directory,
+        bool isRecursive, const std::string& pattern,
+        std::vector<DirEntry>* entries) {
+        std::string root = AssetPackage::NormalizePath(directory);
+        while (root.size() > 1 && root.back() == '/') root.pop_back();
+        if (root.empty()) root = ".";
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ProcessEvents();
+
+        ListingKey key(root, isRecursive);
+        auto it = m_listings.find(key);
+        if (it == m_listings.end()) {
+            std::vector<DirEntry> listing;
+            bool isWatched = m_inotifyFd >= 0;
+            if (!Walk(root, isRecursive, &listing, &isWatched)) return false;
+            std::sort(listing.begin(), listing.end(),
+                [] (const DirEntry& a, const DirEntry& b) {
+                    return a.path < b.path;
+                });
+
+            // Without a watch nobody would tell when it goes stale
+            if (!isWatched) {
+                AppendMatching(listing, pattern, entries);
+                return true;
+            }
+            it = m_listings.emplace(key, std::move(listing)).first;
+        }
+
+        AppendMatching(it->second, pattern, entries);
+        return true;
+    }
+
+    void DirectoryScanner::Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_listings.clear();
+    }
+
+    size_t DirectoryScanner::GetNumCached() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ProcessEvents();
+        return m_listings.size();
+    }
+
+    bool DirectoryScanner::Walk(const std::string& directory,
+        bool isRecursive, std::vector<DirEntry>* entries, bool* isWatched) {
+        // Watched before it is read, so no change slips in between
+        if (*isWatched) *isWatched = Watch(directory);
+
+        std::vector<std::string> subdirectories;
+#ifdef _WIN32
+        WIN32_FIND_DATAA findData;
+        HANDLE find = FindFirstFileA((directory + "/*").c_str(), &findData);
+        if (find == INVALID_HANDLE_VALUE) return false;
+        do {
+            std::string name = findData.cFileName;
+            if (name == "." || name == "..") continue;
+
+            DirEntry entry;
+            entry.path = directory + "/" + name;
+            entry.isDirectory =
+                (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            // Junctions could loop back up the tree
+            bool isLink =
+                (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+            if (entry.isDirectory && !isLink) {
+                subdirectories.push_back(entry.path);
+            }
+            entries->push_back(std::move(entry));
+        } while (FindNextFileA(find, &findData));
+        FindClose(find);
+#else
+        DIR* dir = opendir(directory.c_str());
+        if (dir == nullptr) return false;
+        while (dirent* dirEntry = readdir(dir)) {
+            std::string name = dirEntry->d_name;
+            if (name == "." || name == "..") continue;
+
+            DirEntry entry;
+            entry.path = directory + "/" + name;
+            // Links are listed as what they point to, but never followed,
+            // so they can not loop back up the tree
+            bool isLink = dirEntry->d_type == DT_LNK;
+            if (dirEntry->d_type == DT_UNKNOWN || isLink) {
+                struct stat entryStat;
+                int result = isLink ? stat(entry.path.c_str(), &entryStat) :
+                    lstat(entry.path.c_str(), &entryStat);
+                entry.isDirectory = result == 0 && S_ISDIR(entryStat.st_mode);
+                isLink |= result == 0 && S_ISLNK(entryStat.st_mode);
+            } else {
+                entry.isDirectory = dirEntry->d_type == DT_DIR;
+            }
+            if (entry.isDirectory && !isLink) {
+                subdirectories.push_back(entry.path);
+            }
+            entries->push_back(std::move(entry));
+        }
+        closedir(dir);
+#endif
+
+        if (isRecursive) {
+            for (auto& subdirectory : subdirectories) {
+                Walk(subdirectory, true, entries, isWatched);
+            }
+        }
+        return true;
+    }
+
+    bool DirectoryScanner::Watch(const std::string& directory) {
+#ifdef __linux__
+        // The same directory gets the same descriptor back, whatever path
+        // reached it, so every alias is kept to be invalidated
+        int watch = inotify_add_watch(m_inotifyFd, directory.c_str(),
+            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+        if (watch < 0) return false;
+        m_watches[watch].insert(directory);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void DirectoryScanner::ProcessEvents() {
+#ifdef __linux__
+        if (m_inotifyFd < 0 || m_watches.empty()) return;
+
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) return;
+
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* event =
+                    reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                // Events were lost, anything may have changed
+                if (event->mask & IN_Q_OVERFLOW) {
+                    m_listings.clear();
+                    continue;
+                }
+
+                auto watch = m_watches.find(event->wd);
+                if (watch == m_watches.end()) continue;
+                for (auto& directory : watch->second) {
+                    Invalidate(directory);
+                }
+                // Gone with its directory
+                if (event->mask & IN_IGNORED) m_watches.erase(watch);
+            }
+        }
+#endif
+    }
+
+    void DirectoryScanner::Invalidate(const std::string& directory) {
+        for (auto it = m_listings.begin(); it != m_listings.end();) {
+            const std::string& root = it->first.first;
+            bool isRecursive = it->first.second;
+            // A recursive listing also holds the directories under it
+            bool isStale = directory == root || (isRecursive &&
+                directory.size() > root.size() &&
+                directory.compare(0, root.size(), root) == 0 &&
+                directory[root.size()] == '/');
+            if (isStale) {
+                it = m_listings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}  // namespace GangerEngine
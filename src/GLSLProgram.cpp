@@ -17,6 +17,7 @@
 #include <GangerEngine/GLSLProgram.h>
 #include <GangerEngine/GangerErrors.h>
 #include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
 
 #include <string>
 #include <vector>
@@ -36,17 +37,25 @@ namespace GangerEngine {
     // Compiles the shaders into a form that your GPU can understand
     void GLSLProgram::CompileShaders(const std::string& vertexShaderFilePath,
         const std::string& fragmentShaderFilePath) {
-        std::string vertSource;
-        std::string fragSource;
-
-        IOManager::ReadFileToBuffer(vertexShaderFilePath, vertSource);
-        IOManager::ReadFileToBuffer(fragmentShaderFilePath, fragSource);
+        // GL takes the sources with their lengths, so the files are handed
+        // over as mapped, without a copy or a null terminator
+        MappedFile vertFile;
+        MappedFile fragFile;
+        if (!IOManager::MapFile(vertexShaderFilePath, &vertFile)) {
+            FatalError("Failed to open " + vertexShaderFilePath);
+        }
+        if (!IOManager::MapFile(fragmentShaderFilePath, &fragFile)) {
+            FatalError("Failed to open " + fragmentShaderFilePath);
+        }
 
-        CompileShadersFromSource(vertSource.c_str(), fragSource.c_str());
+        CompileShadersFromSource(vertFile.GetSize() ? vertFile.GetText() : "",
+            fragFile.GetSize() ? fragFile.GetText() : "",
+            static_cast<int>(vertFile.GetSize()),
+            static_cast<int>(fragFile.GetSize()));
     }
 
     void GLSLProgram::CompileShadersFromSource(const char* vertexSource,
-        const char* fragmentSource) {
+        const char* fragmentSource, int vertexLength, int fragmentLength) {
         // Vertex and fragment shaders are successfully compiled.
         // Now time to link them together into a program.
         // Get a program object.
@@ -65,8 +74,10 @@ namespace GangerEngine {
         }
 
         // Compile each shader
-        CompileShader(vertexSource, "Vertex Shader", m_vertexShaderID);
-        CompileShader(fragmentSource, "Fragment Shader", m_fragmentShaderID);
+        CompileShader(vertexSource, vertexLength, "Vertex Shader",
+            m_vertexShaderID);
+        CompileShader(fragmentSource, fragmentLength, "Fragment Shader",
+            m_fragmentShaderID);
     }
 
     void GLSLProgram::LinkShaders() {
@@ -148,11 +159,12 @@ namespace GangerEngine {
     }
 
     // Compiles a single shader file
-    void GLSLProgram::CompileShader(const char* source, const std::string& name,
-        GLuint id) {
+    void GLSLProgram::CompileShader(const char* source, int length,
+        const std::string& name, GLuint id) {
         // Tell opengl that we want to use fileContents as the contents of the
-        // shader file
-        glShaderSource(id, 1, &source, nullptr);
+        // shader file. A negative length means it is null terminated.
+        GLint sourceLength = length;
+        glShaderSource(id, 1, &source, length < 0 ? nullptr : &sourceLength);
 
         // Compile the shader
         glCompileShader(id);
@@ -17,22 +17,70 @@
 #include <GL/glew.h>  // Include BEFORE GUI.h
 
 #include <GangerEngine/GUI.h>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
 #include <SDL/SDL_timer.h>
 #include <utf8/utf8.h>
 
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
 
 
 namespace GangerEngine {
+    void GUIResourceProvider::loadRawDataContainer(
+        const CEGUI::String& filename, CEGUI::RawDataContainer& output,
+        const CEGUI::String& resourceGroup) {
+        std::string filePath = getFinalFilename(filename,
+            resourceGroup).c_str();
+        MappedFile file;
+        if (!IOManager::MapFile(filePath, &file)) {
+            CEGUI_THROW(CEGUI::FileIOException(
+                "Failed to open " + CEGUI::String(filePath.c_str())));
+        }
+
+        // Released by CEGUI with its own allocator
+        CEGUI::uint8* data = CEGUI_NEW_ARRAY_PT(CEGUI::uint8, file.GetSize(),
+            CEGUI::RawDataContainer);
+        if (file.GetSize() > 0) memcpy(data, file.GetData(), file.GetSize());
+        output.setData(data);
+        output.setSize(file.GetSize());
+    }
+
+    size_t GUIResourceProvider::getResourceGroupFileNames(
+        std::vector<CEGUI::String>& out_vec,
+        const CEGUI::String& file_pattern,
+        const CEGUI::String& resource_group) {
+        std::string directory = getFinalFilename("", resource_group).c_str();
+        std::string pattern = file_pattern.c_str();
+        std::vector<std::string> names;
+        IOManager::GetFileNames(directory, &names);
+
+        size_t numAdded = 0;
+        for (auto& name : names) {
+            if (IOManager::MatchGlob(pattern, name)) {
+                out_vec.push_back(name.c_str());
+                numAdded++;
+            }
+        }
+        return numAdded;
+    }
+
     CEGUI::OpenGL3Renderer* GUI::m_renderer = nullptr;
+    std::unique_ptr<GUIResourceProvider> GUI::m_resourceProvider;
+    int GUI::m_numGUIs = 0;
 
     void GUI::Init(const std::string& resourceDirectory) {
-        // Check if the renderer and system were not already initialized
+        // Check if the renderer and system were not already initialized.
+        // This is what bootstrapSystem does, with our resource provider.
         if (m_renderer == nullptr) {
-            m_renderer = &CEGUI::OpenGL3Renderer::bootstrapSystem();
+            m_renderer = &CEGUI::OpenGL3Renderer::create();
+            m_resourceProvider = std::make_unique<GUIResourceProvider>();
+            CEGUI::System::create(*m_renderer, m_resourceProvider.get());
         }
+        m_numGUIs++;
 
         CEGUI::DefaultResourceProvider* rp =
             static_cast<CEGUI::DefaultResourceProvider*>(
@@ -69,6 +117,14 @@ namespace GangerEngine {
         CEGUI::WindowManager::getSingleton().destroyWindow(m_root);
         m_context = nullptr;
         m_root = nullptr;
+
+        if (--m_numGUIs == 0) {
+            CEGUI::System::destroy();
+            CEGUI::OpenGL3Renderer::destroy(*m_renderer);
+            m_renderer = nullptr;
+            // The system used it until now
+            m_resourceProvider.reset();
+        }
     }
 
     void GUI::Draw() {
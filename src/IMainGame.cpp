@@ -15,9 +15,11 @@
 */
 
 #include <GangerEngine/IMainGame.h>
+#include <GangerEngine/IOManager.h>
 #include <GangerEngine/Timing.h>
 #include <GangerEngine/ScreenList.h>
 #include <GangerEngine/IGameScreen.h>
+#include <GangerEngine/ResourceManager.h>
 
 namespace GangerEngine {
     IMainGame::IMainGame() {
@@ -40,15 +42,24 @@ namespace GangerEngine {
             limiter.Begin();
 
             inputManager.Update();
+            // Hand the finished file reads and writes to their callbacks
+            IOManager::ProcessAsyncCompletions();
             // Call the custom update and draw method
             Update();
             if (m_isRunning) {
+                // Spread the async texture uploads over the frames
+                ResourceManager::ProcessTextureUploads();
+
                 Draw();
 
                 m_fps = limiter.End();
                 m_window.SwapBuffer();
             }
         }
+
+        // Let the saves still queued reach the disk
+        IOManager::GetAsyncIO().WaitIdle();
+        IOManager::ProcessAsyncCompletions();
     }
 
     void IMainGame::ExitGame() {
@@ -116,19 +127,27 @@ namespace GangerEngine {
                     break;
                 case ScreenState::CHANGE_NEXT:
                     m_currentScreen->OnExit();
+                    // The textures only the old screen got are released
+                    // once the new one got its own
+                    ResourceManager::BeginTextureScope();
                     m_currentScreen = m_screenList->MoveNext();
                     if (m_currentScreen) {
                         m_currentScreen->SetRunning();
                         m_currentScreen->OnEntry();
                     }
+                    ResourceManager::EvictUnusedTextures();
                     break;
                 case ScreenState::CHANGE_PREVIOUS:
                     m_currentScreen->OnExit();
+                    // The textures only the old screen got are released
+                    // once the new one got its own
+                    ResourceManager::BeginTextureScope();
                     m_currentScreen = m_screenList->MovePrevious();
                     if (m_currentScreen) {
                         m_currentScreen->SetRunning();
                         m_currentScreen->OnEntry();
                     }
+                    ResourceManager::EvictUnusedTextures();
                     break;
                 case ScreenState::EXIT_APPLICATION:
                     ExitGame();
@@ -15,85 +15,378 @@
 */
 
 #include <GangerEngine/IOManager.h>
+#include <GangerEngine/AssetPackage.h>
+#include <GangerEngine/Compression.h>
+#include <GangerEngine/MappedFile.h>
 
 #include <filesystem/path.h>
-#include <filesystem/resolver.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <fstream>
 
 namespace GangerEngine {
-    bool IOManager::ReadFileToBuffer(std::string filePath,
-        std::vector<unsigned char>& buffer) {
+    std::vector<IOManager::Mount> IOManager::m_mounts;
+
+    // Reads a raw package entry into a vector or a string
+    template <class Buffer>
+    static bool ReadPackageEntry(const std::string& filePath,
+        const AssetPackage& package, const PackageEntry& entry,
+        Buffer& buffer) {
+        buffer.resize(static_cast<size_t>(entry.rawSize));
+        if (buffer.empty()) return true;
+
+        unsigned char* dst = reinterpret_cast<unsigned char*>(&buffer[0]);
+        if (entry.flags & ASSET_FLAG_COMPRESSED) {
+            if (!DecompressLZ(package.GetPayload(entry),
+                static_cast<size_t>(entry.size), dst, buffer.size())) {
+                printf("%s is corrupt in %s\n", filePath.c_str(),
+                    package.GetFilePath().c_str());
+                return false;
+            }
+        } else {
+            memcpy(dst, package.GetPayload(entry), buffer.size());
+        }
+        return true;
+    }
+
+    // Reads a whole file from disk into a vector or a string
+    template <class Buffer>
+    static bool ReadFromDisk(const std::string& filePath, Buffer& buffer) {
         std::ifstream file(filePath, std::ios::binary);
         if (file.fail()) {
             perror(filePath.c_str());
             return false;
         }
 
-        // Seek to the end
+        // Seek to the end to get the file size
         file.seekg(0, std::ios::end);
-
-        // Get the file size
-        unsigned int fileSize = (unsigned int)file.tellg();
+        std::streamoff fileSize = file.tellg();
         file.seekg(0, std::ios::beg);
+        if (fileSize < 0 ||
+            static_cast<uint64_t>(fileSize) > buffer.max_size()) {
+            printf("%s is too big to read\n", filePath.c_str());
+            return false;
+        }
 
-        // Reduce the file size by any header bytes that might be present
-        fileSize -= (unsigned int)file.tellg();
+        buffer.resize(static_cast<size_t>(fileSize));
+        if (buffer.empty()) return true;
 
-        buffer.resize(fileSize);
         file.read(reinterpret_cast<char*>(&buffer[0]), fileSize);
-        file.close();
-
+        if (file.gcount() != fileSize) {
+            printf("Could not read %s\n", filePath.c_str());
+            return false;
+        }
         return true;
     }
 
+    // Reads a whole file into a vector or a string, wherever it resolves to
+    template <class Buffer>
+    static bool ReadMounted(const std::string& filePath, Buffer& buffer) {
+        const AssetPackage* package;
+        std::string diskPath;
+        const PackageEntry* entry = IOManager::Resolve(filePath, &package,
+            &diskPath);
+        if (entry != nullptr &&
+            entry->type == static_cast<uint32_t>(AssetType::RAW)) {
+            return ReadPackageEntry(filePath, *package, *entry, buffer);
+        }
+        return ReadFromDisk(diskPath, buffer);
+    }
+
+    bool IOManager::ReadFileToBuffer(std::string filePath,
+        std::vector<unsigned char>& buffer) {
+        return ReadMounted(filePath, buffer);
+    }
+
     bool IOManager::ReadFileToBuffer(std::string filePath,
         std::string& buffer) {
-        std::ifstream file(filePath, std::ios::binary);
-        if (file.fail()) {
-            perror(filePath.c_str());
+        return ReadMounted(filePath, buffer);
+    }
+
+    bool IOManager::MapFile(const std::string& filePath, MappedFile* file) {
+        const AssetPackage* package;
+        std::string diskPath;
+        const PackageEntry* entry = Resolve(filePath, &package, &diskPath);
+        if (entry == nullptr ||
+            entry->type != static_cast<uint32_t>(AssetType::RAW)) {
+            return file->Open(diskPath);
+        }
+
+        size_t size = static_cast<size_t>(entry->rawSize);
+        if (!(entry->flags & ASSET_FLAG_COMPRESSED)) {
+            file->SetView(package->GetPayload(*entry), size);
+            return true;
+        }
+
+        std::unique_ptr<unsigned char[]> buffer(new unsigned char[size]);
+        if (size > 0 && !DecompressLZ(package->GetPayload(*entry),
+            static_cast<size_t>(entry->size), buffer.get(), size)) {
+            printf("%s is corrupt in %s\n", filePath.c_str(),
+                package->GetFilePath().c_str());
+            file->Close();
             return false;
         }
+        file->SetBuffer(std::move(buffer), size);
+        return true;
+    }
 
-        // Seek to the end
-        file.seekg(0, std::ios::end);
+    static DirectoryScanner& GetDirectoryScanner() {
+        static DirectoryScanner scanner;
+        return scanner;
+    }
 
-        // Get the file size
-        unsigned int fileSize = (unsigned int)file.tellg();
-        file.seekg(0, std::ios::beg);
+    bool IOManager::GetDirectoryEntries(const char* path,
+        std::vector<DirEntry>* rvEntries) {
+        return ScanDirectory(path, rvEntries);
+    }
+
+    bool IOManager::ScanDirectory(const std::string& directory,
+        std::vector<DirEntry>* entries, bool isRecursive,
+        const std::string& pattern) {
+        return GetDirectoryScanner().Scan(directory, isRecursive, pattern,
+            entries);
+    }
+
+    bool IOManager::MakeDirectory(const char* path) {
+        return filesystem::create_directory(filesystem::path(path));
+    }
+
+    void IOManager::MountPackage(const AssetPackage* package) {
+        UnmountPackage(package);
+        Mount mount;
+        mount.package = package;
+        m_mounts.push_back(mount);
+    }
+
+    void IOManager::UnmountPackage(const AssetPackage* package) {
+        m_mounts.erase(std::remove_if(m_mounts.begin(), m_mounts.end(),
+            [package] (const Mount& mount) {
+                return mount.package == package;
+            }), m_mounts.end());
+    }
+
+    void IOManager::MountDirectory(const std::string& directory) {
+        UnmountDirectory(directory);
+        Mount mount;
+        mount.package = nullptr;
+        mount.directory = AssetPackage::NormalizePath(directory);
+        if (mount.directory.empty() || mount.directory.back() != '/') {
+            mount.directory.push_back('/');
+        }
+        m_mounts.push_back(mount);
+    }
 
-        // Reduce the file size by any header bytes that might be present
-        fileSize -= (unsigned int)file.tellg();
+    void IOManager::UnmountDirectory(const std::string& directory) {
+        std::string normalized = AssetPackage::NormalizePath(directory);
+        if (normalized.empty() || normalized.back() != '/') {
+            normalized.push_back('/');
+        }
+        m_mounts.erase(std::remove_if(m_mounts.begin(), m_mounts.end(),
+            [&normalized] (const Mount& mount) {
+                return mount.package == nullptr &&
+                    mount.directory == normalized;
+            }), m_mounts.end());
+    }
+
+    const PackageEntry* IOManager::Resolve(const std::string& filePath,
+        const AssetPackage** package, std::string* diskPath) {
+        if (diskPath != nullptr) *diskPath = filePath;
+        if (m_mounts.empty()) return nullptr;
+
+        // Packages hash their paths, directories cost a stat each
+        bool isRelative = !filesystem::path(filePath).is_absolute();
+        std::string relativePath;
+        for (auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it) {
+            if (it->package != nullptr) {
+                const PackageEntry* entry = it->package->Find(filePath);
+                if (entry != nullptr) {
+                    *package = it->package;
+                    return entry;
+                }
+                continue;
+            }
+            if (!isRelative) continue;
 
-        buffer.resize(fileSize);
-        file.read(reinterpret_cast<char *>(&(buffer[0])), fileSize);
-        file.close();
+            if (relativePath.empty()) {
+                relativePath = AssetPackage::NormalizePath(filePath);
+            }
+            std::string path = it->directory + relativePath;
+            if (filesystem::path(path).is_file()) {
+                if (diskPath != nullptr) *diskPath = path;
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    const PackageEntry* IOManager::FindPackageEntry(
+        const std::string& filePath, const AssetPackage** package) {
+        return Resolve(filePath, package, nullptr);
+    }
 
+    std::string IOManager::ResolvePath(const std::string& filePath) {
+        const AssetPackage* package;
+        std::string diskPath;
+        Resolve(filePath, &package, &diskPath);
+        return diskPath;
+    }
+
+    // Adds the names of the files in a directory on disk, false if there is
+    // no such directory
+    static bool ListDiskFiles(const std::string& directory,
+        std::vector<std::string>* names) {
+        std::vector<DirEntry> entries;
+        if (!IOManager::ScanDirectory(directory, &entries)) return false;
+        for (auto& entry : entries) {
+            if (!entry.isDirectory) {
+                names->push_back(entry.path.substr(entry.path.rfind('/') + 1));
+            }
+        }
         return true;
     }
 
-    bool IOManager::GetDirectoryEntries(const char* path,
-        std::vector<DirEntry>* rvEntries) {
-        auto dpath = filesystem::path(path);
-        // Must be directory
-        if (!dpath.is_directory()) return false;
-
-        for (auto it = filesystem::resolver().begin(); it !=
-            filesystem::resolver().end(); ++it) {
-            rvEntries->emplace_back();
-            rvEntries->back().path = it->str();
-            if (it->is_directory()) {
-                rvEntries->back().isDirectory = true;
+    bool IOManager::GetFileNames(const std::string& directory,
+        std::vector<std::string>* names) {
+        std::string prefix = AssetPackage::NormalizePath(directory);
+        if (!prefix.empty() && prefix.back() != '/') prefix.push_back('/');
+
+        std::vector<std::string> found;
+        bool isFound = ListDiskFiles(prefix, &found);
+        bool isRelative = !filesystem::path(prefix).is_absolute();
+        for (auto& mount : m_mounts) {
+            if (mount.package == nullptr) {
+                if (isRelative) {
+                    isFound |= ListDiskFiles(mount.directory + prefix,
+                        &found);
+                }
+                continue;
+            }
+
+            // The entries right in the directory, not in its subdirectories
+            const PackageEntry* entries = mount.package->GetEntries();
+            for (uint32_t i = 0; i < mount.package->GetNumEntries(); i++) {
+                const char* path = mount.package->GetPath(entries[i]);
+                if (strncmp(path, prefix.c_str(), prefix.size()) != 0 ||
+                    strchr(path + prefix.size(), '/') != nullptr) {
+                    continue;
+                }
+                found.push_back(path + prefix.size());
+                isFound = true;
+            }
+        }
+
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+        names->insert(names->end(), found.begin(), found.end());
+        return isFound;
+    }
+
+    bool IOManager::MatchGlob(const std::string& pattern,
+        const std::string& name) {
+        // Greedy, going back to the last * on a mismatch
+        size_t p = 0, n = 0;
+        size_t starP = std::string::npos, starN = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() &&
+                (pattern[p] == '?' || pattern[p] == name[n])) {
+                p++;
+                n++;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                starP = p++;
+                starN = n;
+            } else if (starP != std::string::npos) {
+                p = starP + 1;
+                n = ++starN;
             } else {
-                rvEntries->back().isDirectory = false;
+                return false;
             }
         }
-        return true;
+        while (p < pattern.size() && pattern[p] == '*') p++;
+        return p == pattern.size();
     }
 
-    bool IOManager::MakeDirectory(const char* path) {
-        return filesystem::create_directory(filesystem::path(path));
+    // Points a read at where its path resolves to, mounted entries are
+    // copied out of their package instead
+    static void ResolveRequest(IORequest* request) {
+        if (request->operation != IOOperation::READ || request->source) {
+            return;
+        }
+
+        const AssetPackage* package;
+        std::string diskPath;
+        const PackageEntry* entry = IOManager::Resolve(request->filePath,
+            &package, &diskPath);
+        if (entry == nullptr ||
+            entry->type != static_cast<uint32_t>(AssetType::RAW)) {
+            request->filePath = diskPath;
+            return;
+        }
+
+        std::string filePath = request->filePath;
+        request->source = [filePath, package, entry] (
+            std::vector<unsigned char>& data) {
+            return ReadPackageEntry(filePath, *package, *entry, data);
+        };
+    }
+
+    IORequestId IOManager::SubmitAsync(IORequest request) {
+        ResolveRequest(&request);
+        return GetAsyncIO().Submit(std::move(request));
+    }
+
+    IORequestId IOManager::ReadFileAsync(const std::string& filePath,
+        IOCallback callback, IOPriority priority) {
+        IORequest request;
+        request.filePath = filePath;
+        request.callback = std::move(callback);
+        request.priority = priority;
+        return SubmitAsync(std::move(request));
+    }
+
+    std::future<IOResult> IOManager::ReadFileFuture(
+        const std::string& filePath, IOPriority priority, IORequestId* id) {
+        IORequest request;
+        request.filePath = filePath;
+        request.priority = priority;
+        ResolveRequest(&request);
+        return GetAsyncIO().SubmitFuture(std::move(request), id);
+    }
+
+    IORequestId IOManager::WriteFileAsync(const std::string& filePath,
+        std::vector<unsigned char> data, IOCallback callback,
+        IOPriority priority) {
+        IORequest request;
+        request.operation = IOOperation::WRITE;
+        request.filePath = filePath;
+        request.data = std::move(data);
+        request.callback = std::move(callback);
+        request.priority = priority;
+        return SubmitAsync(std::move(request));
+    }
+
+    bool IOManager::CancelAsync(IORequestId id) {
+        return GetAsyncIO().Cancel(id);
+    }
+
+    void IOManager::WaitForAsync(IORequestId id) {
+        GetAsyncIO().Wait(id);
+    }
+
+    void IOManager::ProcessAsyncCompletions() {
+        GetAsyncIO().ProcessCompletions();
+    }
+
+    AsyncIO& IOManager::GetAsyncIO() {
+        // Never destroyed, caches may still cancel their requests while the
+        // statics go away
+        static AsyncIO* asyncIO = new AsyncIO();
+        return *asyncIO;
     }
 }  // namespace GangerEngine
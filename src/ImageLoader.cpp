@@ -15,47 +15,223 @@
 */
 
 #include <GangerEngine/ImageLoader.h>
-#include <GangerEngine/PicoPNG.h>
 #include <GangerEngine/IOManager.h>
 #include <GangerEngine/GangerErrors.h>
+#include <GangerEngine/MappedFile.h>
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 
 namespace GangerEngine {
-    GLTexture ImageLoader::LoadPNG(std::string filePath, bool linear) {
-        // Create a GLTexture and initialize all its fields to 0
-        GLTexture texture = {};
+    PNGDecoderType ImageLoader::m_pngDecoder = PNGDecoderType::FAST;
 
-        // This is the input data to decodePNG, which we load from a file
-        std::vector<unsigned char> in;
-        // This is the output data from decodePNG, which is the pixel data for
-        // our texture
+    GLTexture ImageLoader::LoadPNG(std::string filePath, bool linear) {
+        // This is the pixel data for our texture
         std::vector<unsigned char> out;
+        int width, height;
 
-        unsigned long width, height;
+        if (!DecodePNGFile(filePath, out, width, height)) {
+            FatalError("Failed to load PNG file " + filePath);
+        }
+
+        ImageOptions options;
+        options.useMaskFormat = HasTextureSwizzle();
+        ProcessedImage image;
+        ImageProcessor::Process(&(out[0]), width, height, options, &image);
+
+        // Return a copy of the texture data
+        return UploadImage(filePath, image, linear);
+    }
 
-        // Read in the image file contents into a buffer
-        if (IOManager::ReadFileToBuffer(filePath, in) == false) {
-            FatalError("Failed to load PNG file to buffer!");
+    bool ImageLoader::DecodePNGFile(const std::string& filePath,
+        std::vector<unsigned char>& pixels, int& width, int& height) {
+        // The input data to decodePNG, mapped instead of copied
+        MappedFile in;
+        if (!IOManager::MapFile(filePath, &in) || in.GetSize() == 0) {
+            printf("Failed to load PNG file %s to buffer!\n",
+                filePath.c_str());
+            return false;
         }
 
+        return DecodePNGMemory(filePath, in.GetData(), in.GetSize(), pixels,
+            width, height);
+    }
+
+    bool ImageLoader::DecodePNGMemory(const std::string& filePath,
+        const unsigned char* data, size_t size,
+        std::vector<unsigned char>& pixels, int& width, int& height) {
         // Decode the .png format into an array of pixels
-        int errorCode = DecodePNG(out, width, height, &(in[0]), in.size());
+        unsigned long decodedWidth, decodedHeight;
+        int errorCode = DecodePNGImage(pixels, decodedWidth, decodedHeight,
+            data, size, m_pngDecoder);
         if (errorCode != 0) {
-            FatalError("decodePNG failed with error: " +
-                std::to_string(errorCode));
+            printf("decodePNG failed on %s with error: %d\n",
+                filePath.c_str(), errorCode);
+            return false;
         }
 
+        width = static_cast<int>(decodedWidth);
+        height = static_cast<int>(decodedHeight);
+        return true;
+    }
+
+    GLTexture ImageLoader::UploadRGBA(const std::string& filePath,
+        const unsigned char* pixels, int width, int height, bool linear) {
+        // Create a GLTexture and initialize all its fields to 0
+        GLTexture texture = {};
+
         // Generate the openGL texture object
         glGenTextures(1, &(texture.id));
 
         // Bind the texture object
         glBindTexture(GL_TEXTURE_2D, texture.id);
         // Upload the pixels to the texture
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<int>(width),
-            static_cast<int>(height), 0, GL_RGBA, GL_UNSIGNED_BYTE, &(out[0]));
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, pixels);
+
+        FinishTexture(linear);
+
+        // Unbind the texture
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        texture.width = width;
+        texture.height = height;
+        texture.filePath = filePath;
+
+        return texture;
+    }
+
+    GLTexture ImageLoader::UploadMipChain(const std::string& filePath,
+        const unsigned char* levels, int width, int height, int numMips,
+        bool linear) {
+        if (numMips <= 1) {
+            return UploadRGBA(filePath, levels, width, height, linear);
+        }
+
+        GLTexture texture = {};
+        glGenTextures(1, &(texture.id));
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+
+        int levelWidth = width;
+        int levelHeight = height;
+        for (int level = 0; level < numMips; level++) {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelWidth,
+                levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels);
+            levels += static_cast<size_t>(levelWidth) * levelHeight * 4;
+            levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+            levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numMips - 1);
 
+        FinishTexture(linear, false);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        texture.width = width;
+        texture.height = height;
+        texture.filePath = filePath;
+        return texture;
+    }
+
+    GLTexture ImageLoader::UploadImage(const std::string& filePath,
+        const ProcessedImage& image, bool linear) {
+        GLTexture texture = {};
+        glGenTextures(1, &(texture.id));
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        UploadLevels(image, &image.data[0], linear);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        texture.width = image.width;
+        texture.height = image.height;
+        texture.filePath = filePath;
+        return texture;
+    }
+
+    void ImageLoader::UploadLevels(const ProcessedImage& image,
+        const unsigned char* data, bool linear) {
+        GLint internalFormat = GL_RGBA8;
+        GLenum format = GL_RGBA;
+        GLenum type = GL_UNSIGNED_BYTE;
+        switch (image.format) {
+            case PixelFormat::RGB565:
+                // GL_RGB565 only came to desktop GL with ES2 compatibility
+                internalFormat = GLEW_VERSION_4_1 ||
+                    GLEW_ARB_ES2_compatibility ? GL_RGB565 : GL_RGB5;
+                format = GL_RGB;
+                type = GL_UNSIGNED_SHORT_5_6_5;
+                break;
+            case PixelFormat::RGBA4444:
+                internalFormat = GL_RGBA4;
+                type = GL_UNSIGNED_SHORT_4_4_4_4;
+                break;
+            case PixelFormat::R8: {
+                internalFormat = GL_R8;
+                format = GL_RED;
+
+                // Read back as white with alpha, or as gray
+                GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+                if (image.isAlphaMask) {
+                    GLint color = image.isPremultiplied ? GL_RED : GL_ONE;
+                    swizzle[0] = swizzle[1] = swizzle[2] = color;
+                    swizzle[3] = GL_RED;
+                }
+                glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA,
+                    swizzle);
+                break;
+            }
+            case PixelFormat::BC1:
+                internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+                break;
+            case PixelFormat::BC3:
+                internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                break;
+            default:
+                break;
+        }
+
+        // Rows of 1 and 2 byte texels are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        int levelWidth = image.width;
+        int levelHeight = image.height;
+        for (int level = 0; level < image.numMips; level++) {
+            // Null data means offsets into the bound unpack buffer
+            const unsigned char* levelData = reinterpret_cast<
+                const unsigned char*>(reinterpret_cast<uintptr_t>(data) +
+                image.levelOffsets[level]);
+            if (ImageProcessor::IsBlockCompressed(image.format)) {
+                GLsizei levelSize = static_cast<GLsizei>(
+                    ImageProcessor::GetLevelSize(image.format, levelWidth,
+                    levelHeight));
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+                    levelWidth, levelHeight, 0, levelSize, levelData);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+                    levelWidth, levelHeight, 0, format, type, levelData);
+            }
+            levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+            levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        // The chain is either complete or left to the GPU, which can not
+        // build one for compressed textures
+        bool generateMipmaps = image.numMips <= 1 &&
+            !ImageProcessor::IsBlockCompressed(image.format);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+            generateMipmaps ? 1000 : image.numMips - 1);
+        FinishTexture(linear, generateMipmaps);
+    }
+
+    bool ImageLoader::HasBlockCompression() {
+        return GLEW_EXT_texture_compression_s3tc;
+    }
+
+    bool ImageLoader::HasTextureSwizzle() {
+        return GLEW_VERSION_3_3 || GLEW_ARB_texture_swizzle;
+    }
+
+    void ImageLoader::FinishTexture(bool linear, bool generateMipmaps) {
         // Set some texture parameters
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -67,16 +243,6 @@ namespace GangerEngine {
             GL_LINEAR_MIPMAP_LINEAR);
 
         // Generate the mipmaps
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // Unbind the texture
-        glBindTexture(GL_TEXTURE_2D, 0);
-
-        texture.width = static_cast<int>(width);
-        texture.height = static_cast<int>(height);
-        texture.filePath = filePath;
-
-        // Return a copy of the texture data
-        return texture;
+        if (generateMipmaps) glGenerateMipmap(GL_TEXTURE_2D);
     }
 }  // namespace GangerEngine
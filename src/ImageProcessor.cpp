@@ -0,0 +1,304 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/ImageProcessor.h>
+#include <GangerEngine/BlockCompressor.h>
+#include <GangerEngine/ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace GangerEngine {
+    // Work is split so each chunk handles about this many pixels
+    static const size_t PIXELS_PER_CHUNK = 16384;
+
+    // sRGB transfer function both ways. Linear values are looked up with
+    // 12 bits, less than a step of the 8 bit sRGB output.
+    struct GammaTables {
+        GammaTables() {
+            for (int i = 0; i < 256; i++) {
+                float value = i / 255.0f;
+                toLinear[i] = value <= 0.04045f ? value / 12.92f :
+                    powf((value + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < 4096; i++) {
+                float value = i / 4095.0f;
+                value = value <= 0.0031308f ? value * 12.92f :
+                    1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+                toSRGB[i] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+            }
+        }
+
+        float toLinear[256];
+        unsigned char toSRGB[4096];
+    };
+
+    static const GammaTables& GetGammaTables() {
+        static const GammaTables tables;
+        return tables;
+    }
+
+    static void DownsampleRows(const unsigned char* src, int srcWidth,
+        int srcHeight, unsigned char* dst, int dstWidth, size_t beginRow,
+        size_t endRow, bool isSRGB) {
+        const GammaTables& tables = GetGammaTables();
+
+        for (size_t y = beginRow; y < endRow; y++) {
+            // Odd sizes drop their last row or column, a side of 1 repeats
+            int y0 = std::min(static_cast<int>(y) * 2, srcHeight - 1);
+            int y1 = std::min(static_cast<int>(y) * 2 + 1, srcHeight - 1);
+            unsigned char* out = dst + y * dstWidth * 4;
+
+            for (int x = 0; x < dstWidth; x++, out += 4) {
+                int x0 = std::min(x * 2, srcWidth - 1);
+                int x1 = std::min(x * 2 + 1, srcWidth - 1);
+                const unsigned char* texels[4] = {
+                    src + (static_cast<size_t>(y0) * srcWidth + x0) * 4,
+                    src + (static_cast<size_t>(y0) * srcWidth + x1) * 4,
+                    src + (static_cast<size_t>(y1) * srcWidth + x0) * 4,
+                    src + (static_cast<size_t>(y1) * srcWidth + x1) * 4 };
+
+                float weighted[3] = {};
+                float plain[3] = {};
+                int alphaSum = 0;
+                for (int t = 0; t < 4; t++) {
+                    int alpha = texels[t][3];
+                    alphaSum += alpha;
+                    for (int c = 0; c < 3; c++) {
+                        float value = isSRGB ? tables.toLinear[texels[t][c]] :
+                            texels[t][c] / 255.0f;
+                        weighted[c] += value * alpha;
+                        plain[c] += value;
+                    }
+                }
+
+                for (int c = 0; c < 3; c++) {
+                    // Fully transparent blocks still keep a sensible color
+                    float value = alphaSum > 0 ? weighted[c] / alphaSum :
+                        plain[c] * 0.25f;
+                    if (isSRGB) {
+                        out[c] = tables.toSRGB[
+                            static_cast<int>(value * 4095.0f + 0.5f)];
+                    } else {
+                        out[c] = static_cast<unsigned char>(
+                            value * 255.0f + 0.5f);
+                    }
+                }
+                out[3] = static_cast<unsigned char>((alphaSum + 2) / 4);
+            }
+        }
+    }
+
+    static void ForEachChunk(ThreadPool* workers, size_t count,
+        size_t grain, const std::function<void(size_t, size_t)>& function) {
+        if (workers != nullptr) {
+            workers->ParallelFor(count, grain, function);
+        } else {
+            function(0, count);
+        }
+    }
+
+    void ImageProcessor::Process(const unsigned char* pixels, int width,
+        int height, const ImageOptions& options, ProcessedImage* image,
+        ThreadPool* workers) {
+        size_t numPixels = static_cast<size_t>(width) * height;
+        image->width = width;
+        image->height = height;
+        image->format = ChooseFormat(pixels, numPixels, options,
+            &image->isAlphaMask);
+        image->isPremultiplied = options.premultiplyAlpha;
+
+        std::vector<unsigned char> levels(pixels, pixels + numPixels * 4);
+        image->numMips = options.generateMips ?
+            BuildMipChain(levels, width, height, options.isSRGB, workers) : 1;
+
+        // R8 masks get their premultiplication from the swizzle
+        if (options.premultiplyAlpha && image->format != PixelFormat::R8) {
+            ForEachChunk(workers, levels.size() / 4, PIXELS_PER_CHUNK,
+                [&levels](size_t begin, size_t end) {
+                PremultiplyAlpha(&levels[begin * 4], end - begin);
+            });
+        }
+
+        image->levelOffsets.clear();
+        size_t pixelSize = GetPixelSize(image->format);
+        size_t offset = 0;
+        int levelWidth = width;
+        int levelHeight = height;
+        for (int level = 0; level < image->numMips; level++) {
+            image->levelOffsets.push_back(offset);
+            offset += GetLevelSize(image->format, levelWidth, levelHeight);
+            levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+            levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+        }
+
+        if (image->format == PixelFormat::RGBA8) {
+            image->data = std::move(levels);
+            return;
+        }
+
+        image->data.resize(offset);
+        PixelFormat format = image->format;
+        bool isAlphaMask = image->isAlphaMask;
+        ForEachChunk(workers, levels.size() / 4, PIXELS_PER_CHUNK,
+            [&levels, image, format, isAlphaMask, pixelSize](size_t begin,
+                size_t end) {
+            Convert(&levels[begin * 4], end - begin, format, isAlphaMask,
+                &image->data[begin * pixelSize]);
+        });
+    }
+
+    int ImageProcessor::BuildMipChain(std::vector<unsigned char>& levels,
+        int width, int height, bool isSRGB, ThreadPool* workers) {
+        // Every level is known up front, so the rows never move
+        size_t totalSize = 0;
+        int numMips = 0;
+        for (int w = width, h = height;; w = std::max(w / 2, 1),
+            h = std::max(h / 2, 1)) {
+            totalSize += static_cast<size_t>(w) * h * 4;
+            numMips++;
+            if (w == 1 && h == 1) break;
+        }
+        levels.resize(totalSize);
+
+        size_t srcOffset = 0;
+        while (width > 1 || height > 1) {
+            int nextWidth = width > 1 ? width / 2 : 1;
+            int nextHeight = height > 1 ? height / 2 : 1;
+            size_t dstOffset = srcOffset +
+                static_cast<size_t>(width) * height * 4;
+
+            const unsigned char* src = &levels[srcOffset];
+            unsigned char* dst = &levels[dstOffset];
+            size_t grain = std::max<size_t>(PIXELS_PER_CHUNK / nextWidth, 1);
+            ForEachChunk(workers, nextHeight, grain,
+                [=](size_t begin, size_t end) {
+                DownsampleRows(src, width, height, dst, nextWidth, begin, end,
+                    isSRGB);
+            });
+
+            srcOffset = dstOffset;
+            width = nextWidth;
+            height = nextHeight;
+        }
+        return numMips;
+    }
+
+    void ImageProcessor::PremultiplyAlpha(unsigned char* pixels,
+        size_t numPixels) {
+        for (size_t i = 0; i < numPixels; i++, pixels += 4) {
+            int alpha = pixels[3];
+            for (int c = 0; c < 3; c++) {
+                pixels[c] = static_cast<unsigned char>(
+                    (pixels[c] * alpha + 127) / 255);
+            }
+        }
+    }
+
+    PixelFormat ImageProcessor::ChooseFormat(const unsigned char* pixels,
+        size_t numPixels, const ImageOptions& options, bool* isAlphaMask) {
+        *isAlphaMask = false;
+
+        bool isOpaque = true;
+        bool isGray = options.useMaskFormat;
+        bool isWhite = options.useMaskFormat;
+        for (size_t i = 0; i < numPixels; i++, pixels += 4) {
+            bool isPixelGray = pixels[0] == pixels[1] &&
+                pixels[1] == pixels[2];
+            isOpaque = isOpaque && pixels[3] == 255;
+            isGray = isGray && isPixelGray && pixels[3] == 255;
+            isWhite = isWhite && isPixelGray && pixels[0] == 255;
+            // Nothing left to learn
+            if (!isGray && !isWhite &&
+                (!isOpaque || !options.allowLossyFormats)) {
+                break;
+            }
+        }
+
+        if (isGray) return PixelFormat::R8;
+        if (isWhite) {
+            *isAlphaMask = true;
+            return PixelFormat::R8;
+        }
+        if (options.allowLossyFormats) {
+            return isOpaque ? PixelFormat::RGB565 : PixelFormat::RGBA4444;
+        }
+        return PixelFormat::RGBA8;
+    }
+
+    size_t ImageProcessor::GetPixelSize(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::RGB565:
+            case PixelFormat::RGBA4444:
+                return 2;
+            case PixelFormat::R8:
+                return 1;
+            case PixelFormat::BC1:
+            case PixelFormat::BC3:
+                return 0;
+            default:
+                return 4;
+        }
+    }
+
+    size_t ImageProcessor::GetLevelSize(PixelFormat format, int width,
+        int height) {
+        if (IsBlockCompressed(format)) {
+            return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) *
+                BlockCompressor::GetBlockSize(format);
+        }
+        return static_cast<size_t>(width) * height * GetPixelSize(format);
+    }
+
+    void ImageProcessor::Convert(const unsigned char* pixels,
+        size_t numPixels, PixelFormat format, bool isAlphaMask,
+        unsigned char* out) {
+        switch (format) {
+            case PixelFormat::RGB565:
+                for (size_t i = 0; i < numPixels; i++, pixels += 4) {
+                    uint16_t texel = static_cast<uint16_t>(
+                        ((pixels[0] * 31 + 127) / 255) << 11 |
+                        ((pixels[1] * 63 + 127) / 255) << 5 |
+                        ((pixels[2] * 31 + 127) / 255));
+                    memcpy(out + i * 2, &texel, 2);
+                }
+                break;
+            case PixelFormat::RGBA4444:
+                for (size_t i = 0; i < numPixels; i++, pixels += 4) {
+                    uint16_t texel = static_cast<uint16_t>(
+                        ((pixels[0] * 15 + 127) / 255) << 12 |
+                        ((pixels[1] * 15 + 127) / 255) << 8 |
+                        ((pixels[2] * 15 + 127) / 255) << 4 |
+                        ((pixels[3] * 15 + 127) / 255));
+                    memcpy(out + i * 2, &texel, 2);
+                }
+                break;
+            case PixelFormat::R8: {
+                int channel = isAlphaMask ? 3 : 0;
+                for (size_t i = 0; i < numPixels; i++) {
+                    out[i] = pixels[i * 4 + channel];
+                }
+                break;
+            }
+            default:
+                memcpy(out, pixels, numPixels * 4);
+                break;
+        }
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,232 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/MappedFile.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GangerEngine {
+    MappedFile::MappedFile() {
+        // Empty
+    }
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) {
+        if (this == &other) return *this;
+
+        Close();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_buffer = std::move(other.m_buffer);
+        m_isOpen = other.m_isOpen;
+        m_isMapped = other.m_isMapped;
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_isOpen = false;
+        other.m_isMapped = false;
+        return *this;
+    }
+
+    bool MappedFile::Open(const std::string& filePath, bool allowMapping) {
+        Close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ,
+            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            printf("Could not open %s\n", filePath.c_str());
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) ||
+            static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX) {
+            printf("Could not get the size of %s\n", filePath.c_str());
+            CloseHandle(file);
+            return false;
+        }
+        size_t size = static_cast<size_t>(fileSize.QuadPart);
+
+        if (allowMapping && size >= MAP_THRESHOLD) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY,
+                0, 0, nullptr);
+            if (mapping != nullptr) {
+                // The view keeps the mapping and the file alive
+                void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+                if (data != nullptr) {
+                    CloseHandle(file);
+                    m_data = static_cast<const unsigned char*>(data);
+                    m_size = size;
+                    m_isOpen = true;
+                    m_isMapped = true;
+                    return true;
+                }
+            }
+        }
+
+        // Could not map, read it in chunks that fit a DWORD
+        std::unique_ptr<unsigned char[]> buffer(new unsigned char[size]);
+        size_t offset = 0;
+        while (offset < size) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - offset,
+                1u << 30));
+            DWORD numRead = 0;
+            if (!ReadFile(file, buffer.get() + offset, chunk, &numRead,
+                nullptr) || numRead == 0) {
+                printf("Could not read %s\n", filePath.c_str());
+                CloseHandle(file);
+                return false;
+            }
+            offset += numRead;
+        }
+        CloseHandle(file);
+#else
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            perror(filePath.c_str());
+            return false;
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size < 0 ||
+            static_cast<uint64_t>(fileStat.st_size) > SIZE_MAX) {
+            perror(filePath.c_str());
+            close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(fileStat.st_size);
+
+        if (allowMapping && size >= MAP_THRESHOLD &&
+            S_ISREG(fileStat.st_mode)) {
+            void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                // The mapping keeps the file alive
+                close(fd);
+                // Files are parsed front to back, read ahead aggressively
+                madvise(data, size, MADV_SEQUENTIAL);
+                m_data = static_cast<const unsigned char*>(data);
+                m_size = size;
+                m_isOpen = true;
+                m_isMapped = true;
+                return true;
+            }
+        }
+
+        // Pipes and procfs files do not know their size, read to the end
+        if (!S_ISREG(fileStat.st_mode) || size == 0) {
+            bool isRead = ReadToEnd(fd, filePath);
+            close(fd);
+            return isRead;
+        }
+
+        // Could not map, read() returns at most about 2GB per call
+        std::unique_ptr<unsigned char[]> buffer(new unsigned char[size]);
+        size_t offset = 0;
+        while (offset < size) {
+            ssize_t numRead = read(fd, buffer.get() + offset, size - offset);
+            if (numRead < 0 && errno == EINTR) continue;
+            if (numRead <= 0) {
+                perror(filePath.c_str());
+                close(fd);
+                return false;
+            }
+            offset += static_cast<size_t>(numRead);
+        }
+        close(fd);
+#endif
+        SetBuffer(std::move(buffer), size);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_isMapped) {
+#ifdef _WIN32
+            UnmapViewOfFile(m_data);
+#else
+            munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+        }
+        m_buffer.reset();
+        m_data = nullptr;
+        m_size = 0;
+        m_isOpen = false;
+        m_isMapped = false;
+    }
+
+#ifndef _WIN32
+    bool MappedFile::ReadToEnd(int fd, const std::string& filePath) {
+        std::vector<unsigned char> data;
+        unsigned char chunk[4096];
+        for (;;) {
+            ssize_t numRead = read(fd, chunk, sizeof(chunk));
+            if (numRead < 0 && errno == EINTR) continue;
+            if (numRead < 0) {
+                perror(filePath.c_str());
+                return false;
+            }
+            if (numRead == 0) break;
+            data.insert(data.end(), chunk, chunk + numRead);
+        }
+
+        std::unique_ptr<unsigned char[]> buffer(
+            new unsigned char[data.size()]);
+        std::copy(data.begin(), data.end(), buffer.get());
+        SetBuffer(std::move(buffer), data.size());
+        return true;
+    }
+#endif
+
+    void MappedFile::SetView(const unsigned char* data, size_t size) {
+        Close();
+        m_data = size > 0 ? data : nullptr;
+        m_size = size;
+        m_isOpen = true;
+    }
+
+    void MappedFile::SetBuffer(std::unique_ptr<unsigned char[]> buffer,
+        size_t size) {
+        Close();
+        m_buffer = std::move(buffer);
+        m_data = size > 0 ? m_buffer.get() : nullptr;
+        m_size = size;
+        m_isOpen = true;
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,354 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/Mixer.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GANGER_MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace GangerEngine {
+    static const size_t COMMAND_CAPACITY = 1024;
+
+    // Adds samples times a gain ramping by a step every frame, from the
+    // frame first on
+    static void MixScalar(float* out, const int16_t* in, int first,
+        int numFrames, float left, float right, float leftStep,
+        float rightStep) {
+        for (int i = first; i < numFrames; i++) {
+            out[2 * i] += in[2 * i] * (left + i * leftStep);
+            out[2 * i + 1] += in[2 * i + 1] * (right + i * rightStep);
+        }
+    }
+
+    static void ResolveScalar(int16_t* stream, const float* mix, int count) {
+        for (int i = 0; i < count; i++) {
+            float value = stream[i] + mix[i];
+            value = std::min(std::max(value, -32768.0f), 32767.0f);
+            // Rounded to nearest, like the SIMD conversion
+            stream[i] = static_cast<int16_t>(std::lrint(value));
+        }
+    }
+
+#ifdef GANGER_MIXER_SSE2
+    static void MixSSE2(float* out, const int16_t* in, int first,
+        int numFrames, float left, float right, float leftStep,
+        float rightStep) {
+        // Four frames a step, the gains worked out as the scalar ones
+        const __m128 gain = _mm_setr_ps(left, right, left, right);
+        const __m128 step = _mm_setr_ps(leftStep, rightStep, leftStep,
+            rightStep);
+        __m128 index0 = _mm_setr_ps(first, first, first + 1, first + 1);
+        __m128 index1 = _mm_add_ps(index0, _mm_set1_ps(2.0f));
+        const __m128 four = _mm_set1_ps(4.0f);
+
+        int i = first;
+        for (; i + 4 <= numFrames; i += 4) {
+            __m128i samples = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(in + 2 * i));
+            // Sign extends by putting the sample in the high half
+            __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(
+                _mm_unpacklo_epi16(samples, samples), 16));
+            __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(
+                _mm_unpackhi_epi16(samples, samples), 16));
+            __m128 gain0 = _mm_add_ps(gain, _mm_mul_ps(index0, step));
+            __m128 gain1 = _mm_add_ps(gain, _mm_mul_ps(index1, step));
+
+            float* dst = out + 2 * i;
+            _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst),
+                _mm_mul_ps(low, gain0)));
+            _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4),
+                _mm_mul_ps(high, gain1)));
+            index0 = _mm_add_ps(index0, four);
+            index1 = _mm_add_ps(index1, four);
+        }
+
+        MixScalar(out, in, i, numFrames, left, right, leftStep, rightStep);
+    }
+
+    static void ResolveSSE2(int16_t* stream, const float* mix, int count) {
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i samples = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(stream + i));
+            __m128 low = _mm_add_ps(_mm_loadu_ps(mix + i), _mm_cvtepi32_ps(
+                _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)));
+            __m128 high = _mm_add_ps(_mm_loadu_ps(mix + i + 4),
+                _mm_cvtepi32_ps(_mm_srai_epi32(
+                _mm_unpackhi_epi16(samples, samples), 16)));
+            // The pack saturates to 16 bits
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(stream + i),
+                _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+        }
+        ResolveScalar(stream + i, mix + i, count - i);
+    }
+#endif
+
+    Mixer::Mixer() {
+        // Empty
+    }
+
+    Mixer::~Mixer() {
+        // Empty
+    }
+
+    void Mixer::Init(int numVoices, int blockFrames /* = 1024 */) {
+        m_voices.assign(numVoices, Voice());
+        m_buffer.assign(2 * std::max(blockFrames, 4), 0.0f);
+        m_commands.Resize(COMMAND_CAPACITY);
+        // Every voice can end once per play command still queued, so the
+        // events never overflow
+        m_finished.Resize(numVoices + COMMAND_CAPACITY);
+        m_numActive = 0;
+    }
+
+    bool Mixer::Play(int voice, uint32_t serial, const int16_t* samples,
+        uint32_t numFrames, int loops, float gain, float pan /* = 0.0f */) {
+        Command command = Command();
+        command.type = CommandType::PLAY;
+        command.voice = voice;
+        command.serial = serial;
+        command.samples = samples;
+        command.numFrames = numFrames;
+        command.loops = loops;
+        command.gain = gain;
+        command.pan = pan;
+        return PushCommand(command);
+    }
+
+    bool Mixer::PlayAt(int voice, uint32_t serial, const int16_t* samples,
+        uint32_t numFrames, int loops, float gain,
+        const glm::vec2& position) {
+        Command command = Command();
+        command.type = CommandType::PLAY;
+        command.voice = voice;
+        command.serial = serial;
+        command.samples = samples;
+        command.numFrames = numFrames;
+        command.loops = loops;
+        command.gain = gain;
+        command.isPositional = true;
+        command.position = position;
+        return PushCommand(command);
+    }
+
+    bool Mixer::Stop(int voice) {
+        Command command = Command();
+        command.type = CommandType::STOP;
+        command.voice = voice;
+        return PushCommand(command);
+    }
+
+    bool Mixer::SetGain(int voice, float gain) {
+        Command command = Command();
+        command.type = CommandType::SET_GAIN;
+        command.voice = voice;
+        command.gain = gain;
+        return PushCommand(command);
+    }
+
+    bool Mixer::SetListener(const glm::vec2& position, float minDistance,
+        float maxDistance) {
+        Command command = Command();
+        command.type = CommandType::SET_LISTENER;
+        command.position = position;
+        command.minDistance = minDistance;
+        command.maxDistance = maxDistance;
+        return PushCommand(command);
+    }
+
+    bool Mixer::PopFinished(int* voice, uint32_t* serial) {
+        Finished finished;
+        if (!m_finished.Pop(&finished)) return false;
+        *voice = finished.voice;
+        *serial = finished.serial;
+        return true;
+    }
+
+    void Mixer::Drop(const int16_t* samples) {
+        // A play queued for them may still be waiting, or a stop dropped
+        ProcessCommands();
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            Voice& voice = m_voices[i];
+            if (voice.samples != nullptr && voice.samples == samples) {
+                voice.samples = nullptr;
+                m_numActive--;
+                Finished finished = {static_cast<int>(i), voice.serial};
+                m_finished.Push(finished);
+            }
+        }
+    }
+
+    MixerStats Mixer::GetStats() const {
+        MixerStats stats;
+        stats.numActive = m_numActive;
+        stats.numFramesMixed = m_numFramesMixed;
+        stats.numVoiceFramesMixed = m_numVoiceFramesMixed;
+        stats.numCommandsDropped = m_numCommandsDropped;
+        return stats;
+    }
+
+    void Mixer::Mix(int16_t* stream, int numFrames) {
+        ProcessCommands();
+
+        int blockFrames = static_cast<int>(m_buffer.size() / 2);
+        for (int done = 0; done < numFrames; done += blockFrames) {
+            int count = std::min(blockFrames, numFrames - done);
+            MixBlock(count);
+#ifdef GANGER_MIXER_SSE2
+            if (m_isSIMDEnabled) {
+                ResolveSSE2(stream + 2 * done, m_buffer.data(), 2 * count);
+                continue;
+            }
+#endif
+            ResolveScalar(stream + 2 * done, m_buffer.data(), 2 * count);
+        }
+        m_numFramesMixed += numFrames;
+    }
+
+    float Mixer::GetAttenuation(float distance, float minDistance,
+        float maxDistance) {
+        if (distance <= minDistance) return 1.0f;
+        if (distance >= maxDistance) return 0.0f;
+        // Falls off with the inverse of the distance, faded out to reach
+        // zero at the max distance
+        return minDistance / distance *
+            (maxDistance - distance) / (maxDistance - minDistance);
+    }
+
+    float Mixer::GetPan(const glm::vec2& offset, float minDistance) {
+        // The sine of the angle to the source, damped when it is close
+        float distance = std::max(glm::length(offset), minDistance);
+        if (distance <= 0.0f) return 0.0f;
+        return std::min(std::max(offset.x / distance, -1.0f), 1.0f);
+    }
+
+    bool Mixer::PushCommand(const Command& command) {
+        if (m_commands.Push(command)) return true;
+        m_numCommandsDropped++;
+        return false;
+    }
+
+    void Mixer::ProcessCommands() {
+        Command command;
+        while (m_commands.Pop(&command)) {
+            if (command.type == CommandType::SET_LISTENER) {
+                m_listener = command.position;
+                m_minDistance = command.minDistance;
+                m_maxDistance = command.maxDistance;
+                continue;
+            }
+
+            Voice& voice = m_voices[command.voice];
+            switch (command.type) {
+                case CommandType::PLAY:
+                    if (voice.samples == nullptr) m_numActive++;
+                    voice.samples = command.samples;
+                    voice.numFrames = command.numFrames;
+                    voice.cursor = 0;
+                    voice.loops = command.loops;
+                    voice.serial = command.serial;
+                    voice.gain = command.gain;
+                    voice.pan = command.pan;
+                    voice.isPositional = command.isPositional;
+                    voice.position = command.position;
+                    // Starts at its gains, the sound has its own attack
+                    GetGains(voice, &voice.left, &voice.right);
+                    break;
+                case CommandType::STOP:
+                    if (voice.samples != nullptr) m_numActive--;
+                    voice.samples = nullptr;
+                    break;
+                case CommandType::SET_GAIN:
+                    voice.gain = command.gain;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void Mixer::MixBlock(int numFrames) {
+        float* out = m_buffer.data();
+        std::fill(out, out + 2 * numFrames, 0.0f);
+
+        auto mix = MixScalar;
+#ifdef GANGER_MIXER_SSE2
+        if (m_isSIMDEnabled) mix = MixSSE2;
+#endif
+
+        uint64_t numVoiceFrames = 0;
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            Voice& voice = m_voices[i];
+            if (voice.samples == nullptr) continue;
+
+            float left, right;
+            GetGains(voice, &left, &right);
+            float leftStep = (left - voice.left) / numFrames;
+            float rightStep = (right - voice.right) / numFrames;
+
+            int done = 0;
+            while (done < numFrames && voice.samples != nullptr) {
+                int count = static_cast<int>(std::min<uint32_t>(
+                    numFrames - done, voice.numFrames - voice.cursor));
+                // Silent voices only move their cursor
+                if (count > 0 && (left != 0.0f || right != 0.0f ||
+                    voice.left != 0.0f || voice.right != 0.0f)) {
+                    mix(out + 2 * done, voice.samples + 2 * voice.cursor, 0,
+                        count, voice.left + done * leftStep,
+                        voice.right + done * rightStep, leftStep, rightStep);
+                    numVoiceFrames += count;
+                }
+                voice.cursor += count;
+                done += count;
+
+                if (voice.cursor < voice.numFrames) continue;
+                if (voice.loops != 0 && voice.numFrames > 0) {
+                    if (voice.loops > 0) voice.loops--;
+                    voice.cursor = 0;
+                } else {
+                    voice.samples = nullptr;
+                    m_numActive--;
+                    Finished finished = {static_cast<int>(i), voice.serial};
+                    m_finished.Push(finished);
+                }
+            }
+            voice.left = left;
+            voice.right = right;
+        }
+        m_numVoiceFramesMixed += numVoiceFrames;
+    }
+
+    void Mixer::GetGains(const Voice& voice, float* left,
+        float* right) const {
+        float gain = voice.gain;
+        float pan = voice.pan;
+        if (voice.isPositional) {
+            glm::vec2 offset = voice.position - m_listener;
+            gain *= GetAttenuation(glm::length(offset), m_minDistance,
+                m_maxDistance);
+            pan = GetPan(offset, m_minDistance);
+        }
+        // Balance, a centered voice keeps its full gain on both sides
+        *left = gain * std::min(1.0f, 1.0f - pan);
+        *right = gain * std::min(1.0f, 1.0f + pan);
+    }
+}  // namespace GangerEngine
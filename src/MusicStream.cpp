@@ -0,0 +1,486 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/MusicStream.h>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace GangerEngine {
+    // The frames decoded at once
+    static const uint32_t DECODE_FRAMES = 4096;
+
+    // A source of 16 bit stereo frames at the output rate
+    class MusicDecoder {
+     public:
+        virtual ~MusicDecoder() {}
+
+        /// Returns the frames read, 0 at the end.
+        virtual uint32_t Read(int16_t* frames, uint32_t numFrames) = 0;
+        virtual void Seek(uint64_t frame) = 0;
+
+        uint64_t GetNumFrames() const { return m_numFrames; }
+
+     protected:
+        uint64_t m_numFrames = 0;
+    };
+
+    static uint32_t ReadLE(const unsigned char* bytes, int size) {
+        uint32_t value = 0;
+        for (int i = size - 1; i >= 0; i--) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    // Streams 8 or 16 bit pcm wav files from a view of the file, resampled
+    // to the output rate
+    class WavDecoder : public MusicDecoder {
+     public:
+        /// Takes the file if it is a wav it can stream.
+        bool Open(MappedFile* file, int sampleRate) {
+            const unsigned char* data = file->GetData();
+            size_t size = file->GetSize();
+            if (size < 12 || memcmp(data, "RIFF", 4) != 0 ||
+                memcmp(data + 8, "WAVE", 4) != 0) {
+                return false;
+            }
+
+            const unsigned char* samples = nullptr;
+            size_t samplesSize = 0;
+            int sourceRate = 0;
+            for (size_t offset = 12; offset + 8 <= size;) {
+                const unsigned char* chunk = data + offset;
+                size_t chunkSize = std::min<size_t>(ReadLE(chunk + 4, 4),
+                    size - offset - 8);
+                if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+                    uint32_t format = ReadLE(chunk + 8, 2);
+                    // WAVE_FORMAT_EXTENSIBLE keeps the real one further on
+                    if (format == 0xfffe && chunkSize >= 26) {
+                        format = ReadLE(chunk + 32, 2);
+                    }
+                    if (format != 1) return false;
+                    m_numChannels = static_cast<int>(ReadLE(chunk + 10, 2));
+                    sourceRate = static_cast<int>(ReadLE(chunk + 12, 4));
+                    m_numBits = static_cast<int>(ReadLE(chunk + 22, 2));
+                } else if (memcmp(chunk, "data", 4) == 0) {
+                    samples = chunk + 8;
+                    samplesSize = chunkSize;
+                }
+                // Chunks are padded to an even size
+                offset += 8 + chunkSize + (chunkSize & 1);
+            }
+
+            if (samples == nullptr || sourceRate <= 0 ||
+                (m_numChannels != 1 && m_numChannels != 2) ||
+                (m_numBits != 8 && m_numBits != 16)) {
+                return false;
+            }
+
+            m_samples = samples;
+            m_numSourceFrames = samplesSize / (m_numChannels * m_numBits / 8);
+            m_step = static_cast<double>(sourceRate) / sampleRate;
+            m_numFrames = static_cast<uint64_t>(m_numSourceFrames / m_step);
+            m_file = std::move(*file);
+            return true;
+        }
+
+        uint32_t Read(int16_t* frames, uint32_t numFrames) override {
+            numFrames = static_cast<uint32_t>(std::min<uint64_t>(numFrames,
+                m_numFrames - std::min(m_position, m_numFrames)));
+            for (uint32_t i = 0; i < numFrames; i++) {
+                double position = (m_position + i) * m_step;
+                uint64_t first = static_cast<uint64_t>(position);
+                uint64_t second = std::min(first + 1, m_numSourceFrames - 1);
+                float t = static_cast<float>(position - first);
+                for (int channel = 0; channel < 2; channel++) {
+                    float a = GetSample(first, channel);
+                    float b = GetSample(second, channel);
+                    frames[2 * i + channel] =
+                        static_cast<int16_t>(a + (b - a) * t);
+                }
+            }
+            m_position += numFrames;
+            return numFrames;
+        }
+
+        void Seek(uint64_t frame) override {
+            m_position = frame;
+        }
+
+     private:
+        int GetSample(uint64_t frame, int channel) const {
+            if (m_numChannels == 1) channel = 0;
+            size_t index = frame * m_numChannels + channel;
+            if (m_numBits == 8) return (m_samples[index] - 128) << 8;
+            return static_cast<int16_t>(ReadLE(m_samples + 2 * index, 2));
+        }
+
+        MappedFile m_file;
+        const unsigned char* m_samples = nullptr;
+        uint64_t m_numSourceFrames = 0;
+        int m_numChannels = 0;
+        int m_numBits = 0;
+        double m_step = 1.0;  ///< Source frames per output frame
+        uint64_t m_position = 0;
+    };
+
+    // Plays a song SDL_mixer decoded whole into the output format, shared
+    // with the stream cache so it is decoded once
+    class ChunkDecoder : public MusicDecoder {
+     public:
+        explicit ChunkDecoder(const std::shared_ptr<Mix_Chunk>& chunk) :
+            m_chunk(chunk) {
+            m_numFrames = m_chunk->alen / 4;
+        }
+
+        uint32_t Read(int16_t* frames, uint32_t numFrames) override {
+            numFrames = static_cast<uint32_t>(std::min<uint64_t>(numFrames,
+                m_numFrames - std::min(m_position, m_numFrames)));
+            memcpy(frames, m_chunk->abuf + 4 * m_position, 4 * numFrames);
+            m_position += numFrames;
+            return numFrames;
+        }
+
+        void Seek(uint64_t frame) override {
+            m_position = frame;
+        }
+
+     private:
+        std::shared_ptr<Mix_Chunk> m_chunk;
+        uint64_t m_position = 0;
+    };
+
+    // Streams the song if it is a wav it can, nullptr otherwise
+    static std::unique_ptr<MusicDecoder> OpenWavDecoder(
+        const std::string& filePath, int sampleRate) {
+        MappedFile file;
+        if (!IOManager::MapFile(filePath, &file)) return nullptr;
+
+        WavDecoder* wav = new WavDecoder();
+        std::unique_ptr<MusicDecoder> decoder(wav);
+        if (!wav->Open(&file, sampleRate)) return nullptr;
+        return decoder;
+    }
+
+    static std::shared_ptr<Mix_Chunk> DecodeChunk(
+        const std::string& filePath) {
+        MappedFile file;
+        if (!IOManager::MapFile(filePath, &file)) {
+            printf("Failed to open music %s\n", filePath.c_str());
+            return nullptr;
+        }
+
+        Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(file.GetData(),
+            static_cast<int>(file.GetSize())), 1);
+        if (chunk == nullptr) {
+            printf("Failed to decode music %s: %s\n", filePath.c_str(),
+                Mix_GetError());
+            return nullptr;
+        }
+        return std::shared_ptr<Mix_Chunk>(chunk, Mix_FreeChunk);
+    }
+
+    static bool IsReady(
+        const std::shared_future<std::shared_ptr<Mix_Chunk> >& chunk) {
+        return chunk.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready;
+    }
+
+    /// The bytes of a decoded song, 0 while decoding or if it failed.
+    static size_t GetChunkBytes(
+        const std::shared_future<std::shared_ptr<Mix_Chunk> >& chunk) {
+        if (!IsReady(chunk) || chunk.get() == nullptr) return 0;
+        return chunk.get()->alen;
+    }
+
+    MusicStream::MusicStream() {
+        // Empty
+    }
+
+    MusicStream::~MusicStream() {
+        Stop();
+    }
+
+    void MusicStream::Init(int sampleRate, int bufferFrames) {
+        m_sampleRate = sampleRate;
+        m_bufferFrames = bufferFrames;
+    }
+
+    void MusicStream::SetBufferFrames(int bufferFrames) {
+        m_bufferFrames = bufferFrames;
+    }
+
+    void MusicStream::Play(const std::string& filePath, int loops,
+        double loopStart /* = 0.0 */, double loopEnd /* = 0.0 */) {
+        Stop();
+
+        size_t numFrames = 2 * DECODE_FRAMES;
+        while (numFrames < static_cast<size_t>(m_bufferFrames)) {
+            numFrames *= 2;
+        }
+        m_ring.assign(2 * numFrames, 0);
+        m_ringMask = numFrames - 1;
+        m_readFrame = 0;
+        m_writeFrame = 0;
+        m_isPrimed = false;
+        m_isDecoded = false;
+        m_isPaused = false;
+        m_isStopping = false;
+
+        // The callback starts reading once the decoder primed the buffer
+        m_isActive = true;
+        m_decoderThread = std::thread(&MusicStream::Decode, this, filePath,
+            loops, loopStart, loopEnd);
+    }
+
+    void MusicStream::Preload(const std::string& filePath) {
+        if (OpenWavDecoder(filePath, m_sampleRate) != nullptr) return;
+        LoadChunk(filePath);
+    }
+
+    void MusicStream::ClearCache() {
+        // Dropping a decode still running would wait for it, a song playing
+        // keeps its chunk until it stops
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+            if (IsReady(it->second.chunk)) {
+                it = m_chunks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void MusicStream::SetCacheBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        m_cacheBudget = bytes;
+        TrimCache();
+    }
+
+    void MusicStream::Pause() {
+        m_isPaused = true;
+    }
+
+    void MusicStream::Resume() {
+        m_isPaused = false;
+    }
+
+    void MusicStream::Stop() {
+        // Once the lock is held the callback is not running, and it sees
+        // the stream inactive from then on
+        SDL_LockAudio();
+        m_isActive = false;
+        SDL_UnlockAudio();
+
+        if (m_decoderThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_isStopping = true;
+            }
+            m_stopCondition.notify_all();
+            m_decoderThread.join();
+        }
+    }
+
+    bool MusicStream::IsPlaying() const {
+        if (!m_isActive) return false;
+        return !m_isDecoded || m_readFrame != m_writeFrame;
+    }
+
+    MusicStreamStats MusicStream::GetStats() const {
+        MusicStreamStats stats;
+        stats.bufferFrames = static_cast<int>(m_ring.size() / 2);
+        stats.bufferedFrames = static_cast<int>(m_writeFrame - m_readFrame);
+        stats.numFramesDecoded = m_numFramesDecoded;
+        stats.numUnderruns = m_numUnderruns;
+
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        for (auto& it : m_chunks) {
+            stats.cacheBytes += GetChunkBytes(it.second.chunk);
+        }
+        return stats;
+    }
+
+    void MusicStream::Mix(int16_t* stream, int numFrames) {
+        if (!m_isActive || !m_isPrimed || m_isPaused) return;
+
+        uint64_t readFrame = m_readFrame.load(std::memory_order_relaxed);
+        uint64_t available =
+            m_writeFrame.load(std::memory_order_acquire) - readFrame;
+        int count = static_cast<int>(std::min<uint64_t>(available,
+            numFrames));
+        float volume = m_volume;
+
+        for (int i = 0; i < count; i++) {
+            const int16_t* frame =
+                &m_ring[2 * ((readFrame + i) & m_ringMask)];
+            for (int channel = 0; channel < 2; channel++) {
+                float value = stream[2 * i + channel] + frame[channel] * volume;
+                value = std::min(std::max(value, -32768.0f), 32767.0f);
+                stream[2 * i + channel] = static_cast<int16_t>(value);
+            }
+        }
+        m_readFrame.store(readFrame + count, std::memory_order_release);
+
+        if (count < numFrames && !m_isDecoded) m_numUnderruns++;
+    }
+
+    void MusicStream::Decode(std::string filePath, int loops,
+        double loopStart, double loopEnd) {
+        std::unique_ptr<MusicDecoder> decoder = OpenWavDecoder(filePath,
+            m_sampleRate);
+        if (decoder == nullptr) {
+            // No streaming decoder for it, SDL_mixer decodes it whole once
+            // and the next plays start right away
+            ChunkFuture future = LoadChunk(filePath);
+            if (!WaitForChunk(future)) return;
+            std::shared_ptr<Mix_Chunk> chunk = future.get();
+            std::lock_guard<std::mutex> lock(m_chunkMutex);
+            if (chunk != nullptr) {
+                decoder.reset(new ChunkDecoder(chunk));
+                TrimCache();
+            } else {
+                // Tried again the next time, a mount may bring it
+                m_chunks.erase(filePath);
+            }
+        }
+        if (decoder == nullptr) {
+            m_isDecoded = true;
+            m_isPrimed = true;
+            return;
+        }
+
+        uint64_t numFrames = decoder->GetNumFrames();
+        uint64_t loopStartFrame = std::min(numFrames,
+            static_cast<uint64_t>(std::max(loopStart, 0.0) * m_sampleRate));
+        uint64_t loopEndFrame = numFrames;
+        if (loopEnd > 0.0) {
+            loopEndFrame = std::min(numFrames,
+                static_cast<uint64_t>(loopEnd * m_sampleRate));
+        }
+        if (loopStartFrame >= loopEndFrame) loopStartFrame = 0;
+        // Like SDL_mixer, 0 also plays it once
+        int numLoops = loops < 0 ? -1 : std::max(loops, 1) - 1;
+
+        size_t ringFrames = m_ringMask + 1;
+        uint64_t position = 0;
+        bool isAtLoopStart = false;
+        for (;;) {
+            uint64_t writeFrame = m_writeFrame.load(std::memory_order_relaxed);
+            uint64_t room = ringFrames -
+                (writeFrame - m_readFrame.load(std::memory_order_acquire));
+            if (room < DECODE_FRAMES / 4) {
+                m_isPrimed = true;
+                if (!WaitForRoom()) return;
+                continue;
+            }
+
+            uint64_t end = numLoops != 0 ? loopEndFrame : numFrames;
+            uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(
+                std::min<uint64_t>(room, DECODE_FRAMES),
+                end - std::min(position, end)));
+            // Up to the end of the ring, the rest goes in the next round
+            size_t offset = writeFrame & m_ringMask;
+            count = static_cast<uint32_t>(std::min<uint64_t>(count,
+                ringFrames - offset));
+            if (count > 0) {
+                count = decoder->Read(&m_ring[2 * offset], count);
+            }
+
+            if (count == 0) {
+                // Nothing more to play, or a loop that is empty
+                if (numLoops == 0 || isAtLoopStart) break;
+                decoder->Seek(loopStartFrame);
+                position = loopStartFrame;
+                isAtLoopStart = true;
+                if (numLoops > 0) numLoops--;
+                continue;
+            }
+
+            position += count;
+            isAtLoopStart = false;
+            m_numFramesDecoded += count;
+            m_writeFrame.store(writeFrame + count, std::memory_order_release);
+        }
+
+        m_isDecoded = true;
+        m_isPrimed = true;
+    }
+
+    MusicStream::ChunkFuture MusicStream::LoadChunk(
+        const std::string& filePath) {
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        CachedChunk& cached = m_chunks[filePath];
+        cached.lastUse = ++m_chunkUseCounter;
+        if (!cached.chunk.valid()) {
+            cached.chunk = std::async(std::launch::async, DecodeChunk,
+                filePath).share();
+        }
+        return cached.chunk;
+    }
+
+    void MusicStream::TrimCache() {
+        for (;;) {
+            size_t bytes = 0;
+            auto victim = m_chunks.end();
+            for (auto it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+                size_t chunkBytes = GetChunkBytes(it->second.chunk);
+                if (chunkBytes == 0) continue;
+                bytes += chunkBytes;
+                if (victim == m_chunks.end() ||
+                    it->second.lastUse < victim->second.lastUse) {
+                    victim = it;
+                }
+            }
+            if (bytes <= m_cacheBudget) return;
+            m_chunks.erase(victim);
+        }
+    }
+
+    bool MusicStream::WaitForChunk(const ChunkFuture& chunk) {
+        // Polled, so a Stop does not wait for the whole decode
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_isStopping) {
+            if (IsReady(chunk)) return true;
+            m_stopCondition.wait_for(lock, std::chrono::milliseconds(10),
+                [this] { return m_isStopping; });
+        }
+        return false;
+    }
+
+    bool MusicStream::WaitForRoom() {
+        // The callback can not signal, so the decoder polls about as often
+        // as the callback frees the room it waits for
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopCondition.wait_for(lock, std::chrono::milliseconds(
+            std::max(1, 1000 * static_cast<int>(DECODE_FRAMES / 4) /
+            m_sampleRate)), [this] { return m_isStopping; });
+        return !m_isStopping;
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,808 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/PNGDecoder.h>
+#include <GangerEngine/PicoPNG.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GANGER_PNG_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace GangerEngine {
+    // Not a png, or truncated
+    static const int PNG_ERROR_FORMAT = PNG_ERROR_BASE + 2;
+    // Invalid IHDR
+    static const int PNG_ERROR_HEADER = PNG_ERROR_BASE + 3;
+    // Corrupt compressed data
+    static const int PNG_ERROR_ZLIB = PNG_ERROR_BASE + 4;
+    // The data does not fit the image
+    static const int PNG_ERROR_SIZE = PNG_ERROR_BASE + 5;
+    // Unknown filter type
+    static const int PNG_ERROR_FILTER = PNG_ERROR_BASE + 6;
+    // Missing or too short palette
+    static const int PNG_ERROR_PALETTE = PNG_ERROR_BASE + 7;
+    // The output buffer is too small
+    static const int PNG_ERROR_BUFFER = PNG_ERROR_BASE + 8;
+
+    static const unsigned char PNG_SIGNATURE[8] = {
+        137, 80, 78, 71, 13, 10, 26, 10 };
+
+    static uint32_t ReadBigEndian32(const unsigned char* data) {
+        return (static_cast<uint32_t>(data[0]) << 24) |
+            (static_cast<uint32_t>(data[1]) << 16) |
+            (static_cast<uint32_t>(data[2]) << 8) | data[3];
+    }
+
+    static bool IsChunk(const unsigned char* type, const char* name) {
+        return memcmp(type, name, 4) == 0;
+    }
+
+    // What the chunks say about the image
+    struct PNGInfo {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int bitDepth = 0;
+        int colorType = 0;
+        int interlace = 0;
+        int channels = 0;
+        unsigned char palette[256 * 4];
+        int paletteSize = 0;
+        bool hasColorKey = false;
+        uint32_t colorKey[3];
+        std::vector<unsigned char> joinedData;  // Only with several IDATs
+        const unsigned char* data = nullptr;
+        size_t dataSize = 0;
+    };
+
+    static int ParseHeader(const unsigned char* in, size_t size,
+        PNGInfo* info) {
+        if (size < 33 || memcmp(in, PNG_SIGNATURE, 8) != 0 ||
+            ReadBigEndian32(in + 8) != 13 || !IsChunk(in + 12, "IHDR")) {
+            return PNG_ERROR_FORMAT;
+        }
+
+        const unsigned char* header = in + 16;
+        info->width = ReadBigEndian32(header);
+        info->height = ReadBigEndian32(header + 4);
+        info->bitDepth = header[8];
+        info->colorType = header[9];
+        info->interlace = header[12];
+        if (info->width == 0 || info->height == 0 ||
+            info->width > (1u << 24) || info->height > (1u << 24) ||
+            header[10] != 0 || header[11] != 0 || info->interlace > 1) {
+            return PNG_ERROR_HEADER;
+        }
+
+        int depth = info->bitDepth;
+        switch (info->colorType) {
+            case 0:
+                info->channels = 1;
+                if (depth != 1 && depth != 2 && depth != 4 && depth != 8 &&
+                    depth != 16) {
+                    return PNG_ERROR_HEADER;
+                }
+                break;
+            case 3:
+                info->channels = 1;
+                if (depth != 1 && depth != 2 && depth != 4 && depth != 8) {
+                    return PNG_ERROR_HEADER;
+                }
+                break;
+            case 2:
+            case 4:
+            case 6:
+                info->channels = info->colorType == 2 ? 3 :
+                    (info->colorType == 4 ? 2 : 4);
+                if (depth != 8 && depth != 16) return PNG_ERROR_HEADER;
+                break;
+            default:
+                return PNG_ERROR_HEADER;
+        }
+        return 0;
+    }
+
+    static int ParseChunks(const unsigned char* in, size_t size,
+        PNGInfo* info) {
+        int error = ParseHeader(in, size, info);
+        if (error != 0) return error;
+
+        std::vector<const unsigned char*> dataChunks;
+        std::vector<size_t> dataSizes;
+        size_t pos = 8;
+        while (true) {
+            if (size - pos < 12) return PNG_ERROR_FORMAT;
+            size_t length = ReadBigEndian32(in + pos);
+            const unsigned char* type = in + pos + 4;
+            const unsigned char* data = in + pos + 8;
+            if (size - pos - 12 < length) return PNG_ERROR_FORMAT;
+            pos += 12 + length;
+
+            if (IsChunk(type, "IDAT")) {
+                dataChunks.push_back(data);
+                dataSizes.push_back(length);
+            } else if (IsChunk(type, "PLTE")) {
+                info->paletteSize = static_cast<int>(length / 3);
+                if (info->paletteSize > 256) return PNG_ERROR_PALETTE;
+                for (int i = 0; i < info->paletteSize; i++) {
+                    memcpy(info->palette + i * 4, data + i * 3, 3);
+                    info->palette[i * 4 + 3] = 255;
+                }
+            } else if (IsChunk(type, "tRNS")) {
+                if (info->colorType == 3) {
+                    if (length > static_cast<size_t>(info->paletteSize)) {
+                        return PNG_ERROR_PALETTE;
+                    }
+                    for (size_t i = 0; i < length; i++) {
+                        info->palette[i * 4 + 3] = data[i];
+                    }
+                } else if (info->colorType == 0 && length == 2) {
+                    info->hasColorKey = true;
+                    info->colorKey[0] = (data[0] << 8) | data[1];
+                } else if (info->colorType == 2 && length == 6) {
+                    info->hasColorKey = true;
+                    for (int i = 0; i < 3; i++) {
+                        info->colorKey[i] = (data[i * 2] << 8) |
+                            data[i * 2 + 1];
+                    }
+                }
+            } else if (IsChunk(type, "IEND")) {
+                break;
+            }
+        }
+
+        if (dataChunks.empty()) return PNG_ERROR_FORMAT;
+        if (dataChunks.size() == 1) {
+            // The usual case, inflate straight from the file
+            info->data = dataChunks[0];
+            info->dataSize = dataSizes[0];
+        } else {
+            for (size_t i = 0; i < dataChunks.size(); i++) {
+                info->joinedData.insert(info->joinedData.end(), dataChunks[i],
+                    dataChunks[i] + dataSizes[i]);
+            }
+            info->data = &info->joinedData[0];
+            info->dataSize = info->joinedData.size();
+        }
+        return 0;
+    }
+
+    static const int HUFFMAN_FAST_BITS = 10;
+    static const int HUFFMAN_FAST_MASK = (1 << HUFFMAN_FAST_BITS) - 1;
+
+    // Canonical huffman code. Codes up to HUFFMAN_FAST_BITS long are found
+    // with one lookup, the rest by code length like zlib's slow path.
+    struct Huffman {
+        uint16_t fast[1 << HUFFMAN_FAST_BITS];  // (length << 9) | symbol
+        uint16_t firstCode[16];
+        uint16_t firstSymbol[16];
+        int maxCode[17];  // Past the last code of a length, shifted to 16
+        uint8_t sizes[288];
+        uint16_t values[288];
+    };
+
+    static int BitReverse16(int n) {
+        n = ((n & 0xaaaa) >> 1) | ((n & 0x5555) << 1);
+        n = ((n & 0xcccc) >> 2) | ((n & 0x3333) << 2);
+        n = ((n & 0xf0f0) >> 4) | ((n & 0x0f0f) << 4);
+        n = ((n & 0xff00) >> 8) | ((n & 0x00ff) << 8);
+        return n;
+    }
+
+    static bool BuildHuffman(Huffman* huffman, const uint8_t* lengths,
+        int numSymbols) {
+        int counts[17] = {};
+        int nextCode[16];
+        memset(huffman->fast, 0, sizeof(huffman->fast));
+        memset(huffman->sizes, 0, sizeof(huffman->sizes));
+
+        for (int i = 0; i < numSymbols; i++) counts[lengths[i]]++;
+        counts[0] = 0;
+
+        int code = 0, symbol = 0;
+        for (int i = 1; i < 16; i++) {
+            nextCode[i] = code;
+            huffman->firstCode[i] = static_cast<uint16_t>(code);
+            huffman->firstSymbol[i] = static_cast<uint16_t>(symbol);
+            code += counts[i];
+            // Over subscribed
+            if (counts[i] != 0 && code - 1 >= (1 << i)) return false;
+            huffman->maxCode[i] = code << (16 - i);
+            code <<= 1;
+            symbol += counts[i];
+        }
+        huffman->maxCode[16] = 0x10000;
+
+        for (int i = 0; i < numSymbols; i++) {
+            int length = lengths[i];
+            if (length == 0) continue;
+
+            int index = nextCode[length] - huffman->firstCode[length] +
+                huffman->firstSymbol[length];
+            huffman->sizes[index] = static_cast<uint8_t>(length);
+            huffman->values[index] = static_cast<uint16_t>(i);
+            if (length <= HUFFMAN_FAST_BITS) {
+                // Deflate sends codes bit reversed, fill every slot that
+                // starts with this one
+                uint16_t entry = static_cast<uint16_t>((length << 9) | i);
+                int slot = BitReverse16(nextCode[length]) >> (16 - length);
+                for (; slot <= HUFFMAN_FAST_MASK; slot += 1 << length) {
+                    huffman->fast[slot] = entry;
+                }
+            }
+            nextCode[length]++;
+        }
+        return true;
+    }
+
+    static const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11,
+        13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131,
+        163, 195, 227, 258 };
+    static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+        1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13,
+        17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+        2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3,
+        3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13,
+        13 };
+    static const uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9,
+        6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    // The codes of the fixed huffman blocks, built once
+    struct FixedHuffman {
+        FixedHuffman() {
+            uint8_t lengths[288];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            BuildHuffman(&literals, lengths, 288);
+
+            memset(lengths, 5, 30);
+            BuildHuffman(&distances, lengths, 30);
+        }
+
+        Huffman literals;
+        Huffman distances;
+    };
+
+    // Inflates a raw deflate stream into a buffer of known size
+    class Inflater {
+     public:
+        Inflater(const unsigned char* in, size_t inSize, unsigned char* out,
+            size_t outSize) : m_in(in), m_inEnd(in + inSize), m_out(out),
+            m_outPos(out), m_outEnd(out + outSize) {
+        }
+
+        bool Inflate() {
+            bool isFinal;
+            do {
+                isFinal = GetBits(1) != 0;
+                uint32_t type = GetBits(2);
+                bool isValid;
+                if (type == 0) {
+                    isValid = InflateStored();
+                } else if (type == 1) {
+                    static const FixedHuffman fixed;
+                    isValid = InflateCodes(fixed.literals, fixed.distances);
+                } else if (type == 2) {
+                    isValid = ReadDynamicCodes() &&
+                        InflateCodes(m_literals, m_distances);
+                } else {
+                    isValid = false;
+                }
+                if (!isValid) return false;
+            } while (!isFinal);
+            return true;
+        }
+
+        size_t GetNumWritten() const {
+            return static_cast<size_t>(m_outPos - m_out);
+        }
+
+     private:
+        void Refill() {
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            if (m_inEnd - m_in >= 8) {
+                // Branchless refill to 56+ bits. The bytes past the count
+                // are loaded again at the same place next time.
+                uint64_t word;
+                memcpy(&word, m_in, sizeof(word));
+                m_bits |= word << m_numBits;
+                m_in += (63 - m_numBits) >> 3;
+                m_numBits |= 56;
+                return;
+            }
+#endif
+            while (m_numBits <= 56) {
+                if (m_in < m_inEnd) {
+                    m_bits |= static_cast<uint64_t>(*m_in++) << m_numBits;
+                } else {
+                    // Zeros past the end, a valid stream never reads them
+                    m_numOverrun++;
+                }
+                m_numBits += 8;
+            }
+        }
+
+        uint32_t GetBits(int count) {
+            if (m_numBits < count) Refill();
+            uint32_t value = static_cast<uint32_t>(m_bits) &
+                ((1u << count) - 1);
+            m_bits >>= count;
+            m_numBits -= count;
+            return value;
+        }
+
+        int Decode(const Huffman& huffman) {
+            if (m_numBits < 16) Refill();
+
+            int entry = huffman.fast[m_bits & HUFFMAN_FAST_MASK];
+            if (entry != 0) {
+                int length = entry >> 9;
+                m_bits >>= length;
+                m_numBits -= length;
+                return entry & 511;
+            }
+
+            // Longer codes, compare the reversed bits length by length
+            int code = BitReverse16(static_cast<int>(m_bits & 0xffff));
+            int length = HUFFMAN_FAST_BITS + 1;
+            while (code >= huffman.maxCode[length]) length++;
+            if (length >= 16) return -1;
+
+            int index = (code >> (16 - length)) - huffman.firstCode[length] +
+                huffman.firstSymbol[length];
+            if (index >= 288 || huffman.sizes[index] != length) return -1;
+            m_bits >>= length;
+            m_numBits -= length;
+            return huffman.values[index];
+        }
+
+        bool InflateStored() {
+            // Stored data is byte aligned, give the whole bytes still in the
+            // bit buffer back to the input
+            m_bits >>= m_numBits & 7;
+            m_numBits &= ~7;
+            int numBuffered = m_numBits >> 3;
+            if (m_numOverrun > numBuffered) return false;
+            m_in -= numBuffered - m_numOverrun;
+            m_bits = 0;
+            m_numBits = 0;
+            m_numOverrun = 0;
+
+            if (m_inEnd - m_in < 4) return false;
+            size_t length = m_in[0] | (m_in[1] << 8);
+            size_t lengthComplement = m_in[2] | (m_in[3] << 8);
+            m_in += 4;
+            if ((length ^ 0xffff) != lengthComplement ||
+                static_cast<size_t>(m_inEnd - m_in) < length ||
+                static_cast<size_t>(m_outEnd - m_outPos) < length) {
+                return false;
+            }
+
+            memcpy(m_outPos, m_in, length);
+            m_outPos += length;
+            m_in += length;
+            return true;
+        }
+
+        bool ReadDynamicCodes() {
+            int numLiterals = static_cast<int>(GetBits(5)) + 257;
+            int numDistances = static_cast<int>(GetBits(5)) + 1;
+            int numCodeLengths = static_cast<int>(GetBits(4)) + 4;
+
+            uint8_t codeLengthLengths[19] = {};
+            for (int i = 0; i < numCodeLengths; i++) {
+                codeLengthLengths[CODE_LENGTH_ORDER[i]] =
+                    static_cast<uint8_t>(GetBits(3));
+            }
+            Huffman codeLengths;
+            if (!BuildHuffman(&codeLengths, codeLengthLengths, 19)) {
+                return false;
+            }
+
+            uint8_t lengths[288 + 32];
+            int total = numLiterals + numDistances;
+            int count = 0;
+            while (count < total) {
+                int symbol = Decode(codeLengths);
+                if (symbol < 0 || symbol >= 19) return false;
+
+                if (symbol < 16) {
+                    lengths[count++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                int repeat;
+                uint8_t value = 0;
+                if (symbol == 16) {
+                    if (count == 0) return false;
+                    repeat = 3 + static_cast<int>(GetBits(2));
+                    value = lengths[count - 1];
+                } else if (symbol == 17) {
+                    repeat = 3 + static_cast<int>(GetBits(3));
+                } else {
+                    repeat = 11 + static_cast<int>(GetBits(7));
+                }
+                if (total - count < repeat) return false;
+                memset(lengths + count, value, repeat);
+                count += repeat;
+            }
+            if (m_numOverrun > 8) return false;
+
+            return BuildHuffman(&m_literals, lengths, numLiterals) &&
+                BuildHuffman(&m_distances, lengths + numLiterals,
+                    numDistances);
+        }
+
+        bool InflateCodes(const Huffman& literals,
+            const Huffman& distances) {
+            while (true) {
+                int symbol = Decode(literals);
+                if (symbol < 256) {
+                    if (symbol < 0 || m_outPos == m_outEnd) return false;
+                    *m_outPos++ = static_cast<unsigned char>(symbol);
+                    continue;
+                }
+                if (symbol == 256) return m_numOverrun <= 8;
+
+                symbol -= 257;
+                if (symbol >= 29) return false;
+                size_t length = LENGTH_BASE[symbol] +
+                    GetBits(LENGTH_EXTRA[symbol]);
+
+                int code = Decode(distances);
+                if (code < 0 || code >= 30) return false;
+                size_t distance = DISTANCE_BASE[code] +
+                    GetBits(DISTANCE_EXTRA[code]);
+
+                if (distance > static_cast<size_t>(m_outPos - m_out) ||
+                    length > static_cast<size_t>(m_outEnd - m_outPos) ||
+                    m_numOverrun > 8) {
+                    return false;
+                }
+
+                const unsigned char* from = m_outPos - distance;
+                if (distance == 1) {
+                    memset(m_outPos, *from, length);
+                } else if (distance >= length) {
+                    memcpy(m_outPos, from, length);
+                } else {
+                    // Overlapping, the copy repeats its own output
+                    for (size_t i = 0; i < length; i++) {
+                        m_outPos[i] = from[i];
+                    }
+                }
+                m_outPos += length;
+            }
+        }
+
+        const unsigned char* m_in;
+        const unsigned char* m_inEnd;
+        unsigned char* m_out;
+        unsigned char* m_outPos;
+        unsigned char* m_outEnd;
+        uint64_t m_bits = 0;
+        int m_numBits = 0;
+        int m_numOverrun = 0;  // Zero bytes fed past the end of the input
+        Huffman m_literals;
+        Huffman m_distances;
+    };
+
+    static int Paeth(int a, int b, int c) {
+        int pa = abs(b - c);
+        int pb = abs(a - c);
+        int pc = abs(a + b - 2 * c);
+        if (pa <= pb && pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+
+    static void UnfilterRowScalar(unsigned char* dst,
+        const unsigned char* src, const unsigned char* prior,
+        size_t rowBytes, size_t bpp, int filter) {
+        switch (filter) {
+            case 1:
+                for (size_t i = 0; i < bpp; i++) dst[i] = src[i];
+                for (size_t i = bpp; i < rowBytes; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] +
+                        dst[i - bpp]);
+                }
+                break;
+            case 2:
+                for (size_t i = 0; i < rowBytes; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] + prior[i]);
+                }
+                break;
+            case 3:
+                for (size_t i = 0; i < bpp; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] +
+                        (prior[i] >> 1));
+                }
+                for (size_t i = bpp; i < rowBytes; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] +
+                        ((dst[i - bpp] + prior[i]) >> 1));
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < bpp; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] + prior[i]);
+                }
+                for (size_t i = bpp; i < rowBytes; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] +
+                        Paeth(dst[i - bpp], prior[i], prior[i - bpp]));
+                }
+                break;
+            default:
+                if (dst != src) memcpy(dst, src, rowBytes);
+                break;
+        }
+    }
+
+#ifdef GANGER_PNG_SSE2
+    // Sub, Avg and Paeth depend on the pixel to the left, so they run a
+    // pixel at a time with the channels in parallel. Up is 16 bytes wide.
+    template <int BPP>
+    static __m128i LoadPixel(const unsigned char* data) {
+        int value = 0;
+        memcpy(&value, data, BPP);
+        return _mm_cvtsi32_si128(value);
+    }
+
+    template <int BPP>
+    static void StorePixel(unsigned char* data, __m128i pixel) {
+        int value = _mm_cvtsi128_si32(pixel);
+        memcpy(data, &value, BPP);
+    }
+
+    static __m128i Select(__m128i mask, __m128i a, __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    static __m128i Abs16(__m128i value) {
+        return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(),
+            value));
+    }
+
+    template <int BPP>
+    static void UnfilterRowSSE2(unsigned char* dst, const unsigned char* src,
+        const unsigned char* prior, size_t rowBytes, int filter) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i a = zero;
+
+        switch (filter) {
+            case 1:
+                for (size_t i = 0; i < rowBytes; i += BPP) {
+                    a = _mm_add_epi8(a, LoadPixel<BPP>(src + i));
+                    StorePixel<BPP>(dst + i, a);
+                }
+                break;
+            case 2: {
+                size_t i = 0;
+                for (; i + 16 <= rowBytes; i += 16) {
+                    __m128i x = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(src + i));
+                    __m128i b = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(prior + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                        _mm_add_epi8(x, b));
+                }
+                for (; i < rowBytes; i++) {
+                    dst[i] = static_cast<unsigned char>(src[i] + prior[i]);
+                }
+                break;
+            }
+            case 3: {
+                // avg_epu8 rounds up, take the carry back for a floor
+                const __m128i one = _mm_set1_epi8(1);
+                for (size_t i = 0; i < rowBytes; i += BPP) {
+                    __m128i b = LoadPixel<BPP>(prior + i);
+                    __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b),
+                        _mm_and_si128(_mm_xor_si128(a, b), one));
+                    a = _mm_add_epi8(LoadPixel<BPP>(src + i), average);
+                    StorePixel<BPP>(dst + i, a);
+                }
+                break;
+            }
+            case 4: {
+                // In 16 bit lanes, p - a = b - c, p - b = a - c and
+                // p - c = (b - c) + (a - c)
+                const __m128i low = _mm_set1_epi16(0xff);
+                __m128i c = zero;
+                for (size_t i = 0; i < rowBytes; i += BPP) {
+                    __m128i b = _mm_unpacklo_epi8(LoadPixel<BPP>(prior + i),
+                        zero);
+                    __m128i x = _mm_unpacklo_epi8(LoadPixel<BPP>(src + i),
+                        zero);
+                    __m128i pa = _mm_sub_epi16(b, c);
+                    __m128i pb = _mm_sub_epi16(a, c);
+                    __m128i pc = Abs16(_mm_add_epi16(pa, pb));
+                    pa = Abs16(pa);
+                    pb = Abs16(pb);
+
+                    __m128i smallest = _mm_min_epi16(pc,
+                        _mm_min_epi16(pa, pb));
+                    __m128i predictor = Select(
+                        _mm_cmpeq_epi16(smallest, pb), b, c);
+                    predictor = Select(_mm_cmpeq_epi16(smallest, pa), a,
+                        predictor);
+
+                    a = _mm_and_si128(_mm_add_epi16(x, predictor), low);
+                    StorePixel<BPP>(dst + i, _mm_packus_epi16(a, a));
+                    c = b;
+                }
+                break;
+            }
+            default:
+                if (dst != src) memcpy(dst, src, rowBytes);
+                break;
+        }
+    }
+#endif
+
+    // dst may be src, prior is the previous unfiltered row
+    static void UnfilterRow(unsigned char* dst, const unsigned char* src,
+        const unsigned char* prior, size_t rowBytes, int bpp, int filter) {
+#ifdef GANGER_PNG_SSE2
+        if (bpp == 4) {
+            UnfilterRowSSE2<4>(dst, src, prior, rowBytes, filter);
+            return;
+        }
+        if (bpp == 3) {
+            UnfilterRowSSE2<3>(dst, src, prior, rowBytes, filter);
+            return;
+        }
+#endif
+        UnfilterRowScalar(dst, src, prior, rowBytes, bpp, filter);
+    }
+
+    static bool ExpandRow(unsigned char* out, const unsigned char* row,
+        uint32_t width, const PNGInfo& info) {
+        switch (info.colorType) {
+            case 0:
+                for (uint32_t x = 0; x < width; x++, out += 4) {
+                    out[0] = out[1] = out[2] = row[x];
+                    out[3] = info.hasColorKey && row[x] == info.colorKey[0] ?
+                        0 : 255;
+                }
+                break;
+            case 2:
+                for (uint32_t x = 0; x < width; x++, out += 4, row += 3) {
+                    out[0] = row[0];
+                    out[1] = row[1];
+                    out[2] = row[2];
+                    out[3] = info.hasColorKey && row[0] == info.colorKey[0] &&
+                        row[1] == info.colorKey[1] &&
+                        row[2] == info.colorKey[2] ? 0 : 255;
+                }
+                break;
+            case 3:
+                for (uint32_t x = 0; x < width; x++, out += 4) {
+                    if (row[x] >= info.paletteSize) return false;
+                    memcpy(out, info.palette + row[x] * 4, 4);
+                }
+                break;
+            case 4:
+                for (uint32_t x = 0; x < width; x++, out += 4, row += 2) {
+                    out[0] = out[1] = out[2] = row[0];
+                    out[3] = row[1];
+                }
+                break;
+            default:
+                memcpy(out, row, static_cast<size_t>(width) * 4);
+                break;
+        }
+        return true;
+    }
+
+    int ReadPNGSize(const unsigned char* in, size_t size,
+        unsigned long& width, unsigned long& height) {
+        PNGInfo info;
+        int error = ParseHeader(in, size, &info);
+        if (error != 0) return error;
+
+        width = info.width;
+        height = info.height;
+        return 0;
+    }
+
+    int DecodePNGFast(const unsigned char* in, size_t size,
+        unsigned char* out, size_t outSize) {
+        PNGInfo info;
+        int error = ParseChunks(in, size, &info);
+        if (error != 0) return error;
+        if (info.bitDepth != 8 || info.interlace != 0) {
+            return PNG_ERROR_UNSUPPORTED;
+        }
+        if (info.colorType == 3 && info.paletteSize == 0) {
+            return PNG_ERROR_PALETTE;
+        }
+
+        size_t width = info.width;
+        size_t height = info.height;
+        if (outSize < width * height * 4) return PNG_ERROR_BUFFER;
+
+        // The zlib header: deflate, no preset dictionary
+        const unsigned char* data = info.data;
+        if (info.dataSize < 2 || (data[0] & 15) != 8 || (data[1] & 32) ||
+            ((data[0] << 8) | data[1]) % 31 != 0) {
+            return PNG_ERROR_ZLIB;
+        }
+
+        size_t rowBytes = width * info.channels;
+        size_t stride = rowBytes + 1;
+        std::vector<unsigned char> filtered(stride * height);
+        Inflater inflater(data + 2, info.dataSize - 2, &filtered[0],
+            filtered.size());
+        if (!inflater.Inflate()) return PNG_ERROR_ZLIB;
+        if (inflater.GetNumWritten() != filtered.size()) return PNG_ERROR_SIZE;
+
+        // RGBA rows are unfiltered straight into the output, the others in
+        // place and then expanded
+        std::vector<unsigned char> zeroRow(rowBytes, 0);
+        const unsigned char* prior = &zeroRow[0];
+        for (size_t y = 0; y < height; y++) {
+            unsigned char* line = &filtered[y * stride];
+            int filter = line[0];
+            if (filter > 4) return PNG_ERROR_FILTER;
+
+            unsigned char* outRow = out + y * width * 4;
+            if (info.colorType == 6) {
+                UnfilterRow(outRow, line + 1, prior, rowBytes, 4, filter);
+                prior = outRow;
+            } else {
+                UnfilterRow(line + 1, line + 1, prior, rowBytes,
+                    info.channels, filter);
+                if (!ExpandRow(outRow, line + 1, info.width, info)) {
+                    return PNG_ERROR_PALETTE;
+                }
+                prior = line + 1;
+            }
+        }
+        return 0;
+    }
+
+    int DecodePNGFast(std::vector<unsigned char>& outImage,
+        unsigned long& width, unsigned long& height, const unsigned char* in,
+        size_t size) {
+        int error = ReadPNGSize(in, size, width, height);
+        if (error != 0) return error;
+
+        outImage.resize(static_cast<size_t>(width) * height * 4);
+        error = DecodePNGFast(in, size, &outImage[0], outImage.size());
+        if (error != 0) outImage.clear();
+        return error;
+    }
+
+    int DecodePNGImage(std::vector<unsigned char>& outImage,
+        unsigned long& width, unsigned long& height, const unsigned char* in,
+        size_t size, PNGDecoderType decoder) {
+        if (decoder == PNGDecoderType::FAST) {
+            // PicoPNG is more lenient, and reports its own error codes
+            if (DecodePNGFast(outImage, width, height, in, size) == 0) {
+                return 0;
+            }
+        }
+        return DecodePNG(outImage, width, height, in, size);
+    }
+}  // namespace GangerEngine
@@ -15,6 +15,10 @@
 */
 
 #include <GangerEngine/ParticleBatch2D.h>
+#include <GangerEngine/DecalLayer2D.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace GangerEngine {
     ParticleBatch2D::ParticleBatch2D() {
@@ -36,14 +40,139 @@ namespace GangerEngine {
     }
 
     void ParticleBatch2D::Update(float deltaTime) {
+        // Nothing to simulate
+        if (m_numActiveParticles == 0) {
+            m_pendingDeltaTime = 0.0f;
+            m_skippedUpdates = 0;
+            return;
+        }
+
+        // Off-screen batches are simulated at a lower rate. The skipped time
+        // is banked and applied all at once on the next simulated update, or
+        // as soon as the batch becomes visible again.
+        m_pendingDeltaTime += deltaTime;
+        if (!m_visible && ++m_skippedUpdates < m_offscreenDivisor *
+            m_simulationDivisor) {
+            return;
+        }
+
+        Simulate(m_pendingDeltaTime);
+        m_pendingDeltaTime = 0.0f;
+        m_skippedUpdates = 0;
+    }
+
+    void ParticleBatch2D::Simulate(float deltaTime) {
+        // A shorter lifetime is a faster decay
+        float decay = m_decayRate * deltaTime / m_lifeScale;
+        int numActive = 0;
+        glm::vec2 boundsMin(0.0f);
+        glm::vec2 boundsMax(0.0f);
+        float maxSpeed2 = 0.0f;
+        const float staticSpeed2 = m_staticSpeed * m_staticSpeed;
+        const bool hasCollision = m_collision.tiles || m_collision.circles;
         for (int i = 0; i < m_maxParticles; i++) {
+            auto& p = m_particles[i];
             // Check if it is active
-            if (m_particles[i].life > 0.0f) {
+            if (p.life > 0.0f) {
                 // Update using function pointer
-                m_updateFunc(&m_particles[i], deltaTime);
-                m_particles[i].life -= m_decayRate * deltaTime;
+                glm::vec2 previousPosition = p.position;
+                m_updateFunc(&p, deltaTime);
+                p.life -= decay;
+
+                if (hasCollision)
+                    Collide(&p, previousPosition);
+
+                if (m_decalLayer) {
+                    // Expired and resting particles leave a decal behind
+                    if (p.life > 0.0f && glm::dot(p.velocity, p.velocity) <
+                        staticSpeed2) {
+                        p.life = 0.0f;
+                    }
+                    if (p.life <= 0.0f) {
+                        m_decalLayer->AddDecal(glm::vec4(p.position.x,
+                            p.position.y, p.width, p.width), m_texture.id,
+                            p.color);
+                    }
+                }
+
+                if (p.life > 0.0f) {
+                    // Grow the bounds to hold the particle quad
+                    glm::vec2 pMax = p.position + glm::vec2(p.width);
+                    if (numActive == 0) {
+                        boundsMin = p.position;
+                        boundsMax = pMax;
+                    } else {
+                        boundsMin = glm::min(boundsMin, p.position);
+                        boundsMax = glm::max(boundsMax, pMax);
+                    }
+                    maxSpeed2 = std::max(maxSpeed2, glm::dot(p.velocity,
+                        p.velocity));
+                    numActive++;
+                }
+            }
+        }
+        m_numActiveParticles = numActive;
+        m_boundsMin = boundsMin;
+        m_boundsMax = boundsMax;
+        m_maxSpeed = std::sqrt(maxSpeed2);
+    }
+
+    void ParticleBatch2D::Collide(Particle2D* p,
+        const glm::vec2& previousPosition) {
+        const ParticleCollision2D& c = m_collision;
+        glm::vec2 halfWidth(p->width * 0.5f);
+        glm::vec2 center = p->position + halfWidth;
+
+        if (c.tiles && c.tiles->IsSolidAt(center)) {
+            if (c.response == ParticleCollisionResponse::KILL) {
+                p->life = 0.0f;
+                return;
             }
+            // Flip the velocity on the axes that crossed into the tile
+            glm::vec2 previousCenter = previousPosition + halfWidth;
+            bool hitX = c.tiles->IsSolidAt(glm::vec2(center.x,
+                previousCenter.y));
+            bool hitY = c.tiles->IsSolidAt(glm::vec2(previousCenter.x,
+                center.y));
+            if (!hitX && !hitY)
+                hitX = hitY = true;  // Straight into a corner
+            if (hitX)
+                p->velocity.x = -p->velocity.x;
+            if (hitY)
+                p->velocity.y = -p->velocity.y;
+            p->velocity *= c.restitution;
+            p->position = previousPosition;
+            return;
         }
+
+        glm::vec2 circleCenter;
+        float circleRadius;
+        if (c.circles && c.circles->FindCircle(center, circleCenter,
+            circleRadius)) {
+            if (c.response == ParticleCollisionResponse::KILL) {
+                p->life = 0.0f;
+                return;
+            }
+            // Reflect about the surface normal and push out to the surface
+            glm::vec2 offset = center - circleCenter;
+            float distance = glm::length(offset);
+            glm::vec2 normal = distance > 0.0f ? offset / distance :
+                glm::vec2(1.0f, 0.0f);
+            float vn = glm::dot(p->velocity, normal);
+            if (vn < 0.0f)
+                p->velocity -= 2.0f * vn * normal;
+            p->velocity *= c.restitution;
+            p->position = circleCenter + normal * circleRadius - halfWidth;
+        }
+    }
+
+    glm::vec4 ParticleBatch2D::GetBounds() const {
+        // Particles may have moved since the last simulation step, up to
+        // the fastest speed seen for the time still pending
+        float margin = m_maxSpeed * m_pendingDeltaTime;
+        return glm::vec4(m_boundsMin.x - margin, m_boundsMin.y - margin,
+            m_boundsMax.x - m_boundsMin.x + 2.0f * margin,
+            m_boundsMax.y - m_boundsMin.y + 2.0f * margin);
     }
 
     void ParticleBatch2D::Draw(SpriteBatch* spriteBatch) {
@@ -62,9 +191,22 @@ namespace GangerEngine {
 
     void ParticleBatch2D::AddParticle(const glm::vec2& position,
         const glm::vec2& velocity, const ColorRGBA8& color, float width) {
+        // Only spawn the fraction of particles allowed by the spawn scale
+        m_spawnCredit += m_spawnScale;
+        if (m_spawnCredit < 1.0f) {
+            m_droppedSpawns++;
+            return;
+        }
+        m_spawnCredit -= 1.0f;
+
         int particleIndex = FindFreeParticle();
 
         auto& p = m_particles[particleIndex];
+        if (p.life <= 0.0f)
+            m_numActiveParticles++;
+
+        // Keep the bounds valid until the next simulation step
+        AddToBounds(position, velocity, width);
 
         p.life = 1.0f;
         p.position = position;
@@ -73,6 +215,54 @@ namespace GangerEngine {
         p.width = width;
     }
 
+    int ParticleBatch2D::AddParticles(int count, const float* positionX,
+        const float* positionY, const float* velocityX,
+        const float* velocityY, const ColorRGBA8* colors,
+        const float* widths) {
+        // Apply the spawn scale to the whole group at once
+        m_spawnCredit += m_spawnScale * static_cast<float>(count);
+        int toSpawn = std::min(count, static_cast<int>(m_spawnCredit));
+        m_spawnCredit -= static_cast<float>(toSpawn);
+
+        // Single sweep over the particles, starting at the last free one
+        int added = 0;
+        int index = m_lastFreeParticle;
+        for (int checked = 0; checked < m_maxParticles && added < toSpawn;
+            checked++) {
+            auto& p = m_particles[index];
+            if (p.life <= 0.0f) {
+                p.life = 1.0f;
+                p.position = glm::vec2(positionX[added], positionY[added]);
+                p.velocity = glm::vec2(velocityX[added], velocityY[added]);
+                p.color = colors[added];
+                p.width = widths[added];
+                m_numActiveParticles++;
+                AddToBounds(p.position, p.velocity, p.width);
+                m_lastFreeParticle = index;
+                added++;
+            }
+            if (++index == m_maxParticles)
+                index = 0;
+        }
+
+        m_droppedSpawns += static_cast<unsigned int>(count - added);
+        return added;
+    }
+
+    void ParticleBatch2D::AddToBounds(const glm::vec2& position,
+        const glm::vec2& velocity, float width) {
+        glm::vec2 pMax = position + glm::vec2(width);
+        if (m_numActiveParticles == 1) {
+            m_boundsMin = position;
+            m_boundsMax = pMax;
+            m_maxSpeed = 0.0f;
+        } else {
+            m_boundsMin = glm::min(m_boundsMin, position);
+            m_boundsMax = glm::max(m_boundsMax, pMax);
+        }
+        m_maxSpeed = std::max(m_maxSpeed, glm::length(velocity));
+    }
+
     int ParticleBatch2D::FindFreeParticle() {
         for (int i = m_lastFreeParticle; i < m_maxParticles; i++) {
             if (m_particles[i].life <= 0.0f) {
@@ -0,0 +1,109 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/ParticleBudget.h>
+#include <GangerEngine/ParticleBatch2D.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace GangerEngine {
+    // How fast the measured time follows the last frame
+    const float TIME_SMOOTHING = 0.2f;
+    // Below this pressure the throttle starts to relax
+    const float RELAX_PRESSURE = 0.8f;
+    const float RELAX_STEP = 0.02f;
+    const float MIN_THROTTLE_STEP = 0.05f;
+    // Limits of the per batch scales at full throttle
+    const float MIN_SPAWN_SCALE = 0.25f;
+    const float MIN_LIFE_SCALE = 0.5f;
+    const int MAX_SIMULATION_DIVISOR = 4;
+
+    void ParticleBudget::Init(int maxParticles, float maxMilliseconds) {
+        m_maxParticles = maxParticles;
+        m_maxMilliseconds = maxMilliseconds;
+        m_smoothedMilliseconds = 0.0f;
+        m_throttle = 0.0f;
+        m_stats = ParticleBudgetStats();
+    }
+
+    void ParticleBudget::Govern(const std::vector<ParticleBatch2D*>& batches,
+        float updateMilliseconds, float drawMilliseconds) {
+        m_stats = ParticleBudgetStats();
+        m_stats.updateMilliseconds = updateMilliseconds;
+        m_stats.drawMilliseconds = drawMilliseconds;
+
+        for (auto& b : batches) {
+            m_stats.liveParticles += b->GetNumActiveParticles();
+            m_stats.droppedSpawns += b->TakeDroppedSpawns();
+        }
+
+        if (!IsEnabled())
+            return;
+
+        // Work out how far over the budget we are
+        m_smoothedMilliseconds += (updateMilliseconds + drawMilliseconds -
+            m_smoothedMilliseconds) * TIME_SMOOTHING;
+        float pressure = 0.0f;
+        if (m_maxParticles > 0) {
+            pressure = static_cast<float>(m_stats.liveParticles) /
+                static_cast<float>(m_maxParticles);
+        }
+        if (m_maxMilliseconds > 0.0f) {
+            pressure = std::max(pressure, m_smoothedMilliseconds /
+                m_maxMilliseconds);
+        }
+        m_stats.pressure = pressure;
+
+        // Throttle up quickly and relax slowly so it doesn't oscillate
+        if (pressure > 1.0f) {
+            m_throttle += std::max(MIN_THROTTLE_STEP, pressure - 1.0f);
+        } else if (pressure < RELAX_PRESSURE) {
+            m_throttle -= RELAX_STEP;
+        }
+        m_throttle = std::min(1.0f, std::max(0.0f, m_throttle));
+        m_stats.throttle = m_throttle;
+
+        m_sortedBatches = batches;
+        std::stable_sort(m_sortedBatches.begin(), m_sortedBatches.end(),
+            [](ParticleBatch2D* a, ParticleBatch2D* b) {
+                return a->GetPriority() < b->GetPriority();
+            });
+
+        // Spread the throttle from the lowest priority batch upwards, so a
+        // batch is only throttled once all the batches below are at maximum
+        float totalThrottle = m_throttle *
+            static_cast<float>(m_sortedBatches.size());
+        for (size_t i = 0; i < m_sortedBatches.size(); i++) {
+            ParticleBatch2D* b = m_sortedBatches[i];
+            float t = std::min(1.0f, std::max(0.0f, totalThrottle -
+                static_cast<float>(i)));
+
+            b->SetSpawnScale(1.0f - (1.0f - MIN_SPAWN_SCALE) * t);
+            b->SetLifeScale(1.0f - (1.0f - MIN_LIFE_SCALE) * t);
+            if (t > 0.0f)
+                m_stats.throttledBatches++;
+
+            // Only applied while the batch is off-screen, where nobody sees
+            // it skipping updates
+            int divisor = 1 + static_cast<int>(t * (MAX_SIMULATION_DIVISOR - 1)
+                + 0.5f);
+            b->SetSimulationDivisor(divisor);
+            if (divisor > 1 && !b->IsVisible())
+                m_stats.slowedBatches++;
+        }
+    }
+}  // namespace GangerEngine
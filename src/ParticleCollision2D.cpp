@@ -0,0 +1,99 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/ParticleCollision2D.h>
+
+#include <cmath>
+#include <vector>
+
+namespace GangerEngine {
+    void TileOccupancyGrid::Init(const glm::vec2& origin, float tileSize,
+        int width, int height) {
+        m_origin = origin;
+        m_tileSize = tileSize;
+        m_invTileSize = 1.0f / tileSize;
+        m_width = width;
+        m_height = height;
+        m_wordsPerRow = (width + 63) / 64;
+        m_bits.assign(static_cast<size_t>(m_wordsPerRow) * height, 0);
+    }
+
+    void TileOccupancyGrid::SetSolid(int x, int y, bool solid) {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+            return;
+        uint64_t& word = m_bits[y * m_wordsPerRow + (x >> 6)];
+        uint64_t mask = static_cast<uint64_t>(1) << (x & 63);
+        if (solid)
+            word |= mask;
+        else
+            word &= ~mask;
+    }
+
+    void CircleSpatialHash::Init(float cellSize) {
+        m_cellSize = cellSize;
+        m_invCellSize = 1.0f / cellSize;
+        m_circles.clear();
+        m_cells.clear();
+    }
+
+    void CircleSpatialHash::Clear() {
+        m_circles.clear();
+        for (auto& it : m_cells) {
+            it.second.clear();
+        }
+    }
+
+    void CircleSpatialHash::AddCircle(const glm::vec2& center, float radius) {
+        int index = static_cast<int>(m_circles.size());
+        m_circles.push_back({ center, radius });
+
+        // Insert in every cell the circle bounds touch, so a query only has
+        // to look at the cell of the point
+        int x0 = static_cast<int>(std::floor((center.x - radius) *
+            m_invCellSize));
+        int y0 = static_cast<int>(std::floor((center.y - radius) *
+            m_invCellSize));
+        int x1 = static_cast<int>(std::floor((center.x + radius) *
+            m_invCellSize));
+        int y1 = static_cast<int>(std::floor((center.y + radius) *
+            m_invCellSize));
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                m_cells[CellKey(x, y)].push_back(index);
+            }
+        }
+    }
+
+    bool CircleSpatialHash::FindCircle(const glm::vec2& point,
+        glm::vec2& center, float& radius) const {
+        auto it = m_cells.find(CellKey(
+            static_cast<int>(std::floor(point.x * m_invCellSize)),
+            static_cast<int>(std::floor(point.y * m_invCellSize))));
+        if (it == m_cells.end())
+            return false;
+
+        for (int i : it->second) {
+            const Circle& c = m_circles[i];
+            glm::vec2 d = point - c.center;
+            if (glm::dot(d, d) < c.radius * c.radius) {
+                center = c.center;
+                radius = c.radius;
+                return true;
+            }
+        }
+        return false;
+    }
+}  // namespace GangerEngine
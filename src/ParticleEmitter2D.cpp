@@ -0,0 +1,199 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/ParticleEmitter2D.h>
+#include <GangerEngine/ParticleBatch2D.h>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
+#include <GangerEngine/MemoryStream.h>
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace GangerEngine {
+    const float DEG_TO_RAD = 3.14159265359f / 180.0f;
+
+    // Independent random streams for each spawned value
+    enum RandomStream : uint32_t {
+        STREAM_SHAPE_A,
+        STREAM_SHAPE_B,
+        STREAM_SPEED,
+        STREAM_ANGLE,
+        STREAM_COLOR,
+        STREAM_WIDTH,
+        NUM_STREAMS
+    };
+
+    // Integer hash with good avalanche, used as a counter based generator
+    static inline uint32_t Hash32(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static inline GLubyte LerpByte(GLubyte a, GLubyte b, float t) {
+        return static_cast<GLubyte>(static_cast<float>(a) +
+            (static_cast<float>(b) - static_cast<float>(a)) * t + 0.5f);
+    }
+
+    void ParticleEmitter2D::Init(ParticleBatch2D* batch,
+        const ParticleEmitterDesc& desc, uint32_t seed) {
+        m_batch = batch;
+        m_desc = desc;
+        m_seed = Hash32(seed);
+        m_counter = 0;
+        m_spawnAccumulator = 0.0f;
+    }
+
+    bool ParticleEmitter2D::LoadFromFile(const std::string& filePath,
+        ParticleEmitterDesc& desc) {
+        MappedFile mappedFile;
+        if (!IOManager::MapFile(filePath, &mappedFile))
+            return false;
+
+        MemoryStream file(mappedFile);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            // Strip comments
+            size_t comment = line.find('#');
+            if (comment != std::string::npos)
+                line.erase(comment);
+
+            std::istringstream values(line);
+            std::string key;
+            if (!(values >> key))
+                continue;
+
+            if (key == "rate") {
+                values >> desc.spawnRate;
+            } else if (key == "burst") {
+                values >> desc.burstCount;
+            } else if (key == "shape") {
+                std::string shape;
+                values >> shape;
+                if (shape == "point") {
+                    desc.shape = EmitterShape::POINT;
+                } else if (shape == "circle") {
+                    desc.shape = EmitterShape::CIRCLE;
+                    values >> desc.shapeSize.x;
+                    desc.shapeSize.y = desc.shapeSize.x;
+                } else if (shape == "box") {
+                    desc.shape = EmitterShape::BOX;
+                    values >> desc.shapeSize.x >> desc.shapeSize.y;
+                } else {
+                    values.setstate(std::ios::failbit);
+                }
+            } else if (key == "speed") {
+                values >> desc.minSpeed >> desc.maxSpeed;
+            } else if (key == "angle") {
+                values >> desc.minAngle >> desc.maxAngle;
+            } else if (key == "color") {
+                int c[8];
+                for (int i = 0; i < 8; i++)
+                    values >> c[i];
+                desc.minColor = ColorRGBA8(c[0], c[1], c[2], c[3]);
+                desc.maxColor = ColorRGBA8(c[4], c[5], c[6], c[7]);
+            } else if (key == "width") {
+                values >> desc.minWidth >> desc.maxWidth;
+            } else {
+                values.setstate(std::ios::failbit);
+            }
+
+            if (values.fail()) {
+                std::printf("%s:%d: invalid emitter line '%s'\n",
+                    filePath.c_str(), lineNumber, line.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void ParticleEmitter2D::Update(float deltaTime) {
+        m_spawnAccumulator += m_desc.spawnRate * deltaTime;
+        int count = static_cast<int>(m_spawnAccumulator);
+        m_spawnAccumulator -= static_cast<float>(count);
+        Emit(count);
+    }
+
+    float ParticleEmitter2D::Random(uint32_t counter, uint32_t stream) const {
+        uint32_t h = Hash32((counter * NUM_STREAMS + stream) ^ m_seed);
+        // Top 24 bits fit exactly in a float mantissa
+        return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+    }
+
+    void ParticleEmitter2D::Emit(int count) {
+        if (count <= 0 || m_batch == nullptr)
+            return;
+
+        m_positionX.resize(count);
+        m_positionY.resize(count);
+        m_velocityX.resize(count);
+        m_velocityY.resize(count);
+        m_widths.resize(count);
+        m_colors.resize(count);
+
+        const ParticleEmitterDesc& d = m_desc;
+        const float minAngle = d.minAngle * DEG_TO_RAD;
+        const float angleRange = (d.maxAngle - d.minAngle) * DEG_TO_RAD;
+        const float speedRange = d.maxSpeed - d.minSpeed;
+        const float widthRange = d.maxWidth - d.minWidth;
+
+        // Every value only depends on the particle counter, so there is no
+        // state carried between iterations and this is a single flat pass
+        for (int i = 0; i < count; i++) {
+            uint32_t n = m_counter + static_cast<uint32_t>(i);
+
+            float x = m_position.x;
+            float y = m_position.y;
+            if (d.shape == EmitterShape::CIRCLE) {
+                float r = d.shapeSize.x * std::sqrt(Random(n, STREAM_SHAPE_A));
+                float a = Random(n, STREAM_SHAPE_B) * 6.28318530718f;
+                x += r * std::cos(a);
+                y += r * std::sin(a);
+            } else if (d.shape == EmitterShape::BOX) {
+                x += (Random(n, STREAM_SHAPE_A) * 2.0f - 1.0f) * d.shapeSize.x;
+                y += (Random(n, STREAM_SHAPE_B) * 2.0f - 1.0f) * d.shapeSize.y;
+            }
+            m_positionX[i] = x;
+            m_positionY[i] = y;
+
+            float speed = d.minSpeed + Random(n, STREAM_SPEED) * speedRange;
+            float angle = minAngle + Random(n, STREAM_ANGLE) * angleRange;
+            m_velocityX[i] = std::cos(angle) * speed;
+            m_velocityY[i] = std::sin(angle) * speed;
+
+            float t = Random(n, STREAM_COLOR);
+            m_colors[i] = ColorRGBA8(LerpByte(d.minColor.r, d.maxColor.r, t),
+                LerpByte(d.minColor.g, d.maxColor.g, t),
+                LerpByte(d.minColor.b, d.maxColor.b, t),
+                LerpByte(d.minColor.a, d.maxColor.a, t));
+
+            m_widths[i] = d.minWidth + Random(n, STREAM_WIDTH) * widthRange;
+        }
+        m_counter += static_cast<uint32_t>(count);
+
+        m_batch->AddParticles(count, m_positionX.data(), m_positionY.data(),
+            m_velocityX.data(), m_velocityY.data(), m_colors.data(),
+            m_widths.data());
+    }
+}  // namespace GangerEngine
@@ -17,8 +17,18 @@
 #include <GangerEngine/ParticleEngine2D.h>
 #include <GangerEngine/ParticleBatch2D.h>
 #include <GangerEngine/SpriteBatch.h>
+#include <GangerEngine/Camera2D.h>
+
+#include <chrono>
 
 namespace GangerEngine {
+    typedef std::chrono::steady_clock Clock;
+
+    static float MillisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(Clock::now() - start)
+            .count();
+    }
+
     ParticleEngine2D::ParticleEngine2D() {
         // Empty
     }
@@ -34,17 +44,38 @@ namespace GangerEngine {
     }
 
     void ParticleEngine2D::Update(float deltaTime) {
+        // Update may run several times per frame, so the time is summed up
+        // until the next draw
+        Clock::time_point start = Clock::now();
         for (auto& b : m_batches) {
+            b->SetVisible(IsBatchInView(b));
             b->Update(deltaTime);
         }
+        m_updateMilliseconds += MillisecondsSince(start);
     }
 
     void ParticleEngine2D::Draw(SpriteBatch* spriteBatch) {
+        Clock::time_point start = Clock::now();
         for (auto& b : m_batches) {
+            if (b->GetNumActiveParticles() == 0 || !IsBatchInView(b))
+                continue;
             spriteBatch->Begin();
             b->Draw(spriteBatch);
             spriteBatch->End();
             spriteBatch->RenderBatch();
         }
+
+        // Once per frame, feed the measurements back to the budget
+        m_budget.Govern(m_batches, m_updateMilliseconds,
+            MillisecondsSince(start));
+        m_updateMilliseconds = 0.0f;
+    }
+
+    bool ParticleEngine2D::IsBatchInView(const ParticleBatch2D* batch) {
+        if (m_camera == nullptr)
+            return true;
+        glm::vec4 bounds = batch->GetBounds();
+        return m_camera->IsBoxInView(glm::vec2(bounds.x, bounds.y),
+            glm::vec2(bounds.z, bounds.w));
     }
 }  // namespace GangerEngine
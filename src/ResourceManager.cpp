@@ -15,13 +15,85 @@
 */
 
 #include <GangerEngine/ResourceManager.h>
+#include <GangerEngine/IOManager.h>
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace GangerEngine {
     TextureCache ResourceManager::m_textureCache;
+    std::vector<std::unique_ptr<AssetPackage> > ResourceManager::m_packages;
 
-    GLTexture ResourceManager::GetTexture(std::string texturePath) {
+    GLTexture ResourceManager::GetTexture(const ResourceId& texturePath) {
         return m_textureCache.GetTexture(texturePath);
     }
+
+    GLTextureRef ResourceManager::GetTextureRef(const ResourceId& texture) {
+        return m_textureCache.GetTextureRef(texture);
+    }
+
+    TextureHandle ResourceManager::AcquireTexture(
+        const ResourceId& texturePath) {
+        return m_textureCache.AcquireTexture(texturePath);
+    }
+
+    void ResourceManager::SetTextureMemoryBudget(size_t bytes) {
+        m_textureCache.SetMemoryBudget(bytes);
+    }
+
+    void ResourceManager::EvictUnusedTextures() {
+        m_textureCache.EvictUnused();
+    }
+
+    void ResourceManager::BeginTextureScope() {
+        m_textureCache.BeginScope();
+    }
+
+    void ResourceManager::PinTexture(const ResourceId& texturePath) {
+        m_textureCache.PinTexture(texturePath);
+    }
+
+    TextureCacheStats ResourceManager::GetTextureStats() {
+        return m_textureCache.GetStats();
+    }
+
+    GLTexture ResourceManager::GetTextureAsync(const ResourceId& texturePath) {
+        return m_textureCache.GetTextureAsync(texturePath);
+    }
+
+    void ResourceManager::ProcessTextureUploads() {
+        m_textureCache.ProcessUploads();
+    }
+
+    void ResourceManager::WaitForTextures(std::vector<GLTexture>& textures) {
+        m_textureCache.WaitForTextures(textures);
+    }
+
+    bool ResourceManager::IsTextureReady(const ResourceId& texturePath) {
+        return m_textureCache.IsTextureReady(texturePath);
+    }
+
+    void ResourceManager::SetTextureUploadBudget(size_t bytesPerFrame) {
+        m_textureCache.SetUploadBudget(bytesPerFrame);
+    }
+
+    void ResourceManager::SetAtlasMode(bool enabled, int pageSize,
+        int maxEntrySize) {
+        m_textureCache.SetAtlasMode(enabled, pageSize, maxEntrySize);
+    }
+
+    void ResourceManager::SetImageOptions(const ImageOptions& options) {
+        m_textureCache.SetImageOptions(options);
+    }
+
+    bool ResourceManager::MountPackage(const std::string& packagePath) {
+        auto package = std::make_unique<AssetPackage>();
+        if (!package->Open(packagePath)) return false;
+
+        IOManager::MountPackage(package.get());
+        m_packages.push_back(std::move(package));
+        return true;
+    }
 }  // namespace GangerEngine
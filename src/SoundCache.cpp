@@ -0,0 +1,303 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/SoundCache.h>
+
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/Mixer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace GangerEngine {
+    static const int ADPCM_STEPS[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37,
+        41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173,
+        190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+        724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894,
+        6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289,
+        16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+    };
+    static const int ADPCM_INDEX_STEPS[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+    // The first frame and the step indices lead the codes, so the channels
+    // start on the sound instead of ramping up to it
+    static const size_t ADPCM_HEADER_SIZE = 6;
+
+    // The IMA ADPCM state of a channel
+    struct ADPCMChannel {
+        int predictor = 0;
+        int index = 0;
+    };
+
+    // Moves a channel to the sample a code stands for
+    static int DecodeADPCM(ADPCMChannel* channel, int code) {
+        int step = ADPCM_STEPS[channel->index];
+        int delta = step >> 3;
+        if (code & 4) delta += step;
+        if (code & 2) delta += step >> 1;
+        if (code & 1) delta += step >> 2;
+        channel->predictor += (code & 8) ? -delta : delta;
+        channel->predictor = std::min(std::max(channel->predictor, -32768),
+            32767);
+        channel->index = std::min(std::max(channel->index +
+            ADPCM_INDEX_STEPS[code & 7], 0), 88);
+        return channel->predictor;
+    }
+
+    // The code closest to a sample, the channel follows what the decoder
+    // will make of it
+    static int EncodeADPCM(ADPCMChannel* channel, int sample) {
+        int step = ADPCM_STEPS[channel->index];
+        int difference = sample - channel->predictor;
+        int code = 0;
+        if (difference < 0) {
+            code = 8;
+            difference = -difference;
+        }
+        if (difference >= step) {
+            code |= 4;
+            difference -= step;
+        }
+        if (difference >= step >> 1) {
+            code |= 2;
+            difference -= step >> 1;
+        }
+        if (difference >= step >> 2) code |= 1;
+        DecodeADPCM(channel, code);
+        return code;
+    }
+
+    SoundCache::SoundCache() {
+        // Empty
+    }
+
+    SoundCache::~SoundCache() {
+        // Empty
+    }
+
+    void SoundCache::Init(Mixer* mixer /* = nullptr */) {
+        m_mixer = mixer;
+        int frequency, channels;
+        Uint16 format;
+        m_canEncode = Mix_QuerySpec(&frequency, &format, &channels) != 0 &&
+            format == AUDIO_S16SYS && channels == 2;
+    }
+
+    void SoundCache::SetBudget(size_t bytes) {
+        m_budget = bytes;
+        Trim(nullptr);
+    }
+
+    SoundData* SoundCache::Load(const std::string& filePath) {
+        // Try to find the sound in the cache
+        auto it = m_sounds.find(filePath);
+        if (it != m_sounds.end()) return &it->second;
+
+        SoundData sound;
+        if (!IOManager::ReadFileToBuffer(filePath, sound.compact)) {
+            return nullptr;
+        }
+        // Decoded once to know it is good, it may be evicted right after
+        if (!Decode(&sound)) return nullptr;
+        Compact(&sound);
+
+        SoundData& data = m_sounds[filePath];
+        data = std::move(sound);
+        data.lastPlayed = ++m_clock;
+        m_compactBytes += data.compact.size();
+        Trim(&data);
+        return &data;
+    }
+
+    bool SoundCache::Acquire(SoundData* sound) {
+        sound->lastPlayed = ++m_clock;
+        sound->numPlays++;
+        if (sound->chunk != nullptr) {
+            m_numHits++;
+            return true;
+        }
+
+        if (!Decode(sound)) {
+            printf("Mix_LoadWAV error: %s\n", Mix_GetError());
+            return false;
+        }
+        Trim(sound);
+        return true;
+    }
+
+    void SoundCache::Clear() {
+        for (auto& it : m_sounds) {
+            if (it.second.chunk != nullptr) Evict(&it.second);
+        }
+        m_sounds.clear();
+        m_compactBytes = 0;
+    }
+
+    SoundCacheStats SoundCache::GetStats() const {
+        SoundCacheStats stats;
+        stats.budget = m_budget;
+        stats.compactBytes = m_compactBytes;
+        stats.pcmBytes = m_pcmBytes;
+        stats.numSounds = static_cast<int>(m_sounds.size());
+        stats.numDecoded = m_numDecoded;
+        stats.numHits = m_numHits;
+        stats.numDecodes = m_numDecodes;
+        stats.numEvictions = m_numEvictions;
+        return stats;
+    }
+
+    void SoundCache::GetMemory(std::vector<SoundMemory>* sounds) const {
+        sounds->clear();
+        sounds->reserve(m_sounds.size());
+        for (auto& it : m_sounds) {
+            const SoundData& sound = it.second;
+            SoundMemory memory;
+            memory.filePath = it.first;
+            memory.storage = sound.storage;
+            memory.compactBytes = sound.compact.size();
+            memory.pcmBytes = sound.chunk != nullptr ? sound.chunk->alen : 0;
+            memory.numInstances = sound.numInstances;
+            memory.lastPlayed = sound.lastPlayed;
+            memory.numPlays = sound.numPlays;
+            memory.numDecodes = sound.numDecodes;
+            sounds->push_back(memory);
+        }
+    }
+
+    bool SoundCache::Decode(SoundData* sound) {
+        if (sound->storage == SoundStorage::FILE) {
+            sound->chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(
+                sound->compact.data(), static_cast<int>(sound->compact.size())),
+                1);
+            if (sound->chunk == nullptr) return false;
+        } else {
+            // Allocated the way SDL_mixer frees its own chunks
+            Mix_Chunk* chunk = static_cast<Mix_Chunk*>(
+                SDL_malloc(sizeof(Mix_Chunk)));
+            int16_t* samples = static_cast<int16_t*>(
+                SDL_malloc(4 * static_cast<size_t>(sound->numFrames)));
+            if (chunk == nullptr || samples == nullptr) {
+                SDL_free(chunk);
+                SDL_free(samples);
+                return false;
+            }
+            const unsigned char* compact = sound->compact.data();
+            ADPCMChannel left, right;
+            left.predictor = static_cast<int16_t>(compact[0] | compact[1] << 8);
+            right.predictor = static_cast<int16_t>(compact[2] |
+                compact[3] << 8);
+            left.index = compact[4];
+            right.index = compact[5];
+            for (uint32_t i = 0; i < sound->numFrames; i++) {
+                unsigned char codes = compact[ADPCM_HEADER_SIZE + i];
+                samples[2 * i] = static_cast<int16_t>(
+                    DecodeADPCM(&left, codes & 0xf));
+                samples[2 * i + 1] = static_cast<int16_t>(
+                    DecodeADPCM(&right, codes >> 4));
+            }
+            chunk->allocated = 1;
+            chunk->abuf = reinterpret_cast<Uint8*>(samples);
+            chunk->alen = 4 * sound->numFrames;
+            chunk->volume = MIX_MAX_VOLUME;
+            sound->chunk = chunk;
+        }
+
+        sound->numDecodes++;
+        m_pcmBytes += sound->chunk->alen;
+        m_numDecoded++;
+        m_numDecodes++;
+        return true;
+    }
+
+    void SoundCache::Compact(SoundData* sound) {
+        uint32_t numFrames = sound->chunk->alen / 4;
+        if (!m_canEncode || numFrames == 0 ||
+            sound->compact.size() <= ADPCM_HEADER_SIZE + numFrames) {
+            return;
+        }
+
+        std::vector<unsigned char> codes(ADPCM_HEADER_SIZE + numFrames);
+        const int16_t* samples =
+            reinterpret_cast<const int16_t*>(sound->chunk->abuf);
+        ADPCMChannel channels[2];
+        for (int channel = 0; channel < 2; channel++) {
+            int first = samples[channel];
+            // The step of the first change
+            int change = numFrames > 1 ?
+                std::abs(samples[2 + channel] - first) : 0;
+            int index = 0;
+            while (index < 88 && ADPCM_STEPS[index] < change) index++;
+            channels[channel].predictor = first;
+            channels[channel].index = index;
+            codes[2 * channel] = static_cast<unsigned char>(first & 0xff);
+            codes[2 * channel + 1] =
+                static_cast<unsigned char>((first >> 8) & 0xff);
+            codes[4 + channel] = static_cast<unsigned char>(index);
+        }
+        ADPCMChannel& left = channels[0];
+        ADPCMChannel& right = channels[1];
+        for (uint32_t i = 0; i < numFrames; i++) {
+            int leftCode = EncodeADPCM(&left, samples[2 * i]);
+            int rightCode = EncodeADPCM(&right, samples[2 * i + 1]);
+            codes[ADPCM_HEADER_SIZE + i] =
+                static_cast<unsigned char>(leftCode | rightCode << 4);
+        }
+        sound->compact.swap(codes);
+        sound->storage = SoundStorage::ADPCM;
+        sound->numFrames = numFrames;
+    }
+
+    void SoundCache::Trim(const SoundData* keep) {
+        while (m_pcmBytes > m_budget) {
+            // The least recently played of the ones not playing
+            SoundData* victim = nullptr;
+            for (auto& it : m_sounds) {
+                SoundData& sound = it.second;
+                if (&sound == keep || sound.chunk == nullptr ||
+                    sound.numInstances > 0) {
+                    continue;
+                }
+                if (victim == nullptr ||
+                    sound.lastPlayed < victim->lastPlayed) {
+                    victim = &sound;
+                }
+            }
+            // The rest is playing, it goes over until they end
+            if (victim == nullptr) return;
+            Evict(victim);
+            m_numEvictions++;
+        }
+    }
+
+    void SoundCache::Evict(SoundData* sound) {
+        // The mixer may still be on it, a stop is only queued when a voice
+        // is released
+        SDL_LockAudio();
+        if (m_mixer != nullptr) {
+            m_mixer->Drop(
+                reinterpret_cast<const int16_t*>(sound->chunk->abuf));
+        }
+        m_pcmBytes -= sound->chunk->alen;
+        m_numDecoded--;
+        Mix_FreeChunk(sound->chunk);
+        sound->chunk = nullptr;
+        SDL_UnlockAudio();
+    }
+}  // namespace GangerEngine
@@ -17,6 +17,7 @@
 #include <GangerEngine/Sprite.h>
 #include <GangerEngine/Vertex.h>
 #include <GangerEngine/ResourceManager.h>
+#include <GangerEngine/TextureAtlas.h>
 
 #include <string>
 #include <cstddef>
@@ -45,7 +46,13 @@ namespace GangerEngine {
         m_width = width;
         m_height = height;
 
-        m_texture = ResourceManager::GetTexture(texturePath);
+        m_texture = ResourceManager::GetTexture(ResourceId(texturePath));
+
+        // Atlas entries are drawn from their page with remapped uvs
+        glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
+        TextureAtlas::Resolve(&m_texture.id, &uvRect);
+        float u0 = uvRect.x, u1 = uvRect.x + uvRect.z;
+        float v0 = uvRect.y, v1 = uvRect.y + uvRect.w;
 
         // Generate the buffer if it hasn't already been generated
         if (m_vboID == 0) {
@@ -59,23 +66,23 @@ namespace GangerEngine {
 
         // First Triangle
         vertexData[0].SetPosition(x + width, y + height);
-        vertexData[0].SetUV(1.0f, 1.0f);
+        vertexData[0].SetUV(u1, v1);
 
         vertexData[1].SetPosition(x, y + height);
-        vertexData[1].SetUV(0.0f, 1.0f);
+        vertexData[1].SetUV(u0, v1);
 
         vertexData[2].SetPosition(x, y);
-        vertexData[2].SetUV(0.0f, 0.0f);
+        vertexData[2].SetUV(u0, v0);
 
         // Second Triangle
         vertexData[3].SetPosition(x, y);
-        vertexData[3].SetUV(0.0f, 0.0f);
+        vertexData[3].SetUV(u0, v0);
 
         vertexData[4].SetPosition(x + width, y);
-        vertexData[4].SetUV(1.0f, 0.0f);
+        vertexData[4].SetUV(u1, v0);
 
         vertexData[5].SetPosition(x + width, y + height);
-        vertexData[5].SetUV(1.0f, 1.0f);
+        vertexData[5].SetUV(u1, v1);
 
         // Set all vertex colors to magenta
         for (int i = 0; i < 6; i++) {
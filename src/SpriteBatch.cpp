@@ -15,6 +15,7 @@
 */
 
 #include <GangerEngine/SpriteBatch.h>
+#include <GangerEngine/TextureAtlas.h>
 
 #include <vector>
 #include <algorithm>
@@ -122,16 +123,23 @@ namespace GangerEngine {
 
         SortGlyphs();
         CreateRenderBatches();
+
+        // Atlas pages that got new entries need their mipmaps again
+        TextureAtlas::UpdateMipmaps();
     }
 
     void SpriteBatch::Draw(const glm::vec4& destRect, const glm::vec4& uvRect,
         GLuint texture, float depth, const ColorRGBA8& color) {
-        m_glyphs.emplace_back(destRect, uvRect, texture, depth, color);
+        glm::vec4 uv = uvRect;
+        TextureAtlas::Resolve(&texture, &uv);
+        m_glyphs.emplace_back(destRect, uv, texture, depth, color);
     }
 
     void SpriteBatch::Draw(const glm::vec4& destRect, const glm::vec4& uvRect,
         GLuint texture, float depth, const ColorRGBA8& color, float angle) {
-        m_glyphs.emplace_back(destRect, uvRect, texture, depth, color, angle);
+        glm::vec4 uv = uvRect;
+        TextureAtlas::Resolve(&texture, &uv);
+        m_glyphs.emplace_back(destRect, uv, texture, depth, color, angle);
     }
 
     void SpriteBatch::Draw(const glm::vec4& destRect, const glm::vec4& uvRect,
@@ -142,7 +150,9 @@ namespace GangerEngine {
         if (dir.y < 0.0f)
             angle = -angle;
 
-        m_glyphs.emplace_back(destRect, uvRect, texture, depth, color, angle);
+        glm::vec4 uv = uvRect;
+        TextureAtlas::Resolve(&texture, &uv);
+        m_glyphs.emplace_back(destRect, uv, texture, depth, color, angle);
     }
 
     void SpriteBatch::RenderBatch() {
@@ -16,6 +16,8 @@
 
 #include <GangerEngine/SpriteFont.h>
 #include <GangerEngine/SpriteBatch.h>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/MappedFile.h>
 
 #include <SDL/SDL.h>
 #include <vector>
@@ -49,7 +51,13 @@ namespace GangerEngine {
         if (!TTF_WasInit()) {
             TTF_Init();
         }
-        TTF_Font* f = TTF_OpenFont(font, size);
+        // Read through the mounts, the file outlives the font below
+        MappedFile fontFile;
+        TTF_Font* f = nullptr;
+        if (IOManager::MapFile(font, &fontFile)) {
+            f = TTF_OpenFontRW(SDL_RWFromConstMem(fontFile.GetData(),
+                static_cast<int>(fontFile.GetSize())), 1, size);
+        }
         if (f == nullptr) {
             fprintf(stderr, "Failed to open TTF font %s\n", font);
             fflush(stderr);
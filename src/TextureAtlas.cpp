@@ -0,0 +1,226 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/TextureAtlas.h>
+#include <GangerEngine/GangerErrors.h>
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+
+namespace GangerEngine {
+    const GLuint TextureAtlas::ATLAS_ID_BIT;
+    std::vector<TextureAtlas::Region> TextureAtlas::m_regions;
+    std::vector<GLuint> TextureAtlas::m_dirtyPages;
+
+    TextureAtlas::TextureAtlas() {
+        // Empty
+    }
+
+    TextureAtlas::~TextureAtlas() {
+        // Empty
+    }
+
+    void TextureAtlas::Init(int pageSize, int padding, int maxEntrySize) {
+        GLint maxTextureSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+        if (maxTextureSize > 0) pageSize = std::min(pageSize, maxTextureSize);
+
+        // Round the padding up to a power of two
+        int powerOfTwo = 1;
+        while (powerOfTwo < padding) powerOfTwo <<= 1;
+
+        m_pageSize = pageSize;
+        m_padding = powerOfTwo;
+        // Leave room for the padding and the slot alignment
+        m_maxEntrySize = std::min(maxEntrySize, pageSize - 3 * m_padding);
+    }
+
+    void TextureAtlas::Dispose() {
+        for (auto& page : m_pages) {
+            glDeleteTextures(1, &page.id);
+        }
+        m_pages.clear();
+        m_pageSize = 0;
+    }
+
+    GLTexture TextureAtlas::Add(const std::string& filePath,
+        const unsigned char* pixels, int width, int height) {
+        if (!Accepts(width, height)) {
+            FatalError("Texture " + filePath + " does not fit the atlas");
+        }
+
+        // Keep every slot aligned to the padding, then a mip texel never
+        // straddles two entries up to the last level
+        int p = m_padding;
+        int slotWidth = (width + 2 * p + p - 1) / p * p;
+        int slotHeight = (height + 2 * p + p - 1) / p * p;
+
+        int x = 0, y = 0;
+        if (m_pages.empty() ||
+            !Pack(m_pages.back(), slotWidth, slotHeight, &x, &y)) {
+            AddPage();
+            Pack(m_pages.back(), slotWidth, slotHeight, &x, &y);
+        }
+        Page& page = m_pages.back();
+
+        // Extrude the border texels into the padding
+        std::vector<unsigned char> slot(slotWidth * slotHeight * 4);
+        for (int sy = 0; sy < slotHeight; sy++) {
+            int py = std::min(std::max(sy - p, 0), height - 1);
+            for (int sx = 0; sx < slotWidth; sx++) {
+                int px = std::min(std::max(sx - p, 0), width - 1);
+                const unsigned char* src = &pixels[(py * width + px) * 4];
+                unsigned char* dst = &slot[(sy * slotWidth + sx) * 4];
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = src[3];
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, page.id);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, slotWidth, slotHeight,
+            GL_RGBA, GL_UNSIGNED_BYTE, &slot[0]);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (std::find(m_dirtyPages.begin(), m_dirtyPages.end(), page.id) ==
+            m_dirtyPages.end()) {
+            m_dirtyPages.push_back(page.id);
+        }
+
+        float size = static_cast<float>(m_pageSize);
+        Region region;
+        region.page = page.id;
+        region.rect = glm::vec4((x + p) / size, (y + p) / size,
+            width / size, height / size);
+        m_regions.push_back(region);
+
+        GLTexture texture = {};
+        texture.filePath = filePath;
+        texture.id = static_cast<GLuint>(m_regions.size() - 1) | ATLAS_ID_BIT;
+        texture.width = width;
+        texture.height = height;
+        return texture;
+    }
+
+    void TextureAtlas::UpdateMipmaps() {
+        if (m_dirtyPages.empty()) return;
+
+        for (GLuint page : m_dirtyPages) {
+            glBindTexture(GL_TEXTURE_2D, page);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_dirtyPages.clear();
+    }
+
+    void TextureAtlas::ResolveRegion(GLuint* texture, glm::vec4* uvRect) {
+        GLuint index = *texture & ~ATLAS_ID_BIT;
+        if (index >= m_regions.size()) return;
+
+        const Region& region = m_regions[index];
+        *texture = region.page;
+
+        // The shaders sample at (u, 1 - v), so v is mirrored inside the page
+        uvRect->x = region.rect.x + region.rect.z * uvRect->x;
+        uvRect->y = 1.0f - region.rect.y - region.rect.w +
+            region.rect.w * uvRect->y;
+        uvRect->z *= region.rect.z;
+        uvRect->w *= region.rect.w;
+    }
+
+    void TextureAtlas::AddPage() {
+        Page page;
+        page.skyline.push_back({ 0, 0, m_pageSize });
+
+        int maxLevel = 0;
+        while ((1 << (maxLevel + 1)) <= m_padding) maxLevel++;
+
+        glGenTextures(1, &page.id);
+        glBindTexture(GL_TEXTURE_2D, page.id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_pageSize, m_pageSize, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+            GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_pages.push_back(page);
+    }
+
+    bool TextureAtlas::Pack(Page& page, int width, int height, int* x,
+        int* y) {
+        std::vector<SkylineNode>& skyline = page.skyline;
+
+        // Bottom left rule: lowest top edge, then the narrowest node
+        int bestIndex = -1;
+        int bestTop = INT_MAX;
+        int bestWidth = INT_MAX;
+        for (size_t i = 0; i < skyline.size(); i++) {
+            int left = skyline[i].x;
+            if (left + width > m_pageSize) break;
+
+            // Rest on the highest node under the span
+            int top = 0;
+            int widthLeft = width;
+            for (size_t j = i; widthLeft > 0; j++) {
+                top = std::max(top, skyline[j].y);
+                widthLeft -= skyline[j].width;
+            }
+            if (top + height > m_pageSize) continue;
+
+            if (top + height < bestTop || (top + height == bestTop &&
+                skyline[i].width < bestWidth)) {
+                bestIndex = static_cast<int>(i);
+                bestTop = top + height;
+                bestWidth = skyline[i].width;
+            }
+        }
+        if (bestIndex < 0) return false;
+
+        *x = skyline[bestIndex].x;
+        *y = bestTop - height;
+
+        // Raise the skyline under the new entry
+        skyline.insert(skyline.begin() + bestIndex, { *x, bestTop, width });
+        for (size_t i = bestIndex + 1; i < skyline.size();) {
+            int previousRight = skyline[i - 1].x + skyline[i - 1].width;
+            if (skyline[i].x >= previousRight) break;
+
+            int shrink = previousRight - skyline[i].x;
+            skyline[i].x += shrink;
+            skyline[i].width -= shrink;
+            if (skyline[i].width > 0) break;
+            skyline.erase(skyline.begin() + i);
+        }
+
+        // Merge the neighbours left at the same height
+        for (size_t i = 0; i + 1 < skyline.size();) {
+            if (skyline[i].y == skyline[i + 1].y) {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            } else {
+                i++;
+            }
+        }
+        return true;
+    }
+}  // namespace GangerEngine
@@ -15,32 +15,605 @@
 */
 
 #include <GangerEngine/TextureCache.h>
+#include <GangerEngine/BlockCompressor.h>
 #include <GangerEngine/ImageLoader.h>
 
+#include <GangerEngine/GangerErrors.h>
+#include <GangerEngine/AssetPackage.h>
+#include <GangerEngine/IOManager.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <iostream>
+#include <utility>
 
 namespace GangerEngine {
     TextureCache::TextureCache() {
     }
 
     TextureCache::~TextureCache() {
+        // The reads hand over to the workers, which report back through
+        // m_mutex, so stop both first
+        for (auto& pending : m_pending) {
+            if (IOManager::CancelAsync(pending->readRequest)) {
+                IOManager::WaitForAsync(pending->readRequest);
+            }
+        }
+        m_workers.Dispose();
+    }
+
+    GLTexture TextureCache::GetTexture(const ResourceId& texturePath) {
+        return AcquirePlain(texturePath)->texture;
+    }
+
+    GLTextureRef TextureCache::GetTextureRef(const ResourceId& texture) {
+        TextureEntry* entry = AcquirePlain(texture);
+
+        GLTextureRef textureRef;
+        textureRef.id = entry->texture.id;
+        textureRef.width = entry->texture.width;
+        textureRef.height = entry->texture.height;
+        return textureRef;
+    }
+
+    TextureHandle TextureCache::AcquireTexture(
+        const ResourceId& texturePath) {
+        TextureHandle handle(Acquire(texturePath));
+        // The new texture may have pushed the cache over budget
+        Trim(m_memoryBudget);
+        return handle;
+    }
+
+    void TextureCache::PinTexture(const ResourceId& texturePath) {
+        Acquire(texturePath)->isPinned = true;
+    }
+
+    void TextureCache::BeginScope() {
+        m_scope++;
+    }
+
+    void TextureCache::SetMemoryBudget(size_t bytes) {
+        m_memoryBudget = bytes;
+        Trim(m_memoryBudget);
     }
 
-    GLTexture TextureCache::GetTexture(std::string texturePath) {
-        // Lookup the texture and see if its in the map
-        auto mit = m_textureMap.find(texturePath);
+    void TextureCache::EvictUnused() {
+        Trim(0);
+    }
+
+    TextureCacheStats TextureCache::GetStats() const {
+        TextureCacheStats stats = m_stats;
+        stats.residentBytes = m_residentBytes + GetAtlasBytes();
+        stats.budgetBytes = m_memoryBudget;
+        stats.numTextures = static_cast<int>(m_entries.size());
+        for (auto& entry : m_entries) {
+            if (entry.isResident) stats.numResident++;
+            if (entry.refCount > 0) stats.numReferenced++;
+        }
+        return stats;
+    }
+
+    TextureEntry* TextureCache::Acquire(const ResourceId& texturePath) {
+        TextureEntry* entry = FindEntry(texturePath);
 
         // Check if its not in the map
-        if (mit == m_textureMap.end()) {
+        if (entry == nullptr) {
             // Load the texture
-            GLTexture newTexture = ImageLoader::LoadPNG(texturePath);
+            size_t bytes;
+            GLTexture newTexture = LoadTexture(texturePath.path, &bytes);
+
+            entry = AddEntry(texturePath);
+            MakeResident(entry, newTexture, bytes);
+            m_stats.misses++;
+        } else if (!entry->isResident) {
+            // It was evicted, bring it back behind the same entry
+            size_t bytes;
+            GLTexture texture = LoadTexture(entry->texture.filePath, &bytes);
+            MakeResident(entry, texture, bytes);
+            m_stats.misses++;
+            m_stats.reloads++;
+        } else {
+            m_stats.hits++;
+
+            // An async load of it is in flight, finish it now
+            if (entry->isPending) {
+                for (size_t i = 0; i < m_pending.size(); i++) {
+                    if (m_pending[i]->filePath == entry->texture.filePath) {
+                        FinishPending(i);
+                        break;
+                    }
+                }
+            }
+        }
+
+        entry->lastUse = ++m_useCounter;
+        return entry;
+    }
+
+    TextureEntry* TextureCache::AcquirePlain(const ResourceId& texturePath) {
+        uint64_t misses = m_stats.misses;
+        TextureEntry* entry = Acquire(texturePath);
+        // Nobody will tell when a plain copy is gone, so it is kept for the
+        // rest of the scope
+        entry->scope = m_scope;
+        if (m_stats.misses != misses) Trim(m_memoryBudget);
+        return entry;
+    }
+
+    TextureEntry* TextureCache::FindEntry(const ResourceId& texturePath) {
+        TextureEntry** entry = m_entryMap.Find(texturePath.hash);
+        if (entry == nullptr) return nullptr;
+
+        // Two paths with the same 64 bit hash are unlikely, but would
+        // silently swap textures
+        if (strcmp((*entry)->texture.filePath.c_str(), texturePath.path)) {
+            FatalError("Texture " + std::string(texturePath.path) +
+                " has the same id as " + (*entry)->texture.filePath);
+        }
+        return *entry;
+    }
 
-            // Insert it into the map
-            m_textureMap.insert(make_pair(texturePath, newTexture));
+    TextureEntry* TextureCache::AddEntry(const ResourceId& texturePath) {
+        m_entries.push_back(TextureEntry());
+        TextureEntry* entry = &m_entries.back();
+        entry->cache = this;
+        entry->texture.filePath = texturePath.path;
+        m_entryMap.Insert(texturePath.hash, entry);
+        return entry;
+    }
+
+    void TextureCache::Release(TextureEntry* entry) {
+        // The entry stays resident and is kept as long as the budget allows,
+        // the last to be released being the last to go
+        entry->lastUse = ++m_useCounter;
+        if (m_residentBytes + GetAtlasBytes() > m_memoryBudget) {
+            Trim(m_memoryBudget);
+        }
+    }
+
+    void TextureCache::Trim(size_t budget) {
+        size_t atlasBytes = GetAtlasBytes();
+        while (m_residentBytes + atlasBytes > budget) {
+            // Least recently used among the ones nobody holds
+            TextureEntry* victim = nullptr;
+            for (auto& entry : m_entries) {
+                if (!entry.isResident || entry.isPinned ||
+                    entry.isPending || entry.refCount > 0 ||
+                    entry.scope == m_scope) {
+                    continue;
+                }
+                if (victim == nullptr || entry.lastUse < victim->lastUse) {
+                    victim = &entry;
+                }
+            }
+            if (victim == nullptr) break;
+
+            Evict(victim);
+        }
+    }
 
-            return newTexture;
+    void TextureCache::Evict(TextureEntry* entry) {
+        glDeleteTextures(1, &(entry->texture.id));
+        entry->texture.id = 0;
+        entry->isResident = false;
+        m_residentBytes -= entry->bytes;
+        entry->bytes = 0;
+        m_stats.evictions++;
+    }
+
+    void TextureCache::MakeResident(TextureEntry* entry,
+        const GLTexture& texture, size_t bytes) {
+        // Async entries get their size once the upload is done
+        if (entry->isResident) m_residentBytes -= entry->bytes;
+        entry->texture = texture;
+        entry->isResident = true;
+
+        // Atlas entries live in a shared page, they are never evicted
+        if (texture.id & TextureAtlas::ATLAS_ID_BIT) {
+            entry->isPinned = true;
+            entry->bytes = 0;
+            return;
         }
-        return mit->second;
+
+        entry->bytes = bytes;
+        m_residentBytes += bytes;
+    }
+
+    size_t TextureCache::GetAtlasBytes() const {
+        size_t pageSize = static_cast<size_t>(m_atlas.GetPageSize());
+        size_t pageBytes = pageSize * pageSize * 4;
+        return m_atlas.GetNumPages() * (pageBytes + pageBytes / 3);
+    }
+
+    ImageOptions TextureCache::GetImageOptions() const {
+        ImageOptions options = m_imageOptions;
+        // Without a swizzle R8 would read back red
+        options.useMaskFormat = options.useMaskFormat &&
+            ImageLoader::HasTextureSwizzle();
+        options.useBlockCompression = options.useBlockCompression &&
+            ImageLoader::HasBlockCompression();
+        return options;
+    }
+
+    void TextureCache::SetAtlasMode(bool enabled, int pageSize,
+        int maxEntrySize) {
+        if (enabled && m_atlas.GetNumPages() == 0) {
+            m_atlas.Init(pageSize, 4, maxEntrySize);
+        }
+        m_isAtlasEnabled = enabled;
+    }
+
+    GLTexture TextureCache::GetTextureAsync(const ResourceId& texturePath) {
+        TextureEntry* entry = FindEntry(texturePath);
+        if (entry != nullptr && entry->isResident) {
+            entry->scope = m_scope;
+            entry->lastUse = ++m_useCounter;
+            m_stats.hits++;
+            return entry->texture;
+        }
+
+        m_workers.Init();
+
+        auto pending = std::make_shared<PendingTexture>();
+        pending->filePath = texturePath.path;
+        pending->options = GetImageOptions();
+
+        // The placeholder owns the id the real pixels will land on
+        static const unsigned char PLACEHOLDER[4] = { 0, 0, 0, 0 };
+        glGenTextures(1, &(pending->id));
+        glBindTexture(GL_TEXTURE_2D, pending->id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, PLACEHOLDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        GLTexture texture = {};
+        texture.filePath = pending->filePath;
+        texture.id = pending->id;
+        texture.width = 0;
+        texture.height = 0;
+
+        // Async textures are handed out as plain copies too
+        if (entry == nullptr) entry = AddEntry(texturePath);
+        entry->scope = m_scope;
+        entry->isPending = true;
+        entry->lastUse = ++m_useCounter;
+        MakeResident(entry, texture, 0);
+        m_stats.misses++;
+        m_pending.push_back(pending);
+
+        const AssetPackage* package;
+        const PackageEntry* packageEntry = IOManager::FindPackageEntry(
+            pending->filePath, &package);
+        if (packageEntry != nullptr &&
+            packageEntry->type == static_cast<uint32_t>(AssetType::TEXTURE)) {
+            m_workers.Enqueue([this, pending, package, packageEntry] {
+                ProcessedImage image;
+                bool isDecoded = ReadPackagedImage(*package, *packageEntry,
+                    pending->options, &image);
+                SetDecoded(pending.get(), &image, isDecoded);
+            });
+            return texture;
+        }
+
+        // The file is read on the async I/O, so many loads keep the disk
+        // busy while the workers decode what already arrived
+        IORequest request;
+        request.filePath = pending->filePath;
+        request.isImmediate = true;
+        request.callback = [this, pending] (IOResult& result) {
+            if (result.status != IOStatus::OK) {
+                SetDecoded(pending.get(), nullptr, false);
+                return;
+            }
+
+            auto file = std::make_shared<std::vector<unsigned char> >(
+                std::move(result.data));
+            m_workers.Enqueue([this, pending, file] {
+                // The mips and the conversion are done here too, the other
+                // workers are busy with the other pending textures
+                ProcessedImage image;
+                std::vector<unsigned char> pixels;
+                int width = 0, height = 0;
+                bool isDecoded = !file->empty() &&
+                    ImageLoader::DecodePNGMemory(pending->filePath,
+                    &(*file)[0], file->size(), pixels, width, height);
+                if (isDecoded) {
+                    ImageProcessor::Process(&pixels[0], width, height,
+                        pending->options, &image);
+                }
+                SetDecoded(pending.get(), &image, isDecoded);
+            });
+        };
+        pending->readRequest = IOManager::SubmitAsync(std::move(request));
+
+        return texture;
+    }
+
+    void TextureCache::ProcessUploads() {
+        size_t budget = m_uploadBudget;
+
+        for (size_t i = 0; i < m_pending.size();) {
+            PendingTexture& pending = *m_pending[i];
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!pending.isDecoded) {
+                    i++;
+                    continue;
+                }
+            }
+
+            size_t sentBytes = 0;
+            bool isDone = Upload(pending, budget, &sentBytes);
+            budget -= std::min(budget, sentBytes);
+
+            if (isDone) {
+                m_pending.erase(m_pending.begin() + i);
+            } else {
+                i++;
+            }
+            if (budget == 0) break;
+        }
+    }
+
+    void TextureCache::WaitForTextures(std::vector<GLTexture>& textures) {
+        for (auto& texture : textures) {
+            for (size_t i = 0; i < m_pending.size(); i++) {
+                if (m_pending[i]->filePath == texture.filePath) {
+                    FinishPending(i);
+                    break;
+                }
+            }
+
+            TextureEntry* entry = FindEntry(ResourceId(texture.filePath));
+            if (entry != nullptr) texture = entry->texture;
+        }
+    }
+
+    bool TextureCache::IsTextureReady(const ResourceId& texturePath) {
+        TextureEntry* entry = FindEntry(texturePath);
+        return entry != nullptr && entry->isResident && !entry->isPending;
+    }
+
+    GLTexture TextureCache::LoadTexture(const std::string& texturePath,
+        size_t* bytes) {
+        *bytes = 0;
+
+        ImageOptions options = GetImageOptions();
+        ProcessedImage image;
+
+        // Cooked textures skip the png decoding and come with their mips
+        const AssetPackage* package;
+        const PackageEntry* entry = IOManager::FindPackageEntry(texturePath,
+            &package);
+        if (entry != nullptr &&
+            entry->type == static_cast<uint32_t>(AssetType::TEXTURE)) {
+            if (!ReadPackagedImage(*package, *entry, options, &image)) {
+                FatalError("Texture " + texturePath + " is corrupt in " +
+                    package->GetFilePath());
+            }
+
+            if (m_isAtlasEnabled && m_atlas.Accepts(image.width,
+                image.height)) {
+                // The pages are RGBA8, only the first level is needed
+                std::vector<unsigned char> pixels(static_cast<size_t>(
+                    image.width) * image.height * 4);
+                if (ImageProcessor::IsBlockCompressed(image.format)) {
+                    BlockCompressor::Decompress(&image.data[0], image.width,
+                        image.height, image.format, &pixels[0]);
+                } else {
+                    memcpy(&pixels[0], &image.data[0], pixels.size());
+                }
+                return m_atlas.Add(texturePath, &pixels[0], image.width,
+                    image.height);
+            }
+
+            *bytes = GetImageBytes(image);
+            return ImageLoader::UploadImage(texturePath, image);
+        }
+
+        std::vector<unsigned char> pixels;
+        int width, height;
+        if (!ImageLoader::DecodePNGFile(texturePath, pixels, width, height)) {
+            FatalError("Failed to load PNG file " + texturePath);
+        }
+
+        if (m_isAtlasEnabled && m_atlas.Accepts(width, height)) {
+            // The pages are shared RGBA8 and build their own mipmaps
+            if (options.premultiplyAlpha) {
+                ImageProcessor::PremultiplyAlpha(&pixels[0],
+                    static_cast<size_t>(width) * height);
+            }
+            return m_atlas.Add(texturePath, &pixels[0], width, height);
+        }
+
+        m_workers.Init();
+        ImageProcessor::Process(&pixels[0], width, height, options, &image,
+            &m_workers);
+        *bytes = GetImageBytes(image);
+        return ImageLoader::UploadImage(texturePath, image);
+    }
+
+    bool TextureCache::ReadPackagedImage(const AssetPackage& package,
+        const PackageEntry& entry, const ImageOptions& options,
+        ProcessedImage* image) {
+        image->width = static_cast<int>(entry.width);
+        image->height = static_cast<int>(entry.height);
+        image->numMips = static_cast<int>(entry.numMips);
+        image->isAlphaMask = false;
+        image->isPremultiplied = false;
+        image->format = PixelFormat::RGBA8;
+        if (entry.flags & ASSET_FLAG_BC1) image->format = PixelFormat::BC1;
+        if (entry.flags & ASSET_FLAG_BC3) image->format = PixelFormat::BC3;
+
+        if (entry.flags & ASSET_FLAG_COMPRESSED) {
+            if (!package.Read(entry, image->data)) return false;
+        } else {
+            const unsigned char* payload = package.GetPayload(entry);
+            image->data.assign(payload, payload + entry.size);
+        }
+
+        image->levelOffsets.clear();
+        size_t offset = 0;
+        int levelWidth = image->width;
+        int levelHeight = image->height;
+        for (int level = 0; level < image->numMips; level++) {
+            image->levelOffsets.push_back(offset);
+            offset += ImageProcessor::GetLevelSize(image->format, levelWidth,
+                levelHeight);
+            levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+            levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+        }
+
+        // BC1 drops transparent texels to black, so it is premultiplied
+        // already. BC3 can not be premultiplied in place.
+        bool needsPixels = !options.useBlockCompression ||
+            (options.premultiplyAlpha && image->format == PixelFormat::BC3);
+        if (ImageProcessor::IsBlockCompressed(image->format)) {
+            if (!needsPixels) {
+                image->isPremultiplied = options.premultiplyAlpha;
+                return true;
+            }
+
+            std::vector<unsigned char> levels(static_cast<size_t>(
+                AssetPackage::GetMipChainSize(entry.width, entry.height,
+                entry.numMips)));
+            size_t levelOffset = 0;
+            levelWidth = image->width;
+            levelHeight = image->height;
+            for (int level = 0; level < image->numMips; level++) {
+                BlockCompressor::Decompress(
+                    &image->data[image->levelOffsets[level]], levelWidth,
+                    levelHeight, image->format, &levels[levelOffset]);
+                image->levelOffsets[level] = levelOffset;
+                levelOffset += static_cast<size_t>(levelWidth) *
+                    levelHeight * 4;
+                levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+                levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+            }
+            image->data = std::move(levels);
+            image->format = PixelFormat::RGBA8;
+        }
+
+        // A single cooked level gets its chain like a png would
+        if (image->numMips == 1 && options.generateMips) {
+            std::vector<unsigned char> pixels = std::move(image->data);
+            ImageProcessor::Process(&pixels[0], image->width, image->height,
+                options, image);
+            return true;
+        }
+
+        if (options.premultiplyAlpha) {
+            ImageProcessor::PremultiplyAlpha(&image->data[0],
+                image->data.size() / 4);
+            image->isPremultiplied = true;
+        }
+        return true;
+    }
+
+    size_t TextureCache::GetImageBytes(const ProcessedImage& image) {
+        size_t bytes = image.data.size();
+        // Plus a third for the mipmaps the GPU builds
+        if (image.numMips <= 1 &&
+            !ImageProcessor::IsBlockCompressed(image.format)) {
+            bytes += bytes / 3;
+        }
+        return bytes;
+    }
+
+    void TextureCache::SetDecoded(PendingTexture* pending,
+        ProcessedImage* image, bool isDecoded) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (isDecoded) pending->image = std::move(*image);
+        pending->isDecoded = true;
+        pending->isFailed = !isDecoded;
+        m_decodedCondition.notify_all();
+    }
+
+    bool TextureCache::WaitDecoded(PendingTexture& pending) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_decodedCondition.wait(lock, [&pending] {
+            return pending.isDecoded;
+        });
+        return !pending.isFailed;
+    }
+
+    bool TextureCache::Upload(PendingTexture& pending, size_t maxBytes,
+        size_t* sentBytes) {
+        *sentBytes = 0;
+        if (!WaitDecoded(pending)) {
+            // Only the load that asked to block may stop the game, this one
+            // keeps its placeholder and reports done
+            printf("Failed to load texture %s\n", pending.filePath.c_str());
+            TextureEntry* entry = FindEntry(ResourceId(pending.filePath));
+            entry->isPending = false;
+            entry->isFailed = true;
+            m_stats.failures++;
+            return true;
+        }
+
+        const ProcessedImage& image = pending.image;
+        // A row of blocks for compressed formats
+        size_t rowBytes = ImageProcessor::GetLevelSize(image.format,
+            image.width, 1);
+        size_t totalBytes = image.data.size();
+
+        // The rows are staged in an unpack buffer so the placeholder stays
+        // on screen until the whole image is on the GPU
+        if (pending.pixelBuffer == 0) {
+            glGenBuffers(1, &(pending.pixelBuffer));
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pending.pixelBuffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr,
+                GL_STREAM_DRAW);
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pending.pixelBuffer);
+        }
+
+        // Multiples of a first level row, and at least one so every texture
+        // moves forward. The mip chain follows the first level, so the tail
+        // is not a whole row and must not be read past
+        size_t numBytes = totalBytes - pending.uploadedBytes;
+        if (numBytes > maxBytes) {
+            numBytes = std::min(std::max(rowBytes, maxBytes -
+                maxBytes % rowBytes), totalBytes - pending.uploadedBytes);
+        }
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, pending.uploadedBytes,
+            numBytes, &(image.data[pending.uploadedBytes]));
+        pending.uploadedBytes += numBytes;
+        *sentBytes = numBytes;
+
+        if (pending.uploadedBytes < totalBytes) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+
+        // Everything is staged, swap the placeholder for the real image
+        glBindTexture(GL_TEXTURE_2D, pending.id);
+        ImageLoader::UploadLevels(image, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glDeleteBuffers(1, &(pending.pixelBuffer));
+        pending.pixelBuffer = 0;
+
+        TextureEntry* entry = FindEntry(ResourceId(pending.filePath));
+        GLTexture texture = entry->texture;
+        texture.width = image.width;
+        texture.height = image.height;
+        entry->isPending = false;
+        MakeResident(entry, texture, GetImageBytes(image));
+        std::vector<unsigned char>().swap(pending.image.data);
+        return true;
+    }
+
+    void TextureCache::FinishPending(size_t index) {
+        std::shared_ptr<PendingTexture> pending = m_pending[index];
+        m_pending.erase(m_pending.begin() + index);
+
+        size_t sentBytes;
+        Upload(*pending, static_cast<size_t>(-1), &sentBytes);
     }
 }  // namespace GangerEngine
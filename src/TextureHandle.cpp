@@ -0,0 +1,67 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/TextureHandle.h>
+#include <GangerEngine/TextureCache.h>
+
+namespace GangerEngine {
+    TextureHandle::TextureHandle(TextureEntry* entry) : m_entry(entry) {
+        if (m_entry) m_entry->refCount++;
+    }
+
+    TextureHandle::TextureHandle(const TextureHandle& other) :
+        m_entry(other.m_entry) {
+        if (m_entry) m_entry->refCount++;
+    }
+
+    TextureHandle::TextureHandle(TextureHandle&& other) :
+        m_entry(other.m_entry) {
+        other.m_entry = nullptr;
+    }
+
+    TextureHandle::~TextureHandle() {
+        Reset();
+    }
+
+    TextureHandle& TextureHandle::operator=(const TextureHandle& other) {
+        if (other.m_entry) other.m_entry->refCount++;
+        Reset();
+        m_entry = other.m_entry;
+        return *this;
+    }
+
+    TextureHandle& TextureHandle::operator=(TextureHandle&& other) {
+        if (this != &other) {
+            Reset();
+            m_entry = other.m_entry;
+            other.m_entry = nullptr;
+        }
+        return *this;
+    }
+
+    const GLTexture& TextureHandle::GetTexture() const {
+        static const GLTexture empty = GLTexture();
+        return m_entry != nullptr ? m_entry->texture : empty;
+    }
+
+    void TextureHandle::Reset() {
+        if (m_entry == nullptr) return;
+
+        TextureEntry* entry = m_entry;
+        m_entry = nullptr;
+        if (--entry->refCount == 0) entry->cache->Release(entry);
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,173 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace GangerEngine {
+    // The state a ParallelFor shares with its helper jobs
+    struct ParallelForBatch {
+        const std::function<void(size_t, size_t)>* function;
+        size_t count;
+        size_t grain;
+        size_t numChunks;
+        std::atomic<size_t> nextChunk;
+        std::mutex mutex;
+        std::condition_variable doneCondition;
+        size_t numDone = 0;
+    };
+
+    static void RunChunks(ParallelForBatch* batch) {
+        size_t numRun = 0;
+        for (;;) {
+            // Helpers that start late find nothing left and never touch
+            // the function, which may be gone by then
+            size_t chunk = batch->nextChunk++;
+            if (chunk >= batch->numChunks) break;
+
+            size_t begin = chunk * batch->grain;
+            size_t end = std::min(begin + batch->grain, batch->count);
+            (*batch->function)(begin, end);
+            numRun++;
+        }
+        if (numRun == 0) return;
+
+        std::lock_guard<std::mutex> lock(batch->mutex);
+        batch->numDone += numRun;
+        if (batch->numDone == batch->numChunks) {
+            batch->doneCondition.notify_all();
+        }
+    }
+
+    ThreadPool::ThreadPool() {
+        // Empty
+    }
+
+    ThreadPool::~ThreadPool() {
+        Dispose();
+    }
+
+    void ThreadPool::Init(unsigned int numThreads) {
+        if (IsRunning()) return;
+
+        if (numThreads == 0) {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        m_isStopping = false;
+        m_workers.reserve(numThreads);
+        for (unsigned int i = 0; i < numThreads; i++) {
+            m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    void ThreadPool::Dispose() {
+        if (!IsRunning()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_jobCondition.notify_all();
+
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    void ThreadPool::Enqueue(std::function<void()> job) {
+        // Without workers the job still has to happen
+        if (!IsRunning()) {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobCondition.notify_one();
+    }
+
+    void ThreadPool::WaitIdle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idleCondition.wait(lock, [this] {
+            return m_jobs.empty() && m_numBusy == 0;
+        });
+    }
+
+    void ThreadPool::ParallelFor(size_t count, size_t grain,
+        const std::function<void(size_t, size_t)>& function) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+
+        size_t numChunks = (count + grain - 1) / grain;
+        if (numChunks == 1 || !IsRunning()) {
+            function(0, count);
+            return;
+        }
+
+        auto batch = std::make_shared<ParallelForBatch>();
+        batch->function = &function;
+        batch->count = count;
+        batch->grain = grain;
+        batch->numChunks = numChunks;
+        batch->nextChunk = 0;
+
+        size_t numHelpers = std::min<size_t>(GetNumThreads(), numChunks - 1);
+        for (size_t i = 0; i < numHelpers; i++) {
+            Enqueue([batch] {
+                RunChunks(batch.get());
+            });
+        }
+        RunChunks(batch.get());
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->doneCondition.wait(lock, [&batch] {
+            return batch->numDone == batch->numChunks;
+        });
+    }
+
+    void ThreadPool::WorkerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_jobCondition.wait(lock, [this] {
+                return m_isStopping || !m_jobs.empty();
+            });
+            // Drain what is queued before leaving
+            if (m_jobs.empty()) return;
+
+            std::function<void()> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_numBusy++;
+
+            lock.unlock();
+            job();
+            lock.lock();
+
+            m_numBusy--;
+            if (m_jobs.empty() && m_numBusy == 0) {
+                m_idleCondition.notify_all();
+            }
+        }
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,286 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <GangerEngine/VoiceManager.h>
+
+#include <algorithm>
+
+namespace GangerEngine {
+    VoiceManager::VoiceManager() {
+        // Empty
+    }
+
+    VoiceManager::~VoiceManager() {
+        // Empty
+    }
+
+    void VoiceManager::Init(int numVoices, Mixer* mixer /* = nullptr */) {
+        m_voices.assign(numVoices, Voice());
+        m_mixer = mixer;
+        if (m_mixer == nullptr) Mix_AllocateChannels(numVoices);
+        m_stats = VoiceStats();
+        m_stats.numVoices = numVoices;
+    }
+
+    void VoiceManager::Dispose() {
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            if (m_voices[i].sound != nullptr) {
+                Halt(static_cast<int>(i));
+                Release(static_cast<int>(i));
+            }
+        }
+        m_voices.clear();
+        m_mixer = nullptr;
+        m_stats.numVoices = 0;
+    }
+
+    int VoiceManager::Play(SoundData* sound, int loops, float volume,
+        const glm::vec2* position /* = nullptr */) {
+        float gain = std::min(std::max(volume, 0.0f), 1.0f);
+        volume = gain;
+        if (position != nullptr) {
+            volume *= Mixer::GetAttenuation(glm::length(*position -
+                m_listener), m_minDistance, m_maxDistance);
+        }
+        Refresh();
+
+        // Already started this frame, the copies would only add up to a
+        // louder and phasier version of it
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            Voice& voice = m_voices[i];
+            if (voice.sound != sound || voice.loops != loops ||
+                voice.frame != m_frame || voice.isStopping ||
+                voice.isPositional != (position != nullptr) ||
+                (position != nullptr && voice.position != *position)) {
+                continue;
+            }
+            if (gain > voice.gain) {
+                // Kept as the mixer has it when the queue is full
+                bool isSet = true;
+                if (m_mixer != nullptr) {
+                    isSet = m_mixer->SetGain(static_cast<int>(i), gain);
+                } else {
+                    Mix_Volume(static_cast<int>(i),
+                        static_cast<int>(volume * MIX_MAX_VOLUME));
+                }
+                if (isSet) {
+                    voice.gain = gain;
+                    voice.volume = volume;
+                }
+            }
+            m_stats.numMerged++;
+            return static_cast<int>(i);
+        }
+
+        int voice = -1;
+        if (sound->maxInstances > 0 &&
+            sound->numInstances >= sound->maxInstances) {
+            voice = FindVictim(sound);
+        } else {
+            for (size_t i = 0; i < m_voices.size(); i++) {
+                if (m_voices[i].sound == nullptr) {
+                    voice = static_cast<int>(i);
+                    break;
+                }
+            }
+            if (voice == -1) voice = FindVictim(nullptr);
+        }
+
+        if (voice == -1) {
+            m_stats.numRejected++;
+            return -1;
+        }
+
+        if (m_voices[voice].sound != nullptr) {
+            const Voice& victim = m_voices[voice];
+            bool isWeaker = victim.sound->priority < sound->priority ||
+                (victim.sound->priority == sound->priority &&
+                victim.volume <= volume);
+            // The play would not fit in the full queue either
+            if (!isWeaker || !Halt(voice)) {
+                m_stats.numRejected++;
+                return -1;
+            }
+            Release(voice);
+            m_stats.numStolen++;
+        }
+
+        if (!Start(voice, sound, loops, gain, volume, position)) {
+            m_stats.numRejected++;
+            return -1;
+        }
+        return voice;
+    }
+
+    void VoiceManager::Stop(const SoundData* sound) {
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            if (m_voices[i].sound != sound) continue;
+            if (Halt(static_cast<int>(i))) {
+                Release(static_cast<int>(i));
+            } else {
+                m_voices[i].isStopping = true;
+            }
+        }
+    }
+
+    void VoiceManager::SetListener(const glm::vec2& position,
+        float minDistance, float maxDistance) {
+        m_listener = position;
+        m_minDistance = minDistance;
+        m_maxDistance = maxDistance;
+        if (m_mixer != nullptr) {
+            m_isListenerPending = !m_mixer->SetListener(position, minDistance,
+                maxDistance);
+        }
+    }
+
+    void VoiceManager::Update() {
+        Refresh();
+        m_frame++;
+    }
+
+    VoiceStats VoiceManager::GetStats() {
+        Refresh();
+        return m_stats;
+    }
+
+    void VoiceManager::ResetStats() {
+        VoiceStats stats;
+        stats.numVoices = m_stats.numVoices;
+        stats.numActive = m_stats.numActive;
+        stats.peakActive = m_stats.numActive;
+        m_stats = stats;
+    }
+
+    void VoiceManager::Refresh() {
+        if (m_mixer != nullptr) {
+            // Retry what did not fit in the queue
+            if (m_isListenerPending) {
+                m_isListenerPending = !m_mixer->SetListener(m_listener,
+                    m_minDistance, m_maxDistance);
+            }
+            for (size_t i = 0; i < m_voices.size(); i++) {
+                if (m_voices[i].isStopping &&
+                    m_mixer->Stop(static_cast<int>(i))) {
+                    Release(static_cast<int>(i));
+                }
+            }
+
+            int voice;
+            uint32_t serial;
+            while (m_mixer->PopFinished(&voice, &serial)) {
+                // Or it ended after being stolen
+                if (m_voices[voice].sound != nullptr &&
+                    m_voices[voice].serial == serial) {
+                    Release(voice);
+                }
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            if (m_voices[i].sound != nullptr &&
+                !Mix_Playing(static_cast<int>(i))) {
+                Release(static_cast<int>(i));
+            }
+        }
+    }
+
+    int VoiceManager::FindVictim(const SoundData* sound) const {
+        int victim = -1;
+        for (size_t i = 0; i < m_voices.size(); i++) {
+            const Voice& voice = m_voices[i];
+            if (voice.sound == nullptr ||
+                (sound != nullptr && voice.sound != sound)) {
+                continue;
+            }
+            if (victim == -1) {
+                victim = static_cast<int>(i);
+                continue;
+            }
+
+            const Voice& best = m_voices[victim];
+            if (voice.sound->priority != best.sound->priority) {
+                if (voice.sound->priority < best.sound->priority) {
+                    victim = static_cast<int>(i);
+                }
+            } else if (voice.volume != best.volume) {
+                if (voice.volume < best.volume) victim = static_cast<int>(i);
+            } else if (voice.order < best.order) {
+                victim = static_cast<int>(i);
+            }
+        }
+        return victim;
+    }
+
+    bool VoiceManager::Start(int voice, SoundData* sound, int loops,
+        float gain, float volume, const glm::vec2* position) {
+        Voice& slot = m_voices[voice];
+        uint32_t serial = slot.serial + 1;
+
+        if (m_mixer != nullptr) {
+            const int16_t* samples =
+                reinterpret_cast<const int16_t*>(sound->chunk->abuf);
+            uint32_t numFrames = sound->chunk->alen / 4;
+            bool isQueued = position != nullptr ?
+                m_mixer->PlayAt(voice, serial, samples, numFrames, loops,
+                gain, *position) :
+                m_mixer->Play(voice, serial, samples, numFrames, loops, gain);
+            if (!isQueued) return false;
+        } else {
+            // SDL_mixer pans once, when the sound starts
+            float pan = position != nullptr ?
+                Mixer::GetPan(*position - m_listener, m_minDistance) : 0.0f;
+            Mix_SetPanning(voice,
+                static_cast<Uint8>(255 * std::min(1.0f, 1.0f - pan)),
+                static_cast<Uint8>(255 * std::min(1.0f, 1.0f + pan)));
+            Mix_Volume(voice, static_cast<int>(volume * MIX_MAX_VOLUME));
+            if (Mix_PlayChannel(voice, sound->chunk, loops) == -1) {
+                return false;
+            }
+        }
+
+        slot.sound = sound;
+        slot.loops = loops;
+        slot.gain = gain;
+        slot.volume = volume;
+        slot.isPositional = position != nullptr;
+        if (position != nullptr) slot.position = *position;
+        slot.serial = serial;
+        slot.order = m_order++;
+        slot.frame = m_frame;
+        sound->numInstances++;
+
+        m_stats.numPlayed++;
+        m_stats.numActive++;
+        m_stats.peakActive = std::max(m_stats.peakActive, m_stats.numActive);
+        return true;
+    }
+
+    bool VoiceManager::Halt(int voice) {
+        if (m_mixer != nullptr) return m_mixer->Stop(voice);
+        Mix_HaltChannel(voice);
+        return true;
+    }
+
+    void VoiceManager::Release(int voice) {
+        Voice& slot = m_voices[voice];
+        slot.sound->numInstances--;
+        slot.sound = nullptr;
+        slot.isStopping = false;
+        m_stats.numActive--;
+    }
+}  // namespace GangerEngine
@@ -0,0 +1,308 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Cooks game assets offline into a package the engine maps at startup:
+//
+//   AssetCooker -o Assets.gpak -root Demos/ZombieGame [-mips] [-compress]
+//       [-format <format>[:<prefix>]]... [-report]
+//       [-cache <dir>] [-nocache] [-j <threads>]
+//       Demos/ZombieGame/Textures Demos/ZombieGame/Shaders ...
+//
+// Inputs can be files or directories, which are walked recursively. The
+// paths stored are relative to -root, the way the game asks for them.
+// Textures are stored as rgba8, bc1, bc3 or auto, which picks bc1 for the
+// opaque ones. A -format with a prefix only applies to the assets under it,
+// e.g. "-format auto -format rgba8:Textures/Fonts/", and -report prints the
+// size and quality of every texture.
+// Files are cooked in parallel and each result is kept in a content
+// addressed cache (<package>.cache by default), so a re-cook only redoes
+// the sources whose bytes, dependencies or options changed.
+
+#include "Cook.h"
+#include "CookCache.h"
+#include "PackageWriter.h"
+
+#include <GangerEngine/AssetPackage.h>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/ThreadPool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+static bool IsDirectory(const std::string& path) {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES &&
+        (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat pathStat;
+    return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+#endif
+}
+
+static void ListFiles(const std::string& path,
+    std::vector<std::string>* files) {
+    if (!IsDirectory(path)) {
+        files->push_back(path);
+        return;
+    }
+
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA((path + "/*").c_str(), &findData);
+    if (find == INVALID_HANDLE_VALUE) return;
+    do {
+        names.push_back(findData.cFileName);
+    } while (FindNextFileA(find, &findData));
+    FindClose(find);
+#else
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return;
+    while (dirent* entry = readdir(dir)) {
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif
+
+    for (auto& name : names) {
+        // Skip ., .. and hidden files
+        if (name.empty() || name[0] == '.') continue;
+        ListFiles(path + "/" + name, files);
+    }
+}
+
+static std::string MakeAssetPath(const std::string& filePath,
+    const std::string& root) {
+    std::string path = GangerEngine::AssetPackage::NormalizePath(filePath);
+    if (root.empty()) return path;
+
+    std::string prefix = GangerEngine::AssetPackage::NormalizePath(root);
+    if (prefix.back() != '/') prefix.push_back('/');
+    if (path.compare(0, prefix.size(), prefix) == 0) {
+        path.erase(0, prefix.size());
+    }
+    return path;
+}
+
+static void PrintUsage() {
+    printf("Usage: AssetCooker -o <package> [-root <dir>] [-mips] "
+        "[-compress] [-format <rgba8|bc1|bc3|auto>[:<prefix>]] [-report] "
+        "[-cache <dir>] [-nocache] [-j <threads>] <file or directory>...\n");
+}
+
+// The outcome of one source
+struct CookJob {
+    std::string sourcePath;
+    std::string assetPath;
+    CookedAsset asset;
+    bool isCooked = false;
+    bool isCacheHit = false;
+};
+
+static void RunJob(CookJob* job, const CookOptions& options,
+    CookCache* cache, GangerEngine::ThreadPool* workers) {
+    std::vector<unsigned char> source;
+    if (!GangerEngine::IOManager::ReadFileToBuffer(job->sourcePath, source)) {
+        return;
+    }
+
+    uint64_t key = 0;
+    if (cache != nullptr) {
+        std::vector<std::string> dependencies;
+        ScanDependencies(job->sourcePath, source, &dependencies);
+        key = CookCache::ComputeKey(source, dependencies, options,
+            GetTextureFormat(options, job->assetPath));
+
+        if (cache->Load(key, &job->asset)) {
+            job->asset.path = job->assetPath;
+            job->isCooked = true;
+            job->isCacheHit = true;
+            return;
+        }
+    }
+
+    job->isCooked = CookFile(job->sourcePath, std::move(source),
+        job->assetPath, options, &job->asset, workers);
+    if (job->isCooked && cache != nullptr && !cache->Store(key, job->asset)) {
+        printf("Could not cache %s\n", job->sourcePath.c_str());
+    }
+}
+
+static const char* GetStoredFormatName(const CookedAsset& asset) {
+    if (asset.flags & GangerEngine::ASSET_FLAG_BC1) return "bc1";
+    if (asset.flags & GangerEngine::ASSET_FLAG_BC3) return "bc3";
+    return "rgba8";
+}
+
+static void PrintTextureReport(const CookedAsset& asset) {
+    uint64_t rgbaSize = GangerEngine::AssetPackage::GetMipChainSize(
+        asset.width, asset.height, asset.numMips);
+    char quality[32] = "lossless";
+    if (asset.psnr > 0.0) {
+        snprintf(quality, sizeof(quality), "%.2f dB", asset.psnr);
+    }
+    printf("  %-40s %5ux%-5u %-5s %2u mips %9llu -> %9llu bytes (%4.1f:1) "
+        "%s\n", asset.path.c_str(), asset.width, asset.height,
+        GetStoredFormatName(asset), asset.numMips,
+        static_cast<unsigned long long>(rgbaSize),
+        static_cast<unsigned long long>(asset.rawSize),
+        asset.rawSize > 0 ? static_cast<double>(rgbaSize) / asset.rawSize :
+        0.0, quality);
+}
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    std::string root;
+    std::string cachePath;
+    bool isCacheEnabled = true;
+    bool isReportEnabled = false;
+    unsigned int numThreads = 0;
+    CookOptions options;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "-root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (strcmp(argv[i], "-mips") == 0) {
+            options.generateMips = true;
+        } else if (strcmp(argv[i], "-compress") == 0) {
+            options.compress = true;
+        } else if (strcmp(argv[i], "-format") == 0 && i + 1 < argc) {
+            std::string rule = argv[++i];
+            size_t colon = rule.find(':');
+            TextureFormat format;
+            if (!ParseTextureFormat(rule.substr(0, colon), &format)) {
+                PrintUsage();
+                return 1;
+            }
+            if (colon == std::string::npos) {
+                options.textureFormat = format;
+            } else {
+                FormatRule formatRule;
+                formatRule.prefix = GangerEngine::AssetPackage::NormalizePath(
+                    rule.substr(colon + 1));
+                formatRule.format = format;
+                options.formatRules.push_back(formatRule);
+            }
+        } else if (strcmp(argv[i], "-report") == 0) {
+            isReportEnabled = true;
+        } else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc) {
+            cachePath = argv[++i];
+        } else if (strcmp(argv[i], "-nocache") == 0) {
+            isCacheEnabled = false;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            numThreads = static_cast<unsigned int>(atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            PrintUsage();
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (outputPath.empty() || inputs.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    CookCache cache;
+    if (isCacheEnabled) {
+        if (cachePath.empty()) cachePath = outputPath + ".cache";
+        isCacheEnabled = cache.Init(cachePath);
+    }
+
+    std::vector<std::string> files;
+    for (auto& input : inputs) {
+        ListFiles(input, &files);
+    }
+
+    std::vector<CookJob> jobs(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        jobs[i].sourcePath = files[i];
+        jobs[i].assetPath = MakeAssetPath(files[i], root);
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    {
+        GangerEngine::ThreadPool workers;
+        workers.Init(numThreads);
+        GangerEngine::ThreadPool* workersPointer = &workers;
+        for (auto& job : jobs) {
+            CookJob* jobPointer = &job;
+            CookCache* cachePointer = isCacheEnabled ? &cache : nullptr;
+            // Big textures also spread their blocks over the idle workers
+            workers.Enqueue([jobPointer, &options, cachePointer,
+                workersPointer] {
+                RunJob(jobPointer, options, cachePointer, workersPointer);
+            });
+        }
+        workers.WaitIdle();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+
+    // Added in input order, so the package does not depend on the scheduling
+    PackageWriter writer;
+    uint64_t rawBytes = 0, storedBytes = 0;
+    int numFailed = 0, numHits = 0;
+    if (isReportEnabled) printf("Textures:\n");
+    for (auto& job : jobs) {
+        if (!job.isCooked) {
+            numFailed++;
+            continue;
+        }
+        if (job.isCacheHit) numHits++;
+        if (isReportEnabled &&
+            job.asset.type == GangerEngine::AssetType::TEXTURE) {
+            PrintTextureReport(job.asset);
+        }
+        rawBytes += job.asset.rawSize;
+        storedBytes += job.asset.payload.size();
+        writer.Add(job.asset);
+    }
+
+    if (!writer.Write(outputPath)) return 1;
+
+    printf("Cooked %u assets into %s in %.2fs: %llu bytes, %llu stored\n",
+        static_cast<unsigned int>(writer.GetNumAssets()), outputPath.c_str(),
+        seconds, static_cast<unsigned long long>(rawBytes),
+        static_cast<unsigned long long>(storedBytes));
+    if (isCacheEnabled && !jobs.empty()) {
+        int numLookups = static_cast<int>(jobs.size()) - numFailed;
+        printf("Cache %s: %d hits, %d misses, %.1f%% hit rate\n",
+            cachePath.c_str(), numHits, numLookups - numHits,
+            numLookups > 0 ? 100.0 * numHits / numLookups : 0.0);
+    }
+    if (numFailed > 0) {
+        printf("%d files failed to cook\n", numFailed);
+        return 1;
+    }
+    return 0;
+}
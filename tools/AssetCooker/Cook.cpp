@@ -0,0 +1,320 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "Cook.h"
+
+#include <GangerEngine/BlockCompressor.h>
+#include <GangerEngine/Compression.h>
+#include <GangerEngine/ImageProcessor.h>
+#include <GangerEngine/IOManager.h>
+#include <GangerEngine/PNGDecoder.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using GangerEngine::AssetType;
+
+static bool HasExtension(const std::string& path, const char* extension) {
+    size_t length = strlen(extension);
+    if (path.size() < length) return false;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = path[path.size() - length + i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != extension[i]) return false;
+    }
+    return true;
+}
+
+static bool IsShader(const std::string& path) {
+    return HasExtension(path, ".vert") || HasExtension(path, ".frag") ||
+        HasExtension(path, ".glsl");
+}
+
+static std::string GetDirectory(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// Gets the file of an #include "file" line, relative to the includer
+static bool ParseInclude(const std::string& line, const std::string& includer,
+    std::string* includePath) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos ||
+        line.compare(start, 8, "#include") != 0) {
+        return false;
+    }
+
+    size_t open = line.find('"', start + 8);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    if (close == std::string::npos) return false;
+
+    *includePath = GetDirectory(includer) +
+        line.substr(open + 1, close - open - 1);
+    return true;
+}
+
+// Appends the shader text with its includes expanded in place
+static bool ExpandIncludes(const std::string& sourcePath,
+    const std::string& text, std::vector<std::string>* stack,
+    std::string* expanded) {
+    stack->push_back(sourcePath);
+
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = text.size();
+        std::string line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        std::string includePath;
+        if (!ParseInclude(line, sourcePath, &includePath)) {
+            expanded->append(line);
+            expanded->push_back('\n');
+            continue;
+        }
+
+        for (auto& open : *stack) {
+            if (open == includePath) {
+                printf("%s includes itself\n", includePath.c_str());
+                return false;
+            }
+        }
+
+        std::string included;
+        if (!GangerEngine::IOManager::ReadFileToBuffer(includePath,
+            included) || !ExpandIncludes(includePath, included, stack,
+            expanded)) {
+            return false;
+        }
+    }
+
+    stack->pop_back();
+    return true;
+}
+
+void ScanDependencies(const std::string& sourcePath,
+    const std::vector<unsigned char>& source,
+    std::vector<std::string>* dependencies) {
+    std::string text(source.begin(), source.end());
+
+    if (IsShader(sourcePath)) {
+        std::vector<std::string> pending(1, sourcePath);
+        std::vector<std::string> texts(1, text);
+        while (!pending.empty()) {
+            std::string includer = pending.back();
+            std::string includerText = texts.back();
+            pending.pop_back();
+            texts.pop_back();
+
+            std::istringstream lines(includerText);
+            std::string line, includePath;
+            while (std::getline(lines, line)) {
+                if (!ParseInclude(line, includer, &includePath)) continue;
+                if (std::find(dependencies->begin(), dependencies->end(),
+                    includePath) != dependencies->end()) {
+                    continue;
+                }
+
+                dependencies->push_back(includePath);
+                std::string included;
+                if (GangerEngine::IOManager::ReadFileToBuffer(includePath,
+                    included)) {
+                    pending.push_back(includePath);
+                    texts.push_back(included);
+                }
+            }
+        }
+    } else if (HasExtension(sourcePath, ".imageset")) {
+        const std::string attribute = "imagefile=\"";
+        size_t start = text.find(attribute);
+        if (start != std::string::npos) {
+            start += attribute.size();
+            size_t end = text.find('"', start);
+            if (end != std::string::npos) {
+                dependencies->push_back(GetDirectory(sourcePath) +
+                    text.substr(start, end - start));
+            }
+        }
+    }
+}
+
+static const char* TEXTURE_FORMAT_NAMES[] = { "rgba8", "bc1", "bc3", "auto" };
+
+bool ParseTextureFormat(const std::string& name, TextureFormat* format) {
+    for (uint32_t i = 0; i < 4; i++) {
+        if (name == TEXTURE_FORMAT_NAMES[i]) {
+            *format = static_cast<TextureFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GetTextureFormatName(TextureFormat format) {
+    return TEXTURE_FORMAT_NAMES[static_cast<uint32_t>(format)];
+}
+
+TextureFormat GetTextureFormat(const CookOptions& options,
+    const std::string& assetPath) {
+    TextureFormat format = options.textureFormat;
+    for (auto& rule : options.formatRules) {
+        if (assetPath.compare(0, rule.prefix.size(), rule.prefix) == 0) {
+            format = rule.format;
+        }
+    }
+    return format;
+}
+
+// Peak signal to noise ratio over the four channels, 0 when they match
+static double ComputePSNR(const unsigned char* source,
+    const unsigned char* decoded, size_t numBytes) {
+    double squaredError = 0.0;
+    for (size_t i = 0; i < numBytes; i++) {
+        double delta = static_cast<double>(source[i]) - decoded[i];
+        squaredError += delta * delta;
+    }
+    if (squaredError == 0.0) return 0.0;
+    return 10.0 * log10(255.0 * 255.0 * numBytes / squaredError);
+}
+
+// Replaces an RGBA8 chain by its blocks
+static void CompressTexture(GangerEngine::PixelFormat format,
+    CookedAsset* asset, GangerEngine::ThreadPool* workers) {
+    uint32_t flag = format == GangerEngine::PixelFormat::BC1 ?
+        GangerEngine::ASSET_FLAG_BC1 : GangerEngine::ASSET_FLAG_BC3;
+    std::vector<unsigned char> blocks(static_cast<size_t>(
+        GangerEngine::AssetPackage::GetMipChainSize(asset->width,
+        asset->height, asset->numMips, flag)));
+
+    const unsigned char* pixels = &asset->payload[0];
+    unsigned char* out = &blocks[0];
+    int width = static_cast<int>(asset->width);
+    int height = static_cast<int>(asset->height);
+    for (uint32_t level = 0; level < asset->numMips; level++) {
+        GangerEngine::BlockCompressor::Compress(pixels, width, height,
+            format, out, workers);
+        pixels += static_cast<size_t>(width) * height * 4;
+        out += GangerEngine::ImageProcessor::GetLevelSize(format, width,
+            height);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    // The quality of the first level, the one seen up close
+    std::vector<unsigned char> decoded(static_cast<size_t>(asset->width) *
+        asset->height * 4);
+    GangerEngine::BlockCompressor::Decompress(&blocks[0],
+        static_cast<int>(asset->width), static_cast<int>(asset->height),
+        format, &decoded[0]);
+    asset->psnr = ComputePSNR(&asset->payload[0], &decoded[0],
+        decoded.size());
+
+    asset->payload = std::move(blocks);
+    asset->flags |= flag;
+}
+
+bool CookFile(const std::string& sourcePath,
+    std::vector<unsigned char> source, const std::string& assetPath,
+    const CookOptions& options, CookedAsset* asset,
+    GangerEngine::ThreadPool* workers) {
+    asset->path = assetPath;
+    asset->flags = 0;
+    asset->psnr = 0.0;
+
+    if (HasExtension(sourcePath, ".png")) {
+        std::vector<unsigned char> pixels;
+        unsigned long width = 0, height = 0;
+        int errorCode = source.empty() ? -1 : GangerEngine::DecodePNGImage(
+            pixels, width, height, &source[0], source.size());
+        if (errorCode != 0) {
+            printf("decodePNG failed on %s with error: %d\n",
+                sourcePath.c_str(), errorCode);
+            return false;
+        }
+
+        asset->type = AssetType::TEXTURE;
+        asset->width = static_cast<uint32_t>(width);
+        asset->height = static_cast<uint32_t>(height);
+        asset->numMips = 1;
+        if (options.generateMips) {
+            int numMips = GangerEngine::ImageProcessor::BuildMipChain(pixels,
+                static_cast<int>(width), static_cast<int>(height));
+            asset->numMips = static_cast<uint32_t>(numMips);
+            asset->flags |= GangerEngine::ASSET_FLAG_MIPS;
+        }
+
+        TextureFormat format = GetTextureFormat(options, assetPath);
+        if (format == TextureFormat::AUTO) {
+            format = TextureFormat::BC1;
+            for (size_t i = 3; i < pixels.size(); i += 4) {
+                if (pixels[i] != 255) {
+                    format = TextureFormat::BC3;
+                    break;
+                }
+            }
+        }
+
+        asset->payload = std::move(pixels);
+        if (format == TextureFormat::BC1) {
+            CompressTexture(GangerEngine::PixelFormat::BC1, asset, workers);
+        } else if (format == TextureFormat::BC3) {
+            CompressTexture(GangerEngine::PixelFormat::BC3, asset, workers);
+        }
+    } else if (IsShader(sourcePath)) {
+        // GLSL has no includes, resolve them here once
+        std::vector<std::string> stack;
+        std::string expanded;
+        if (!ExpandIncludes(sourcePath,
+            std::string(source.begin(), source.end()), &stack, &expanded)) {
+            printf("Failed to expand the includes of %s\n",
+                sourcePath.c_str());
+            return false;
+        }
+
+        asset->type = AssetType::RAW;
+        asset->width = 0;
+        asset->height = 0;
+        asset->numMips = 0;
+        asset->payload.assign(expanded.begin(), expanded.end());
+    } else {
+        asset->type = AssetType::RAW;
+        asset->width = 0;
+        asset->height = 0;
+        asset->numMips = 0;
+        asset->payload = std::move(source);
+    }
+    asset->rawSize = asset->payload.size();
+
+    if (options.compress && !asset->payload.empty()) {
+        std::vector<unsigned char> compressed;
+        GangerEngine::CompressLZ(&asset->payload[0], asset->payload.size(),
+            compressed);
+        // Keep it only if it saves at least an eighth
+        if (compressed.size() < asset->payload.size() -
+            asset->payload.size() / 8) {
+            asset->payload = std::move(compressed);
+            asset->flags |= GangerEngine::ASSET_FLAG_COMPRESSED;
+        }
+    }
+    return true;
+}
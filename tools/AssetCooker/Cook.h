@@ -0,0 +1,102 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _COOK_H_
+#define _COOK_H_
+
+#include "PackageWriter.h"
+
+#include <GangerEngine/ThreadPool.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Bump it whenever the cooked output of a source changes, it is part of
+/// every cache key.
+const unsigned int COOK_VERSION = 3;
+
+/// How textures are stored.
+enum class TextureFormat : uint32_t {
+    RGBA8,
+    BC1,
+    BC3,
+    AUTO  ///< BC1 for opaque textures, BC3 for the rest
+};
+
+/// Sets the format of the assets under a path prefix.
+struct FormatRule {
+    std::string prefix;
+    TextureFormat format;
+};
+
+/// How the assets are cooked.
+struct CookOptions {
+    bool generateMips = false;  ///< Store the whole mip chain of textures
+    bool compress = false;  ///< LZ compress payloads when it pays off
+    TextureFormat textureFormat = TextureFormat::RGBA8;
+    std::vector<FormatRule> formatRules;  ///< The last match wins
+};
+
+/**
+ * \brief      Parses a texture format name: rgba8, bc1, bc3 or auto.
+ *
+ * \return     False if it is not one.
+ */
+bool ParseTextureFormat(const std::string& name, TextureFormat* format);
+
+/// Gets the name of a texture format.
+const char* GetTextureFormatName(TextureFormat format);
+
+/// Gets the format the options select for an asset.
+TextureFormat GetTextureFormat(const CookOptions& options,
+    const std::string& assetPath);
+
+/**
+ * \brief      Cooks one source file. Pngs become textures in the format the
+ *             options select, shaders get their #include "file" lines
+ *             expanded and anything else (levels, fonts, imagesets...) is
+ *             stored as is.
+ *
+ * \param[in]  sourcePath  The file on disk
+ * \param[in]  source      Its bytes
+ * \param[in]  assetPath   The path the game asks for
+ * \param[in]  options     The options
+ * \param      asset       The cooked asset
+ * \param      workers     Splits the block compression among its threads,
+ *                         may be null
+ *
+ * \return     False if the source could not be decoded.
+ */
+bool CookFile(const std::string& sourcePath,
+    std::vector<unsigned char> source, const std::string& assetPath,
+    const CookOptions& options, CookedAsset* asset,
+    GangerEngine::ThreadPool* workers = nullptr);
+
+/**
+ * \brief      Lists the other files the cooked output of a source depends
+ *             on: the shader includes, recursively, and the imagefile of a
+ *             CEGUI imageset.
+ *
+ * \param[in]  sourcePath    The file on disk
+ * \param[in]  source        Its bytes
+ * \param      dependencies  The dependency paths
+ */
+void ScanDependencies(const std::string& sourcePath,
+    const std::vector<unsigned char>& source,
+    std::vector<std::string>* dependencies);
+
+#endif  // _COOK_H_
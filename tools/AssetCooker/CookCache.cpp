@@ -0,0 +1,161 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "CookCache.h"
+
+#include <GangerEngine/Hash.h>
+#include <GangerEngine/IOManager.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Every cache entry starts with this record, then the payload
+struct CacheRecord {
+    char magic[4];
+    uint32_t type;
+    uint32_t flags;
+    uint32_t width;
+    uint32_t height;
+    uint32_t numMips;
+    uint64_t rawSize;
+    uint64_t payloadSize;
+    double psnr;
+};
+
+static const char CACHE_MAGIC[4] = { 'G', 'C', 'K', 'C' };
+
+bool CookCache::Init(const std::string& directory) {
+    m_directory = directory;
+    if (!m_directory.empty() && m_directory.back() != '/') {
+        m_directory.push_back('/');
+    }
+
+    // Fails when it already exists, so check it can be written to instead
+    GangerEngine::IOManager::MakeDirectory(directory.c_str());
+    std::string probePath = m_directory + ".probe";
+    std::ofstream probe(probePath, std::ios::binary);
+    if (probe.fail()) {
+        perror(directory.c_str());
+        return false;
+    }
+    probe.close();
+    remove(probePath.c_str());
+    return true;
+}
+
+uint64_t CookCache::ComputeKey(const std::vector<unsigned char>& source,
+    const std::vector<std::string>& dependencies,
+    const CookOptions& options, TextureFormat format) {
+    // Only the format of this asset, other rules do not change its output
+    uint32_t params[4] = { COOK_VERSION, options.generateMips ? 1u : 0u,
+        options.compress ? 1u : 0u, static_cast<uint32_t>(format) };
+    uint64_t hash = GangerEngine::HashFNV1a(
+        reinterpret_cast<const char*>(params), sizeof(params));
+
+    if (!source.empty()) {
+        hash = GangerEngine::HashFNV1a(
+            reinterpret_cast<const char*>(&source[0]), source.size(), hash);
+    }
+
+    // The name matters too, an include can be swapped for another file
+    std::vector<unsigned char> dependency;
+    for (auto& path : dependencies) {
+        hash = GangerEngine::HashFNV1a(path.c_str(), path.size() + 1, hash);
+        if (GangerEngine::IOManager::ReadFileToBuffer(path, dependency) &&
+            !dependency.empty()) {
+            hash = GangerEngine::HashFNV1a(
+                reinterpret_cast<const char*>(&dependency[0]),
+                dependency.size(), hash);
+        }
+    }
+    return hash;
+}
+
+bool CookCache::Load(uint64_t key, CookedAsset* asset) const {
+    std::ifstream file(GetEntryPath(key), std::ios::binary);
+    if (file.fail()) return false;
+
+    CacheRecord record;
+    file.read(reinterpret_cast<char*>(&record), sizeof(record));
+    if (file.fail() ||
+        memcmp(record.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        return false;
+    }
+
+    asset->type = static_cast<GangerEngine::AssetType>(record.type);
+    asset->flags = record.flags;
+    asset->width = record.width;
+    asset->height = record.height;
+    asset->numMips = record.numMips;
+    asset->rawSize = record.rawSize;
+    asset->psnr = record.psnr;
+    asset->payload.resize(static_cast<size_t>(record.payloadSize));
+    if (!asset->payload.empty()) {
+        file.read(reinterpret_cast<char*>(&asset->payload[0]),
+            asset->payload.size());
+    }
+    return !file.fail();
+}
+
+bool CookCache::Store(uint64_t key, const CookedAsset& asset) {
+    CacheRecord record;
+    memcpy(record.magic, CACHE_MAGIC, sizeof(record.magic));
+    record.type = static_cast<uint32_t>(asset.type);
+    record.flags = asset.flags;
+    record.width = asset.width;
+    record.height = asset.height;
+    record.numMips = asset.numMips;
+    record.rawSize = asset.rawSize;
+    record.payloadSize = asset.payload.size();
+    record.psnr = asset.psnr;
+
+    // Write aside and rename, so a reader never sees half an entry
+    std::string entryPath = GetEntryPath(key);
+    std::string tempPath = entryPath + "." + std::to_string(m_tempCounter++);
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (file.fail()) return false;
+
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        if (!asset.payload.empty()) {
+            file.write(reinterpret_cast<const char*>(&asset.payload[0]),
+                asset.payload.size());
+        }
+        if (file.fail()) {
+            file.close();
+            remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    // Another thread may have stored the same content meanwhile
+    remove(entryPath.c_str());
+    if (rename(tempPath.c_str(), entryPath.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string CookCache::GetEntryPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cooked",
+        static_cast<unsigned long long>(key));
+    return m_directory + name;
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _COOKCACHE_H_
+#define _COOKCACHE_H_
+
+#include "Cook.h"
+#include "PackageWriter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// A content addressed store of cooked assets. The key hashes everything the
+/// output depends on: the source bytes, the bytes of its dependencies, the
+/// cook options and COOK_VERSION. The asset path is left out, so the same
+/// file under two names is cooked once.
+class CookCache {
+ public:
+    /**
+     * \brief      Opens the cache, creating its directory.
+     *
+     * \param[in]  directory  The directory
+     *
+     * \return     False if the directory could not be made.
+     */
+    bool Init(const std::string& directory);
+
+    /**
+     * \brief      Computes the key of a source.
+     *
+     * \param[in]  source        The source bytes
+     * \param[in]  dependencies  The files the output depends on
+     * \param[in]  options       The cook options
+     * \param[in]  format        The texture format of this asset
+     *
+     * \return     The key. A missing dependency is hashed as empty, so it
+     *             still re-cooks once it shows up.
+     */
+    static uint64_t ComputeKey(const std::vector<unsigned char>& source,
+        const std::vector<std::string>& dependencies,
+        const CookOptions& options, TextureFormat format);
+
+    /**
+     * \brief      Loads a cooked asset. The path is not stored, set it after.
+     *
+     * \return     False on a miss.
+     */
+    bool Load(uint64_t key, CookedAsset* asset) const;
+
+    /// Stores a cooked asset. Safe to call from several threads.
+    bool Store(uint64_t key, const CookedAsset& asset);
+
+ private:
+    std::string GetEntryPath(uint64_t key) const;
+
+    std::string m_directory;
+    std::atomic<unsigned int> m_tempCounter { 0 };
+};
+
+#endif  // _COOKCACHE_H_
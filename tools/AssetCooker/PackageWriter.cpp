@@ -0,0 +1,115 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "PackageWriter.h"
+
+#include <GangerEngine/Hash.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using GangerEngine::PackageEntry;
+using GangerEngine::PackageHeader;
+
+void PackageWriter::Add(const CookedAsset& asset) {
+    for (auto& existing : m_assets) {
+        if (existing.path == asset.path) {
+            existing = asset;
+            return;
+        }
+    }
+    m_assets.push_back(asset);
+}
+
+bool PackageWriter::Write(const std::string& filePath) const {
+    // The table of contents is sorted by hash for the binary search
+    std::vector<const CookedAsset*> sorted;
+    for (auto& asset : m_assets) {
+        sorted.push_back(&asset);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+        [](const CookedAsset* a, const CookedAsset* b) {
+        uint64_t hashA = GangerEngine::HashFNV1a(a->path);
+        uint64_t hashB = GangerEngine::HashFNV1a(b->path);
+        return hashA != hashB ? hashA < hashB : a->path < b->path;
+    });
+
+    std::string strings;
+    std::vector<PackageEntry> entries(sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        PackageEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.pathHash = GangerEngine::HashFNV1a(sorted[i]->path);
+        entry.size = sorted[i]->payload.size();
+        entry.rawSize = sorted[i]->rawSize;
+        entry.type = static_cast<uint32_t>(sorted[i]->type);
+        entry.flags = sorted[i]->flags;
+        entry.width = sorted[i]->width;
+        entry.height = sorted[i]->height;
+        entry.numMips = sorted[i]->numMips;
+        entry.pathOffset = static_cast<uint32_t>(strings.size());
+        strings.append(sorted[i]->path);
+        strings.push_back('\0');
+    }
+
+    // Payloads follow the string table, each on an aligned offset
+    const uint64_t alignment = GangerEngine::PACKAGE_ALIGNMENT;
+    uint64_t offset = sizeof(PackageHeader) +
+        entries.size() * sizeof(PackageEntry) + strings.size();
+    for (auto& entry : entries) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    PackageHeader header;
+    memcpy(header.magic, GangerEngine::PACKAGE_MAGIC, sizeof(header.magic));
+    header.version = GangerEngine::PACKAGE_VERSION;
+    header.numEntries = static_cast<uint32_t>(entries.size());
+    header.stringTableSize = static_cast<uint32_t>(strings.size());
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (file.fail()) {
+        perror(filePath.c_str());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!entries.empty()) {
+        file.write(reinterpret_cast<const char*>(&entries[0]),
+            entries.size() * sizeof(PackageEntry));
+    }
+    file.write(strings.data(), strings.size());
+
+    static const char ZEROS[GangerEngine::PACKAGE_ALIGNMENT] = {};
+    uint64_t position = sizeof(PackageHeader) +
+        entries.size() * sizeof(PackageEntry) + strings.size();
+    for (size_t i = 0; i < entries.size(); i++) {
+        file.write(ZEROS, entries[i].offset - position);
+        const std::vector<unsigned char>& payload = sorted[i]->payload;
+        if (!payload.empty()) {
+            file.write(reinterpret_cast<const char*>(&payload[0]),
+                payload.size());
+        }
+        position = entries[i].offset + entries[i].size;
+    }
+
+    return !file.fail();
+}
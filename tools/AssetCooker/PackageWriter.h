@@ -0,0 +1,64 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _PACKAGEWRITER_H_
+#define _PACKAGEWRITER_H_
+
+#include <GangerEngine/AssetPackage.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// An asset ready to be stored.
+struct CookedAsset {
+    std::string path;  ///< The normalized path the game asks for
+    GangerEngine::AssetType type = GangerEngine::AssetType::RAW;
+    uint32_t flags = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numMips = 0;
+    uint64_t rawSize = 0;
+    std::vector<unsigned char> payload;  ///< The bytes as stored
+    double psnr = 0.0;  ///< Of a block compressed texture, in dB
+};
+
+/// Lays the cooked assets out in the package format read by AssetPackage.
+class PackageWriter {
+ public:
+    /**
+     * \brief      Adds an asset, replacing one with the same path.
+     *
+     * \param[in]  asset  The asset
+     */
+    void Add(const CookedAsset& asset);
+
+    /**
+     * \brief      Writes the package.
+     *
+     * \param[in]  filePath  The file path
+     *
+     * \return     False if the file could not be written.
+     */
+    bool Write(const std::string& filePath) const;
+
+    size_t GetNumAssets() const { return m_assets.size(); }
+
+ private:
+    std::vector<CookedAsset> m_assets;
+};
+
+#endif  // _PACKAGEWRITER_H_
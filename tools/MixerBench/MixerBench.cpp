@@ -0,0 +1,161 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Measures the effect mixer without an audio device, for CI:
+//
+//   MixerBench [-voices <count>]... [-seconds <seconds>] [-block <frames>]
+//
+// Every voice plays a looping generated effect at its own place around a
+// moving listener, the way a busy scene does. The mixer is called in blocks
+// as the audio callback would, as fast as it goes, first with the scalar
+// kernels and then with the SIMD ones, whose output must match. A real
+// device paces the callback, so the engine itself is run headless with
+// SDL_AUDIODRIVER=dummy instead.
+
+#include <GangerEngine/Mixer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const int SAMPLE_RATE = 44100;
+
+// A decaying noisy tone, a second long
+static std::vector<int16_t> MakeEffect(int seed) {
+    std::vector<int16_t> samples(2 * SAMPLE_RATE);
+    uint32_t state = 2463534242u + seed;
+    float frequency = 110.0f * (1 + seed % 7);
+    for (int i = 0; i < SAMPLE_RATE; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        float noise = (state & 0xffff) / 32768.0f - 1.0f;
+        float tone = std::sin(6.2831853f * frequency * i / SAMPLE_RATE);
+        float envelope = std::exp(-3.0f * i / SAMPLE_RATE);
+        float value = 12000.0f * envelope * (0.7f * tone + 0.3f * noise);
+        samples[2 * i] = static_cast<int16_t>(value);
+        samples[2 * i + 1] = static_cast<int16_t>(value * 0.8f);
+    }
+    return samples;
+}
+
+// Mixes the seconds asked for, and returns how long it took
+static double Run(const std::vector<std::vector<int16_t> >& effects,
+    int numVoices, double seconds, int blockFrames, bool isSIMDEnabled,
+    std::vector<int16_t>* output, GangerEngine::MixerStats* stats) {
+    GangerEngine::Mixer mixer;
+    mixer.Init(numVoices, blockFrames);
+    mixer.SetSIMDEnabled(isSIMDEnabled);
+
+    for (int i = 0; i < numVoices; i++) {
+        const std::vector<int16_t>& effect = effects[i % effects.size()];
+        float angle = 6.2831853f * i / numVoices;
+        glm::vec2 position(std::cos(angle), std::sin(angle));
+        position *= 50.0f + 10.0f * (i % 50);
+        mixer.PlayAt(i, 1, effect.data(),
+            static_cast<uint32_t>(effect.size() / 2), -1, 0.5f, position);
+    }
+
+    int numBlocks = static_cast<int>(seconds * SAMPLE_RATE / blockFrames);
+    output->assign(2 * blockFrames * static_cast<size_t>(numBlocks), 0);
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < numBlocks; i++) {
+        // The listener walks, so every block recomputes the gains
+        mixer.SetListener(glm::vec2(0.5f * i, 0.0f), 64.0f, 1024.0f);
+        mixer.Mix(output->data() + 2 * blockFrames * static_cast<size_t>(i),
+            blockFrames);
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+
+    *stats = mixer.GetStats();
+    return elapsed;
+}
+
+static void PrintUsage() {
+    printf("Usage: MixerBench [-voices <count>]... [-seconds <seconds>] "
+        "[-block <frames>]\n");
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> voiceCounts;
+    double seconds = 10.0;
+    int blockFrames = 1024;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-voices") == 0 && i + 1 < argc) {
+            voiceCounts.push_back(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-block") == 0 && i + 1 < argc) {
+            blockFrames = atoi(argv[++i]);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (voiceCounts.empty()) voiceCounts = {16, 64, 256, 512};
+    if (seconds <= 0.0 || blockFrames <= 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::vector<std::vector<int16_t> > effects;
+    for (int i = 0; i < 16; i++) {
+        effects.push_back(MakeEffect(i));
+    }
+
+    printf("%.1fs of audio at %d Hz in blocks of %d frames\n", seconds,
+        SAMPLE_RATE, blockFrames);
+    bool isMatching = true;
+    for (int numVoices : voiceCounts) {
+        if (numVoices <= 0) continue;
+
+        std::vector<int16_t> scalarOutput, simdOutput;
+        GangerEngine::MixerStats stats;
+        double scalarTime = Run(effects, numVoices, seconds, blockFrames,
+            false, &scalarOutput, &stats);
+        double simdTime = Run(effects, numVoices, seconds, blockFrames,
+            true, &simdOutput, &stats);
+
+        // The kernels may round the last bit apart
+        int maxError = 0;
+        for (size_t i = 0; i < scalarOutput.size(); i++) {
+            maxError = std::max(maxError,
+                std::abs(scalarOutput[i] - simdOutput[i]));
+        }
+        isMatching &= maxError <= 1;
+
+        double voiceFrames = static_cast<double>(stats.numVoiceFramesMixed);
+        printf("%4d voices: scalar %7.3fs (%6.1fx realtime), simd %7.3fs "
+            "(%6.1fx realtime, %5.2f ns per voice frame), max error %d\n",
+            numVoices, scalarTime, seconds / scalarTime, simdTime,
+            seconds / simdTime,
+            voiceFrames > 0.0 ? 1e9 * simdTime / voiceFrames : 0.0,
+            maxError);
+    }
+
+    if (!isMatching) {
+        printf("The SIMD mix does not match the scalar one\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,707 @@
+/*
+    Copyright [2016] [Elías Serrano]
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Checks the fast png decoder against PicoPNG and measures both:
+//
+//   PNGBench [-n <iterations>] Demos/ZombieGame/Textures Demos/...
+//
+// Every png found is decoded by both decoders and the pixels compared. A set
+// of generated images also covers the color types, filters and transparency
+// the demo assets do not use, compressed into stored, fixed Huffman and
+// dynamic Huffman deflate blocks. It exits with 1 on any mismatch.
+
+#include <GangerEngine/PicoPNG.h>
+#include <GangerEngine/PNGDecoder.h>
+#include <GangerEngine/IOManager.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+static bool IsDirectory(const std::string& path) {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES &&
+        (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat pathStat;
+    return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+#endif
+}
+
+static void ListPNGs(const std::string& path,
+    std::vector<std::string>* files) {
+    if (!IsDirectory(path)) {
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".png") == 0) {
+            files->push_back(path);
+        }
+        return;
+    }
+
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA((path + "/*").c_str(), &findData);
+    if (find == INVALID_HANDLE_VALUE) return;
+    do {
+        names.push_back(findData.cFileName);
+    } while (FindNextFileA(find, &findData));
+    FindClose(find);
+#else
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return;
+    while (dirent* entry = readdir(dir)) {
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif
+
+    for (auto& name : names) {
+        if (name.empty() || name[0] == '.') continue;
+        ListPNGs(path + "/" + name, files);
+    }
+}
+
+static void AppendBigEndian32(std::vector<unsigned char>* data,
+    uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data->push_back(static_cast<unsigned char>(value >> shift));
+    }
+}
+
+static void AppendChunk(std::vector<unsigned char>* png, const char* type,
+    const std::vector<unsigned char>& data) {
+    AppendBigEndian32(png, static_cast<uint32_t>(data.size()));
+    png->insert(png->end(), type, type + 4);
+    png->insert(png->end(), data.begin(), data.end());
+    // Neither decoder checks the CRC
+    AppendBigEndian32(png, 0);
+}
+
+// The deflate tables, RFC 1951
+static const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15,
+    17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227,
+    258 };
+static const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+    2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33,
+    49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+    6145, 8193, 12289, 16385, 24577 };
+static const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4,
+    5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const int CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+    11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static const int MAX_MATCH = 258;
+static const int WINDOW_SIZE = 32768;
+// Small blocks, so that many matches reach back into an earlier block
+static const size_t BLOCK_SYMBOLS = 1000;
+
+// A literal, or a match when length is not 0
+struct DeflateSymbol {
+    int length;
+    int value;  // The literal, or the match distance
+    size_t pos;  // Where its bytes start
+};
+
+// What the generated deflate streams covered
+struct DeflateStats {
+    int numBlocks[3] = { 0, 0, 0 };  // Stored, fixed and dynamic
+    int longestMatch = 0;
+    int farthestMatch = 0;
+    int numCrossingMatches = 0;  // Reaching back into an earlier block
+};
+
+static DeflateStats deflateStats;
+
+// Writes deflate bits, from the lowest bit of each byte
+class BitWriter {
+ public:
+    explicit BitWriter(std::vector<unsigned char>* data) : m_data(data) {
+        // Empty
+    }
+
+    void Write(uint32_t bits, int count) {
+        for (int i = 0; i < count; i++) {
+            if (m_numBits == 0) m_data->push_back(0);
+            m_data->back() |= static_cast<unsigned char>(
+                ((bits >> i) & 1) << m_numBits);
+            m_numBits = (m_numBits + 1) & 7;
+        }
+    }
+
+    // Huffman codes go from their highest bit
+    void WriteCode(uint32_t code, int length) {
+        for (int i = length - 1; i >= 0; i--) Write(code >> i, 1);
+    }
+
+    void AlignToByte() {
+        m_numBits = 0;
+    }
+
+ private:
+    std::vector<unsigned char>* m_data;
+    int m_numBits = 0;
+};
+
+// Greedy LZ77, chaining the earlier positions by the hash of 3 bytes
+static std::vector<DeflateSymbol> FindMatches(
+    const std::vector<unsigned char>& data) {
+    std::vector<DeflateSymbol> symbols;
+    std::vector<int> head(1 << 15, -1);
+    std::vector<int> previous(data.size(), -1);
+    auto hash = [&](size_t pos) {
+        return ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2]) &
+            0x7FFF;
+    };
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        int bestLength = 0, bestDistance = 0;
+        if (pos + 3 <= data.size()) {
+            int maxLength = static_cast<int>(
+                std::min<size_t>(MAX_MATCH, data.size() - pos));
+            int candidate = head[hash(pos)];
+            for (int tries = 0; candidate >= 0 && tries < 128 &&
+                pos - candidate <= WINDOW_SIZE; tries++) {
+                int length = 0;
+                while (length < maxLength &&
+                    data[candidate + length] == data[pos + length]) {
+                    length++;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = static_cast<int>(pos - candidate);
+                    if (length == maxLength) break;
+                }
+                candidate = previous[candidate];
+            }
+        }
+
+        int length = 1;
+        if (bestLength >= 3) {
+            symbols.push_back({ bestLength, bestDistance, pos });
+            length = bestLength;
+        } else {
+            symbols.push_back({ 0, data[pos], pos });
+        }
+        for (int i = 0; i < length; i++, pos++) {
+            if (pos + 3 > data.size()) continue;
+            int key = hash(pos);
+            previous[pos] = head[key];
+            head[key] = static_cast<int>(pos);
+        }
+    }
+    return symbols;
+}
+
+// Huffman code lengths of at most maxLength bits. The rare symbols are made
+// more frequent until the tree is short enough.
+static std::vector<int> BuildLengths(std::vector<uint32_t> frequencies,
+    int maxLength) {
+    // Two used symbols at least, a single one has no valid tree
+    int numUsed = 0;
+    for (uint32_t frequency : frequencies) numUsed += frequency != 0;
+    for (size_t i = 0; numUsed < 2 && i < frequencies.size(); i++) {
+        if (frequencies[i] == 0) {
+            frequencies[i] = 1;
+            numUsed++;
+        }
+    }
+
+    std::vector<int> lengths(frequencies.size(), 0);
+    while (true) {
+        // Leafs have no left child and keep their symbol as the right one
+        struct Node {
+            uint64_t weight;
+            int left;
+            int right;
+        };
+        typedef std::pair<uint64_t, int> Item;
+        std::vector<Node> nodes;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item> >
+            queue;
+        for (size_t i = 0; i < frequencies.size(); i++) {
+            if (frequencies[i] == 0) continue;
+            nodes.push_back({ frequencies[i], -1, static_cast<int>(i) });
+            queue.push(Item(frequencies[i],
+                static_cast<int>(nodes.size() - 1)));
+        }
+        while (queue.size() > 1) {
+            Item first = queue.top();
+            queue.pop();
+            Item second = queue.top();
+            queue.pop();
+            nodes.push_back({ first.first + second.first, first.second,
+                second.second });
+            queue.push(Item(first.first + second.first,
+                static_cast<int>(nodes.size() - 1)));
+        }
+
+        int longest = 0;
+        std::vector<std::pair<int, int> > stack(1,
+            std::make_pair(queue.top().second, 0));
+        while (!stack.empty()) {
+            std::pair<int, int> item = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[item.first];
+            if (node.left < 0) {
+                lengths[node.right] = item.second;
+                longest = std::max(longest, item.second);
+            } else {
+                stack.push_back(std::make_pair(node.left, item.second + 1));
+                stack.push_back(std::make_pair(node.right, item.second + 1));
+            }
+        }
+        if (longest <= maxLength) return lengths;
+
+        for (auto& frequency : frequencies) {
+            if (frequency != 0) frequency = frequency / 2 + 1;
+        }
+    }
+}
+
+// The canonical codes of a set of lengths
+static std::vector<uint32_t> BuildCodes(const std::vector<int>& lengths) {
+    int counts[16] = { 0 };
+    for (int length : lengths) counts[length]++;
+    counts[0] = 0;
+
+    uint32_t nextCode[16] = { 0 };
+    uint32_t code = 0;
+    for (int bits = 1; bits < 16; bits++) {
+        code = (code + counts[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+
+    std::vector<uint32_t> codes(lengths.size(), 0);
+    for (size_t i = 0; i < lengths.size(); i++) {
+        if (lengths[i] != 0) codes[i] = nextCode[lengths[i]]++;
+    }
+    return codes;
+}
+
+static int LengthCode(int length) {
+    int code = 28;
+    while (LENGTH_BASE[code] > length) code--;
+    return code;
+}
+
+static int DistanceCode(int distance) {
+    int code = 29;
+    while (DISTANCE_BASE[code] > distance) code--;
+    return code;
+}
+
+// Writes the code lengths of a dynamic block, run length encoded with the
+// codes 16, 17 and 18
+static void WriteDynamicHeader(BitWriter* writer,
+    const std::vector<int>& literalLengths,
+    const std::vector<int>& distanceLengths) {
+    int numLiterals = 286;
+    while (numLiterals > 257 && literalLengths[numLiterals - 1] == 0) {
+        numLiterals--;
+    }
+    int numDistances = 30;
+    while (numDistances > 1 && distanceLengths[numDistances - 1] == 0) {
+        numDistances--;
+    }
+    std::vector<int> lengths(literalLengths.begin(),
+        literalLengths.begin() + numLiterals);
+    lengths.insert(lengths.end(), distanceLengths.begin(),
+        distanceLengths.begin() + numDistances);
+
+    // The code and its extra bits
+    std::vector<std::pair<int, int> > runs;
+    for (size_t i = 0; i < lengths.size();) {
+        size_t run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == lengths[i]) {
+            run++;
+        }
+        if (lengths[i] == 0 && run >= 3) {
+            run = std::min<size_t>(run, 138);
+            int extra = static_cast<int>(run >= 11 ? run - 11 : run - 3);
+            runs.push_back(std::make_pair(run >= 11 ? 18 : 17, extra));
+        } else if (lengths[i] != 0 && run >= 4) {
+            int repeat = static_cast<int>(std::min<size_t>(run - 1, 6));
+            runs.push_back(std::make_pair(lengths[i], 0));
+            runs.push_back(std::make_pair(16, repeat - 3));
+            run = repeat + 1;
+        } else {
+            run = 1;
+            runs.push_back(std::make_pair(lengths[i], 0));
+        }
+        i += run;
+    }
+
+    std::vector<uint32_t> frequencies(19, 0);
+    for (auto& run : runs) frequencies[run.first]++;
+    std::vector<int> codeLengths = BuildLengths(frequencies, 7);
+    std::vector<uint32_t> codes = BuildCodes(codeLengths);
+    int numCodeLengths = 19;
+    while (numCodeLengths > 4 &&
+        codeLengths[CODE_LENGTH_ORDER[numCodeLengths - 1]] == 0) {
+        numCodeLengths--;
+    }
+
+    writer->Write(numLiterals - 257, 5);
+    writer->Write(numDistances - 1, 5);
+    writer->Write(numCodeLengths - 4, 4);
+    for (int i = 0; i < numCodeLengths; i++) {
+        writer->Write(codeLengths[CODE_LENGTH_ORDER[i]], 3);
+    }
+    static const int REPEAT_BITS[3] = { 2, 3, 7 };
+    for (auto& run : runs) {
+        writer->WriteCode(codes[run.first], codeLengths[run.first]);
+        if (run.first >= 16) {
+            writer->Write(run.second, REPEAT_BITS[run.first - 16]);
+        }
+    }
+}
+
+static void WriteSymbols(BitWriter* writer,
+    const std::vector<DeflateSymbol>& symbols, size_t begin, size_t end,
+    const std::vector<int>& literalLengths,
+    const std::vector<int>& distanceLengths) {
+    std::vector<uint32_t> literalCodes = BuildCodes(literalLengths);
+    std::vector<uint32_t> distanceCodes = BuildCodes(distanceLengths);
+    for (size_t i = begin; i < end; i++) {
+        const DeflateSymbol& symbol = symbols[i];
+        if (symbol.length == 0) {
+            writer->WriteCode(literalCodes[symbol.value],
+                literalLengths[symbol.value]);
+            continue;
+        }
+        int code = LengthCode(symbol.length);
+        writer->WriteCode(literalCodes[257 + code],
+            literalLengths[257 + code]);
+        writer->Write(symbol.length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+        code = DistanceCode(symbol.value);
+        writer->WriteCode(distanceCodes[code], distanceLengths[code]);
+        writer->Write(symbol.value - DISTANCE_BASE[code],
+            DISTANCE_EXTRA[code]);
+    }
+    writer->WriteCode(literalCodes[256], literalLengths[256]);
+}
+
+static uint32_t Adler32(const std::vector<unsigned char>& data) {
+    uint32_t a = 1, b = 0;
+    for (unsigned char value : data) {
+        a = (a + value) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+// A zlib stream of small blocks, of the types in blockTypes in turn: 's'
+// stored, 'f' fixed Huffman and 'd' dynamic Huffman
+static std::vector<unsigned char> Deflate(
+    const std::vector<unsigned char>& data, const char* blockTypes) {
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    BitWriter writer(&zlib);
+    std::vector<DeflateSymbol> symbols = FindMatches(data);
+    size_t numTypes = strlen(blockTypes);
+
+    for (size_t begin = 0, block = 0; begin < symbols.size();
+        begin += BLOCK_SYMBOLS, block++) {
+        size_t end = std::min(begin + BLOCK_SYMBOLS, symbols.size());
+        size_t beginPos = symbols[begin].pos;
+        size_t endPos = end < symbols.size() ? symbols[end].pos : data.size();
+        uint32_t isFinal = end == symbols.size() ? 1 : 0;
+        char type = blockTypes[block % numTypes];
+
+        if (type == 's') {
+            deflateStats.numBlocks[0]++;
+            for (size_t pos = beginPos; pos < endPos;) {
+                size_t length = std::min<size_t>(endPos - pos, 65535);
+                writer.Write(pos + length == endPos ? isFinal : 0, 1);
+                writer.Write(0, 2);
+                writer.AlignToByte();
+                writer.Write(static_cast<uint32_t>(length), 16);
+                writer.Write(static_cast<uint32_t>(~length), 16);
+                for (size_t i = 0; i < length; i++) {
+                    writer.Write(data[pos + i], 8);
+                }
+                pos += length;
+            }
+            continue;
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            const DeflateSymbol& symbol = symbols[i];
+            if (symbol.length == 0) continue;
+            deflateStats.longestMatch = std::max(deflateStats.longestMatch,
+                symbol.length);
+            deflateStats.farthestMatch = std::max(deflateStats.farthestMatch,
+                symbol.value);
+            if (symbol.pos - symbol.value < beginPos) {
+                deflateStats.numCrossingMatches++;
+            }
+        }
+
+        std::vector<int> literalLengths(288, 8);
+        std::vector<int> distanceLengths(30, 5);
+        writer.Write(isFinal, 1);
+        if (type == 'f') {
+            deflateStats.numBlocks[1]++;
+            std::fill(literalLengths.begin() + 144,
+                literalLengths.begin() + 256, 9);
+            std::fill(literalLengths.begin() + 256,
+                literalLengths.begin() + 280, 7);
+            writer.Write(1, 2);
+        } else {
+            deflateStats.numBlocks[2]++;
+            std::vector<uint32_t> literalCounts(286, 0);
+            std::vector<uint32_t> distanceCounts(30, 0);
+            literalCounts[256] = 1;
+            for (size_t i = begin; i < end; i++) {
+                const DeflateSymbol& symbol = symbols[i];
+                if (symbol.length == 0) {
+                    literalCounts[symbol.value]++;
+                } else {
+                    literalCounts[257 + LengthCode(symbol.length)]++;
+                    distanceCounts[DistanceCode(symbol.value)]++;
+                }
+            }
+            literalLengths = BuildLengths(literalCounts, 15);
+            distanceLengths = BuildLengths(distanceCounts, 15);
+            writer.Write(2, 2);
+            WriteDynamicHeader(&writer, literalLengths, distanceLengths);
+        }
+        WriteSymbols(&writer, symbols, begin, end, literalLengths,
+            distanceLengths);
+    }
+
+    AppendBigEndian32(&zlib, Adler32(data));
+    return zlib;
+}
+
+// A png of random scanlines and filter types. Some rows repeat an earlier
+// one, for long and far matches.
+static std::vector<unsigned char> MakePNG(int width, int height,
+    int colorType, bool hasTransparency, unsigned int seed,
+    const char* blockTypes) {
+    static const int CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    int channels = CHANNELS[colorType];
+    srand(seed);
+
+    std::vector<unsigned char> png = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    std::vector<unsigned char> header;
+    AppendBigEndian32(&header, width);
+    AppendBigEndian32(&header, height);
+    header.push_back(8);
+    header.push_back(static_cast<unsigned char>(colorType));
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    AppendChunk(&png, "IHDR", header);
+
+    int paletteSize = 256;
+    if (colorType == 3) {
+        std::vector<unsigned char> palette(paletteSize * 3);
+        for (auto& value : palette) value = rand() & 255;
+        AppendChunk(&png, "PLTE", palette);
+    }
+    if (hasTransparency) {
+        std::vector<unsigned char> transparency;
+        if (colorType == 3) {
+            for (int i = 0; i < 100; i++) transparency.push_back(rand() & 255);
+        } else {
+            // A color key of 7 on every channel, the pixels use few values
+            for (int i = 0; i < (colorType == 2 ? 3 : 1); i++) {
+                transparency.push_back(0);
+                transparency.push_back(7);
+            }
+        }
+        AppendChunk(&png, "tRNS", transparency);
+    }
+
+    std::vector<unsigned char> scanlines;
+    size_t rowBytes = 1 + static_cast<size_t>(width) * channels;
+    for (int y = 0; y < height; y++) {
+        if (y > 0 && rand() % 3 == 0) {
+            size_t row = y - 1 - rand() % std::min(y, 40);
+            std::vector<unsigned char> copy(
+                scanlines.begin() + row * rowBytes,
+                scanlines.begin() + (row + 1) * rowBytes);
+            scanlines.insert(scanlines.end(), copy.begin(), copy.end());
+            continue;
+        }
+        scanlines.push_back(static_cast<unsigned char>(rand() % 5));
+        for (int x = 0; x < width * channels; x++) {
+            int value = colorType == 3 ? rand() % paletteSize : rand() & 15;
+            scanlines.push_back(static_cast<unsigned char>(value));
+        }
+    }
+
+    AppendChunk(&png, "IDAT", Deflate(scanlines, blockTypes));
+    AppendChunk(&png, "IEND", std::vector<unsigned char>());
+    return png;
+}
+
+static bool Compare(const std::string& name,
+    const std::vector<unsigned char>& png, bool mustDecode) {
+    std::vector<unsigned char> reference, pixels;
+    unsigned long referenceWidth = 0, referenceHeight = 0;
+    unsigned long width = 0, height = 0;
+    int referenceError = GangerEngine::DecodePNG(reference, referenceWidth,
+        referenceHeight, &png[0], png.size());
+    int error = GangerEngine::DecodePNGFast(pixels, width, height, &png[0],
+        png.size());
+
+    if (mustDecode && referenceError != 0) {
+        printf("  %-48s PicoPNG error %d\n", name.c_str(), referenceError);
+        return false;
+    }
+    if (error == GangerEngine::PNG_ERROR_UNSUPPORTED) {
+        printf("  %-48s left to PicoPNG\n", name.c_str());
+        return true;
+    }
+    if (referenceError != 0 || error != 0) {
+        bool isMatch = (referenceError != 0) == (error != 0);
+        printf("  %-48s %s: PicoPNG error %d, fast error %d\n", name.c_str(),
+            isMatch ? "both fail" : "MISMATCH", referenceError, error);
+        return isMatch;
+    }
+    if (width != referenceWidth || height != referenceHeight ||
+        pixels != reference) {
+        printf("  %-48s MISMATCH\n", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <typename Function>
+static double Time(int iterations, Function function) {
+    auto startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) function();
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else {
+            ListPNGs(argv[i], &files);
+        }
+    }
+
+    int numMismatches = 0;
+    int numGenerated = 0;
+    static const int COLOR_TYPES[5] = { 0, 2, 3, 4, 6 };
+    static const char* BLOCK_TYPES[4] = { "s", "f", "d", "sfd" };
+    for (int colorType : COLOR_TYPES) {
+        for (int hasTransparency = 0; hasTransparency < 2; hasTransparency++) {
+            if (hasTransparency && (colorType == 4 || colorType == 6)) {
+                continue;
+            }
+            for (int size = 1; size <= 67; size += 33) {
+                for (const char* blockTypes : BLOCK_TYPES) {
+                    char name[64];
+                    snprintf(name, sizeof(name), "type %d%s %dx%d %s",
+                        colorType, hasTransparency ? " tRNS" : "", size,
+                        size + 3, blockTypes);
+                    std::vector<unsigned char> png = MakePNG(size, size + 3,
+                        colorType, hasTransparency != 0,
+                        size * 31 + colorType, blockTypes);
+                    if (!Compare(name, png, true)) numMismatches++;
+                    numGenerated++;
+                }
+            }
+        }
+    }
+    // Rows far enough apart for distances near the 32 KB window
+    for (const char* blockTypes : BLOCK_TYPES) {
+        std::vector<unsigned char> png = MakePNG(203, 160, 6, false, 7,
+            blockTypes);
+        if (!Compare(std::string("type 6 203x160 ") + blockTypes, png,
+            true)) {
+            numMismatches++;
+        }
+        numGenerated++;
+    }
+    printf("Checked %d generated images: %d stored, %d fixed and %d dynamic "
+        "blocks\n", numGenerated, deflateStats.numBlocks[0],
+        deflateStats.numBlocks[1], deflateStats.numBlocks[2]);
+    printf("  Longest match %d, farthest %d, %d reaching an earlier block\n",
+        deflateStats.longestMatch, deflateStats.farthestMatch,
+        deflateStats.numCrossingMatches);
+
+    printf("Files, %d iterations\n", iterations);
+    double totalReference = 0.0, totalFast = 0.0;
+    double totalBytes = 0.0;
+    for (auto& file : files) {
+        std::vector<unsigned char> png;
+        if (!GangerEngine::IOManager::ReadFileToBuffer(file, png) ||
+            png.empty()) {
+            printf("  Could not read %s\n", file.c_str());
+            continue;
+        }
+        if (!Compare(file, png, false)) {
+            numMismatches++;
+            continue;
+        }
+
+        std::vector<unsigned char> pixels;
+        unsigned long width = 0, height = 0;
+        double referenceSeconds = Time(iterations, [&] {
+            GangerEngine::DecodePNG(pixels, width, height, &png[0],
+                png.size());
+        });
+        double fastSeconds = Time(iterations, [&] {
+            GangerEngine::DecodePNGFast(pixels, width, height, &png[0],
+                png.size());
+        });
+
+        double bytes = static_cast<double>(width) * height * 4 * iterations;
+        totalReference += referenceSeconds;
+        totalFast += fastSeconds;
+        totalBytes += bytes;
+        printf("  %-48s %5lux%-5lu PicoPNG %7.1f MB/s, fast %7.1f MB/s\n",
+            file.c_str(), width, height, bytes / referenceSeconds / 1e6,
+            bytes / fastSeconds / 1e6);
+    }
+
+    if (totalFast > 0.0) {
+        printf("Total: PicoPNG %.1f MB/s, fast %.1f MB/s, %.2fx\n",
+            totalBytes / totalReference / 1e6, totalBytes / totalFast / 1e6,
+            totalReference / totalFast);
+    }
+    if (numMismatches > 0) {
+        printf("%d mismatches\n", numMismatches);
+        return 1;
+    }
+    return 0;
+}